@@ -0,0 +1,192 @@
+#pragma once
+
+#include "perseus-arm-teleop.hpp"
+#include "poll-scheduler.hpp"
+#include "range-estimator.hpp"
+#include "sample-tracker.hpp"
+#include "servo-bus.hpp"
+#include "servo-data.hpp"
+#include <future>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Reads every joint of one arm once, updating current/min/max
+ *
+ * Joint i of arm_data is read from servo ID i + 1. A failed read leaves the
+ * previous values in place and stores the error message instead.
+ * @param reader Reader connected to the arm's bus
+ * @param arm_data Per-joint state to update
+ * @return false if the sweep was cut short because the port went away
+ */
+bool sampleArm(ST3215ServoReader &reader, std::vector<ServoData> &arm_data);
+
+using PendingReplies = std::vector<std::future<ST3215ServoReader::ServoReply>>;
+
+/**
+ * @brief Queues one register read per joint on a bus
+ *
+ * Requests from one call share a register block, so the bus answers them
+ * with a single SYNC_READ.
+ * @param bus Bus owning the arm's port
+ * @param joint_count Number of joints, read from servo IDs 1..joint_count
+ * @param address First register address
+ * @param size Number of bytes per joint
+ * @param priority Traffic class of the requests
+ */
+PendingReplies requestJoints(ServoBus &bus, size_t joint_count, uint8_t address, uint8_t size,
+                             BusPriority priority = BusPriority::CONTROL);
+
+/**
+ * @brief Queues one register read for each selected joint on a bus
+ *
+ * Unselected joints get an empty future, which applyPositions() and
+ * applyTemperatures() skip.
+ * @param bus Bus owning the arm's port
+ * @param selected One flag per joint; joint i is read from servo ID i + 1
+ * @param address First register address
+ * @param size Number of bytes per joint
+ * @param priority Traffic class of the requests
+ */
+PendingReplies requestJoints(ServoBus &bus, const std::vector<bool> &selected, uint8_t address, uint8_t size,
+                             BusPriority priority = BusPriority::CONTROL);
+
+/**
+ * @brief Waits for position replies and updates current/min/max or error
+ * @param replies Futures from requestJoints() for Present Position; empty futures are skipped
+ * @param arm_data Per-joint state to update
+ * @param cycle Arm cycle the replies belong to, stored as each fresh joint's sequence
+ * @param now Sample time for replies that carry no completion time of their own
+ */
+void applyPositions(PendingReplies &replies, std::vector<ServoData> &arm_data, uint64_t cycle = 0,
+                    Clock::time_point now = Clock::time_point());
+
+/**
+ * @brief Applies any temperature replies that have arrived, without waiting
+ * @param replies Futures from requestJoints() for Present Temperature;
+ *        consumed entries are left invalid
+ * @param arm_data Per-joint state to update
+ * @return true once every reply has been consumed
+ */
+bool applyTemperatures(PendingReplies &replies, std::vector<ServoData> &arm_data);
+
+/**
+ * @brief Records a fresh position reading in a joint's state
+ * @param servo Joint state to update
+ * @param position Position read
+ * @param sequence Arm cycle of the reading
+ * @param sampled When the reading completed
+ */
+void updatePosition(ServoData &servo, uint16_t position, uint64_t sequence = 0,
+                    Clock::time_point sampled = Clock::time_point());
+
+/**
+ * @brief Feeds the joints refreshed in a new arm cycle to their range estimators
+ * @param ranges One estimator per joint
+ * @param arm_data Per-joint state of the arm
+ * @param cycle Newest arm cycle; joints holding an older reading are skipped
+ * @param last_cycle Cycle fed last time; nothing is fed again for the same cycle
+ */
+void observeRanges(std::vector<RangeEstimator> &ranges, const std::vector<ServoData> &arm_data, uint64_t cycle,
+                   uint64_t &last_cycle);
+
+/**
+ * @brief Turns torque back on for every joint of an arm after an emergency stop
+ *
+ * Each joint's Goal Position is first set to its Present Position, so the
+ * arm holds where it went limp instead of jumping to the goal it had before
+ * the stop. A joint whose position cannot be read keeps torque off. Both
+ * steps go out as one SYNC_WRITE each.
+ * @param bus Bus owning the arm's port
+ * @param joint_count Number of joints, servo IDs 1..joint_count
+ * @return Number of joints with torque enabled again
+ */
+size_t enableTorque(ServoBus &bus, size_t joint_count);
+
+/**
+ * @brief Polls one arm's positions every cycle and its temperatures now and then
+ *
+ * Split into request() and collect() so the reads of several arms can be
+ * queued before waiting on any of them.
+ */
+class ArmPoller
+{
+public:
+    /**
+     * @brief Binds the poller to a bus and the state it keeps up to date
+     * @param bus Bus owning the arm's port
+     * @param arm_data Per-joint state to update; must outlive the poller
+     * @param diagnostic_interval Cycles between temperature polls
+     * @param clock Clock samples are stamped with
+     * @param scheduler Picks the joints read each cycle; null reads every joint every cycle
+     */
+    ArmPoller(ServoBus &bus, std::vector<ServoData> &arm_data, size_t diagnostic_interval = 10,
+              Clock &clock = Clock::system(), PollScheduler *scheduler = nullptr);
+
+    /**
+     * @brief Queues this cycle's position reads, plus temperatures when due
+     */
+    void request();
+
+    /**
+     * @brief Waits for the positions and applies any temperatures that have arrived
+     *
+     * Completes an arm cycle: joints read successfully get the new cycle
+     * number as their sequence, failed or unscheduled joints keep their old one.
+     */
+    void collect();
+
+    /**
+     * @brief Number of completed arm cycles, the sequence of the newest samples
+     */
+    uint64_t cycle() const;
+
+private:
+    ServoBus &_bus;
+    std::vector<ServoData> &_arm_data;
+    size_t _diagnostic_interval;
+    Clock &_clock;
+    PollScheduler *_scheduler;
+    uint64_t _cycle;
+    PendingReplies _positions;
+    PendingReplies _temperatures;
+};
+
+/**
+ * @brief Formats an arm's joint temperatures as one status line
+ * @param arm_number 1-based arm number shown in the line
+ * @param arm_data Per-joint state of the arm
+ */
+std::string formatTemperatureLine(int arm_number, const std::vector<ServoData> &arm_data);
+
+/**
+ * @brief Formats an arm's sample accounting as one status line
+ *
+ * Shows the arm cycle, the effective sample rate seen by this consumer, the
+ * cycles it missed and how many joints hold a reading from an older cycle.
+ * @param arm_number 1-based arm number shown in the line
+ * @param cycle Newest arm cycle available to the consumer
+ * @param tracker Tracker fed with the arm cycles this consumer has seen
+ * @param arm_data Per-joint state of the arm
+ * @param now Current time on the clock the samples were stamped with
+ */
+std::string formatSampleLine(int arm_number, uint64_t cycle, const SampleTracker &tracker,
+                             const std::vector<ServoData> &arm_data, Clock::time_point now);
+
+/**
+ * @brief Formats the --rt status line with each bus thread's steady-state faults
+ * @param config Real-time settings in effect
+ * @param buses Buses in arm order
+ */
+std::string formatRealtimeLine(const RealtimeConfig &config, const std::vector<const ServoBus *> &buses);
+
+/**
+ * @brief Prints each bus thread's steady-state page faults at exit
+ *
+ * Any fault once a bus thread has warmed up means --rt did not keep it
+ * resident, which is reported on stderr as an error.
+ * @param config Real-time settings in effect; nothing is reported unless enabled
+ * @param buses Buses in arm order
+ * @return true if any bus thread faulted in steady state
+ */
+bool reportSteadyStateFaults(const RealtimeConfig &config, const std::vector<const ServoBus *> &buses);
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "clock.hpp"
+#include "hotplug-monitor.hpp"
+#include "perseus-arm-teleop.hpp"
+#include "servo-data.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Serial connection to one arm that survives USB disconnects
+ *
+ * When the port is hung up the link stops issuing reads and a background
+ * thread waits for the same adapter (matched by USB serial, or by path when
+ * the device has none) to reappear. The port is then reopened and
+ * reconfigured off the sampling thread and swapped in between sweeps.
+ */
+class ArmLink
+{
+public:
+    /**
+     * @brief Opens the port and starts the reconnect thread
+     * @param port Serial port path
+     * @param baud_rate Baud rate for serial communication
+     * @param clock Clock used by the reader and for recovery timing
+     * @param monitor Optional hot-plug monitor to wake reconnects early
+     * @throws std::runtime_error if the port cannot be opened initially
+     */
+    ArmLink(const std::string& port, unsigned int baud_rate,
+            Clock& clock = Clock::system(), HotplugMonitor* monitor = nullptr);
+
+    /**
+     * @brief Stops the reconnect thread and closes the port
+     */
+    ~ArmLink();
+
+    ArmLink(const ArmLink&) = delete;
+    ArmLink& operator=(const ArmLink&) = delete;
+
+    /**
+     * @brief Reads every joint once, like sampleArm(), while connected
+     *
+     * Returns immediately with a disconnect error on each joint while the
+     * adapter is missing.
+     * @param arm_data Per-joint state to update
+     */
+    void sample(std::vector<ServoData>& arm_data);
+
+    /**
+     * @brief Performs ST3215ServoReader::syncRead() while connected
+     *
+     * Never throws for link problems: while the adapter is missing, or if it
+     * disappears during the call, every reply carries an error instead.
+     * @throws EmergencyStopError if an emergency stop cancels the transaction
+     */
+    std::vector<ST3215ServoReader::ServoReply> syncRead(const std::vector<uint8_t>& servo_ids,
+                                                        uint8_t address, uint8_t size);
+
+    /**
+     * @brief syncRead() into a caller-owned vector, reusing its replies' storage
+     * @throws EmergencyStopError if an emergency stop cancels the transaction
+     */
+    void syncRead(const std::vector<uint8_t>& servo_ids, uint8_t address, uint8_t size,
+                  std::vector<ST3215ServoReader::ServoReply>& replies);
+
+    /**
+     * @brief Performs ST3215ServoReader::syncWrite() while connected
+     * @return Empty on success, otherwise why the write did not go out
+     * @throws EmergencyStopError if an emergency stop refuses the transaction
+     */
+    std::string syncWrite(const std::vector<uint8_t>& servo_ids, uint8_t address, uint8_t size,
+                          const std::vector<uint8_t>& data);
+
+    /**
+     * @brief Returns true while the port is open and responsive
+     */
+    bool connected() const;
+
+    /**
+     * @brief One line summary of link state and last recovery time
+     */
+    std::string statusText() const;
+
+    /**
+     * @brief Time from the adapter reappearing to the first good sweep
+     * @return Duration of the most recent recovery, zero if none yet
+     */
+    Clock::duration lastRecoveryTime() const;
+
+private:
+    void _markDisconnected();
+    void _reconnectLoop();
+
+    std::string _port;
+    std::string _usb_serial;
+    unsigned int _baud_rate;
+    Clock& _clock;
+    HotplugMonitor* _monitor;
+    size_t _subscription;
+
+    std::unique_ptr<ST3215ServoReader> _reader;
+    mutable std::mutex _mutex;
+    std::condition_variable _wake;
+    std::atomic<bool> _connected;
+    bool _device_event = false;
+    bool _stopping = false;
+    bool _awaiting_first_sample = false;
+    Clock::time_point _device_seen_at;
+    Clock::duration _last_recovery{0};
+    unsigned int _reconnects = 0;
+    std::thread _thread;
+};
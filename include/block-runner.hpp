@@ -0,0 +1,168 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Per-worker bump allocator for temporary buffers
+ *
+ * A task takes whatever scratch memory it needs from its worker's arena and
+ * the runner resets the arena before the next task, so a scan over thousands
+ * of blocks does not touch the heap once the arena has grown to the largest
+ * task's needs. Memory is only valid until the task returns.
+ */
+class ScratchArena
+{
+public:
+    static constexpr size_t DEFAULT_CHUNK_BYTES = 1 << 20;
+
+    ScratchArena() = default;
+
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    /**
+     * @brief Returns uninitialised memory
+     * @param bytes Size of the allocation
+     * @param alignment Power of two alignment
+     */
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+    /**
+     * @brief Returns an uninitialised array of count trivially destructible Ts
+     */
+    template <typename T>
+    T* allocateArray(size_t count)
+    {
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    /**
+     * @brief Releases every allocation while keeping the memory for reuse
+     */
+    void reset();
+
+    size_t capacity() const;   // Bytes held across all chunks
+
+private:
+    struct Chunk
+    {
+        std::unique_ptr<unsigned char[]> data;
+        size_t size;
+    };
+
+    std::vector<Chunk> _chunks;
+    size_t _chunk = 0;   // Chunk currently being carved
+    size_t _used = 0;    // Bytes used in that chunk
+};
+
+/**
+ * @brief Runs one task per block on a pool of workers and merges the results in block order
+ *
+ * Each worker starts with a contiguous share of the blocks, so workers on
+ * a recording read it sequentially, and takes them from the front. A
+ * worker that runs out steals from the back of the busiest-looking other
+ * share, so uneven blocks (a stalled disk, a dense session) balance out
+ * without any central queue. A share is a single 64-bit word updated with
+ * compare-exchange by its owner and by thieves alike.
+ *
+ * Results are kept per block and merged strictly in block order after all
+ * tasks finish, so the outcome does not depend on scheduling or thread
+ * count even when the merge is not commutative.
+ */
+class BlockRunner
+{
+public:
+    struct Stats
+    {
+        size_t workers = 0;
+        size_t blocks = 0;
+        uint64_t steals = 0;              // Blocks run by a worker other than their initial owner
+        std::vector<size_t> per_worker;   // Blocks each worker ran
+    };
+
+    /**
+     * @brief Creates a runner
+     * @param threads Workers to use; 0 for one per core
+     */
+    explicit BlockRunner(size_t threads = 0);
+
+    /**
+     * @brief Processes blocks [0, block_count) and merges the results
+     * @param block_count Number of blocks
+     * @param initial Value the block results are merged into
+     * @param process Called as process(block, arena) from a worker; returns the block's result
+     * @param merge Called as merge(Result& total, BlockResult&& block) in block order on the calling thread
+     * @return The merged result
+     */
+    template <typename Result, typename Process, typename Merge>
+    Result run(size_t block_count, Result initial, Process process, Merge merge)
+    {
+        using BlockResult = decltype(process(size_t(), std::declval<ScratchArena&>()));
+        std::vector<std::optional<BlockResult>> results(block_count);
+        _run(block_count, [&](size_t block, ScratchArena& arena) { results[block].emplace(process(block, arena)); });
+        for (auto& result : results)
+        {
+            merge(initial, std::move(*result));
+        }
+        return initial;
+    }
+
+    /**
+     * @brief Scheduling statistics of the last run()
+     */
+    const Stats& stats() const;
+
+    size_t threads() const;
+
+private:
+    /**
+     * @brief Block range [begin, end) owned by one worker, packed so it can be updated atomically
+     */
+    struct alignas(64) Share
+    {
+        std::atomic<uint64_t> range{0};
+    };
+
+    class Task
+    {
+    public:
+        virtual ~Task() = default;
+        virtual void operator()(size_t block, ScratchArena& arena) = 0;
+    };
+
+    template <typename F>
+    class TaskFunction : public Task
+    {
+    public:
+        explicit TaskFunction(F& f) : _f(f) {}
+        void operator()(size_t block, ScratchArena& arena) override { _f(block, arena); }
+
+    private:
+        F& _f;
+    };
+
+    template <typename F>
+    void _run(size_t block_count, F f)
+    {
+        TaskFunction<F> task(f);
+        _execute(block_count, task);
+    }
+
+    void _execute(size_t block_count, Task& task);
+    void _work(size_t worker, Task& task);
+    bool _takeOwn(size_t worker, size_t& block);
+    bool _steal(size_t thief, size_t& block);
+
+    size_t _threads;
+    std::vector<Share> _shares;
+    std::vector<ScratchArena> _arenas;
+    std::vector<std::atomic<uint64_t>> _steals;
+    Stats _stats;
+};
@@ -0,0 +1,160 @@
+#pragma once
+
+#include "range-estimator.hpp"
+#include "servo-data.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Calibrated range of one joint
+ */
+struct JointCalibration
+{
+    uint16_t min = 0;
+    uint16_t max = 4095;
+    bool valid = false;  // False if the joint was never swept far enough to map
+};
+
+/**
+ * @brief Joint ranges of both arms as loaded from one calibration file
+ */
+struct CalibrationTable
+{
+    std::string path;
+    std::string timestamp;
+    std::vector<std::string> ports;
+    std::vector<std::vector<JointCalibration>> arms;
+
+    /**
+     * @brief Range of one joint; an invalid range if the table does not cover it
+     */
+    JointCalibration joint(size_t arm, size_t joint) const;
+};
+
+/**
+ * @brief Returns true for names written by exportCalibrationData()
+ */
+bool isCalibrationFileName(const std::string& name);
+
+/**
+ * @brief Local time formatted the way calibration files are stamped and named
+ */
+std::string calibrationTimestamp();
+
+/**
+ * @brief Name of the calibration file for a timestamp, e.g. "<timestamp>_perseus_arm_calibration.yaml"
+ */
+std::string calibrationFileName(const std::string& timestamp);
+
+/**
+ * @brief Writes a calibration file in the schema loadCalibrationFile() reads
+ *
+ * Each joint gets the raw min/max of its ServoData and, where its estimator
+ * has accepted readings, the robust bounds and sample counts.
+ * @param path File to write
+ * @param timestamp Value of the timestamp field
+ * @param ports Port of each arm
+ * @param arms Per-joint raw ranges of each arm
+ * @param ranges Per-joint estimators of each arm; may be shorter than arms
+ * @throws std::runtime_error if the file cannot be written
+ */
+void writeCalibrationFile(const std::string& path, const std::string& timestamp,
+                          const std::vector<std::string>& ports,
+                          const std::vector<const std::vector<ServoData>*>& arms,
+                          const std::vector<const std::vector<RangeEstimator>*>& ranges);
+
+/**
+ * @brief Finds the newest calibration file in a directory
+ * @return Full path, or an empty string if there is none
+ */
+std::string newestCalibrationFile(const std::string& directory);
+
+/**
+ * @brief Parses and validates a calibration file
+ *
+ * The robust bounds are used where the file has them, the raw min/max
+ * otherwise. Joints whose range is too narrow to map are kept but marked
+ * invalid.
+ * @param path File to load
+ * @return The parsed table
+ * @throws std::runtime_error if the file cannot be parsed, is missing an arm
+ *         or has out-of-range values
+ */
+CalibrationTable loadCalibrationFile(const std::string& path);
+
+/**
+ * @brief Maps a position linearly from one joint range onto another
+ * @param position Position within from's range
+ * @param from Range position is measured in
+ * @param to Range to map into
+ * @return Mapped position, clamped to to's range; position unchanged if either range is invalid
+ */
+uint16_t mapJointPosition(uint16_t position, const JointCalibration& from, const JointCalibration& to);
+
+/**
+ * @brief Keeps the newest calibration of a directory loaded, reloading on change
+ *
+ * The directory is watched with inotify; files written or moved into it are
+ * parsed and validated on the watcher's own thread, and a valid one replaces
+ * the active table with a single pointer swap. Readers take the table once
+ * per control cycle with current() and keep using that snapshot for the
+ * whole cycle, so a reload never blocks or tears a cycle; the old table is
+ * freed when its last reader lets go. Invalid files are counted and ignored,
+ * and so is a file older by name than the active one, the same rule
+ * newestCalibrationFile() applies at startup.
+ */
+class CalibrationWatcher
+{
+public:
+    /**
+     * @brief Loads the newest calibration in the directory and starts watching it
+     * @param directory Directory calibration files are saved to
+     */
+    explicit CalibrationWatcher(const std::string& directory);
+
+    /**
+     * @brief Stops the watcher thread
+     */
+    ~CalibrationWatcher();
+
+    CalibrationWatcher(const CalibrationWatcher&) = delete;
+    CalibrationWatcher& operator=(const CalibrationWatcher&) = delete;
+
+    /**
+     * @brief Active table, or nullptr until a valid file has been loaded
+     */
+    std::shared_ptr<const CalibrationTable> current() const;
+
+    /**
+     * @brief Returns true if the inotify watch was established
+     */
+    bool active() const;
+
+    uint64_t reloads() const;    // Tables installed, the initial one included
+    uint64_t rejected() const;   // Files that failed to load
+
+    /**
+     * @brief Why the most recently rejected file failed, empty if none has
+     */
+    std::string lastError() const;
+
+private:
+    void _run();
+    void _load(const std::string& path);
+
+    std::string _directory;
+    int _inotify_fd;
+    int _wake_fd;
+    std::shared_ptr<const CalibrationTable> _current;  // Only accessed through std::atomic_load/store
+    std::atomic<uint64_t> _reloads;
+    std::atomic<uint64_t> _rejected;
+    mutable std::mutex _error_mutex;
+    std::string _last_error;
+    std::atomic<bool> _running;
+    std::thread _thread;
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Source of time and sleeping for the reader, main loop and simulator
+ *
+ * All timing goes through a Clock so that simulated sessions can run on a
+ * VirtualClock instead of wall-clock time.
+ */
+class Clock
+{
+public:
+    using duration = std::chrono::steady_clock::duration;
+    using time_point = std::chrono::steady_clock::time_point;
+
+    virtual ~Clock() = default;
+
+    /**
+     * @brief Current time on this clock
+     */
+    virtual time_point now() const = 0;
+
+    /**
+     * @brief Blocks the caller for the given duration of this clock's time
+     */
+    virtual void sleepFor(duration d) = 0;
+
+    /**
+     * @brief Sleeps like sleepFor() but returns early once wake_fd is readable
+     * @param d Duration to sleep
+     * @param wake_fd File descriptor that cuts the sleep short, or -1
+     * @return false if the sleep was cut short by wake_fd
+     */
+    virtual bool sleepFor(duration d, int wake_fd) = 0;
+
+    /**
+     * @brief Process-wide clock backed by std::chrono::steady_clock
+     */
+    static Clock& system();
+};
+
+/**
+ * @brief Clock backed by std::chrono::steady_clock and std::this_thread::sleep_for
+ */
+class SystemClock : public Clock
+{
+public:
+    time_point now() const override;
+    void sleepFor(duration d) override;
+    bool sleepFor(duration d, int wake_fd) override;
+};
+
+/**
+ * @brief Deterministic clock whose time only moves when someone sleeps
+ *
+ * sleepFor() returns immediately after advancing the clock. Before advancing
+ * it waits until every registered idle probe reports quiescence, so a
+ * simulator thread always answers an outstanding request at the virtual time
+ * it was issued. Intended for a single thread driving time forward.
+ */
+class VirtualClock : public Clock
+{
+public:
+    /**
+     * @brief Creates a clock starting at the given virtual time
+     */
+    explicit VirtualClock(time_point start = time_point());
+
+    time_point now() const override;
+    void sleepFor(duration d) override;
+
+    /**
+     * @brief Advances like sleepFor(); wake_fd is ignored since virtual
+     *        sleeps complete instantly
+     */
+    bool sleepFor(duration d, int wake_fd) override;
+
+    /**
+     * @brief Registers a check that must return true before time may advance
+     * @return Handle to pass to removeIdleProbe()
+     */
+    size_t addIdleProbe(std::function<bool()> probe);
+
+    /**
+     * @brief Unregisters a probe added with addIdleProbe()
+     */
+    void removeIdleProbe(size_t handle);
+
+private:
+    void _waitIdle();
+
+    std::atomic<duration::rep> _now;
+    std::mutex _probe_mutex;
+    std::vector<std::pair<size_t, std::function<bool()>>> _probes;
+    size_t _next_probe = 0;
+};
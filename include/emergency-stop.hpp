@@ -0,0 +1,98 @@
+#pragma once
+
+#include "clock.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+
+/**
+ * @brief Thrown by servo transactions aborted or refused by an emergency stop
+ */
+class EmergencyStopError : public std::runtime_error
+{
+public:
+    EmergencyStopError() : std::runtime_error("Emergency stop active") {}
+};
+
+/**
+ * @brief Process-wide emergency stop shared by every open servo port
+ *
+ * trigger() is async-signal-safe and never blocks: it broadcasts a
+ * torque-disable packet directly on every registered (non-blocking) port fd
+ * and wakes any transaction waiting for a reply. The stop stays latched until
+ * reset(), and while latched no new transactions are started.
+ */
+class EmergencyStop
+{
+public:
+    static const size_t MAX_PORTS = 32;
+
+    /**
+     * @brief The single process-wide instance
+     */
+    static EmergencyStop& instance();
+
+    /**
+     * @brief Adds a port fd to the broadcast list
+     * @return Slot to pass to unregisterPort(), or -1 if the list is full
+     */
+    int registerPort(int fd);
+
+    /**
+     * @brief Removes a port before its fd is closed
+     *
+     * Returns only once no trigger() that could still hold the old fd is
+     * broadcasting, so the caller may close it right away without the
+     * packet landing on whatever reuses the descriptor number.
+     */
+    void unregisterPort(int slot);
+
+    /**
+     * @brief Broadcasts torque-disable on every port and cancels waiting reads
+     *
+     * Safe to call from any thread or from a signal handler.
+     */
+    void trigger() noexcept;
+
+    /**
+     * @brief Clears the latch so transactions may run again
+     */
+    void reset();
+
+    /**
+     * @brief Returns true while the stop is latched
+     */
+    bool triggered() const;
+
+    /**
+     * @brief Increments on every trigger(); lets a transaction detect a stop
+     *        that happened while it was in flight
+     */
+    uint64_t generation() const;
+
+    /**
+     * @brief eventfd that becomes readable when the stop is triggered
+     */
+    int cancelFd() const;
+
+    /**
+     * @brief Steady clock time of the most recent trigger()
+     */
+    Clock::time_point lastTriggerTime() const;
+
+    /**
+     * @brief WRITE of 0 to Torque Enable (0x28) addressed to the broadcast ID
+     */
+    static const std::array<uint8_t, 8>& torqueDisablePacket();
+
+private:
+    EmergencyStop();
+
+    std::array<std::atomic<int>, MAX_PORTS> _ports;
+    std::atomic<int> _broadcasting;    // trigger() calls between their first and last port load
+    std::atomic<bool> _triggered;
+    std::atomic<uint64_t> _generation;
+    std::atomic<Clock::duration::rep> _trigger_time;
+    int _cancel_fd;
+};
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "arm-link.hpp"
+#include "clock.hpp"
+#include "hotplug-monitor.hpp"
+#include "sample-tracker.hpp"
+#include "servo-data.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Samples any number of arms from a fixed pool of worker threads
+ *
+ * Arms are dealt out to the workers round robin. Each worker reads its arms'
+ * positions with one SYNC_READ per arm every period, temperatures every
+ * temperature_interval cycles, and keeps per-arm rate, error rate and
+ * transaction latency up to date. After every pass a worker also folds its
+ * arms into one set of totals, so the fleet-wide summary costs the reader
+ * one lock per worker and a row costs one lock per arm shown: watching the
+ * fleet never touches arms that are not on screen.
+ */
+class FleetMonitor
+{
+public:
+    struct Config
+    {
+        size_t workers = 4;
+        Clock::duration period = std::chrono::milliseconds(20);
+        size_t temperature_interval = 10;   // Position cycles between temperature reads
+        size_t joints = 6;
+    };
+
+    /**
+     * @brief State of one arm as shown in a summary row
+     */
+    struct ArmSummary
+    {
+        std::string port;
+        std::string link;          // ArmLink status text
+        bool connected = false;
+        uint64_t cycles = 0;
+        double rate_hz = 0.0;
+        double error_percent = 0.0;   // Smoothed share of joint reads that failed
+        double latency_ms = 0.0;      // Smoothed SYNC_READ round trip
+        int temperature = -1;         // Hottest joint, -1 until read
+    };
+
+    /**
+     * @brief Totals over every arm, as of each worker's latest pass
+     */
+    struct Totals
+    {
+        size_t arms = 0;
+        size_t connected = 0;
+        size_t failing = 0;           // Arms with any joint read failing recently
+        double rate_hz = 0.0;         // Summed over arms
+        double error_percent = 0.0;   // Averaged over arms
+        double worst_latency_ms = 0.0;
+        int hottest = -1;
+    };
+
+    /**
+     * @brief Opens every port and starts the workers
+     * @param ports Serial port paths, one arm each
+     * @param config Pool size and timing
+     * @param clock Clock used for scheduling and by the links
+     * @param monitor Optional hot-plug monitor shared by the links
+     * @throws std::runtime_error if a port cannot be opened
+     */
+    FleetMonitor(const std::vector<std::string> &ports, const Config &config, Clock &clock = Clock::system(),
+                 HotplugMonitor *monitor = nullptr);
+
+    /**
+     * @brief Stops the workers and closes the ports
+     */
+    ~FleetMonitor();
+
+    FleetMonitor(const FleetMonitor &) = delete;
+    FleetMonitor &operator=(const FleetMonitor &) = delete;
+
+    size_t arms() const;
+    size_t workers() const;
+
+    /**
+     * @brief Current summary row of one arm
+     */
+    ArmSummary summary(size_t arm) const;
+
+    /**
+     * @brief Copies an arm's per-joint state, for the per-joint view
+     */
+    void joints(size_t arm, std::vector<ServoData> &out) const;
+
+    /**
+     * @brief Fleet-wide totals; costs one lock per worker, however many arms
+     */
+    Totals totals() const;
+
+private:
+    struct Arm
+    {
+        explicit Arm(const std::string &port, Clock &clock, HotplugMonitor *monitor);
+
+        ArmLink link;
+        mutable std::mutex mutex;     // Guards everything below
+        std::vector<ServoData> joints;
+        ArmSummary summary;
+        SampleTracker tracker;
+    };
+
+    struct Worker
+    {
+        std::vector<size_t> arms;
+        mutable std::mutex mutex;     // Guards totals
+        Totals totals;
+        std::thread thread;
+    };
+
+    void _work(Worker &worker);
+    void _sample(Arm &arm, uint64_t cycle);
+
+    Config _config;
+    Clock &_clock;
+    std::vector<uint8_t> _ids;     // Servo IDs of an arm's joints
+    std::vector<std::unique_ptr<Arm>> _arms;
+    std::vector<std::unique_ptr<Worker>> _workers;
+    std::atomic<bool> _running;
+};
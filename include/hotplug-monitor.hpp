@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Watches /dev with inotify and reports serial adapters appearing
+ *
+ * Callbacks run on the monitor's own thread and must not block for long.
+ * If inotify is unavailable the monitor stays silent and users are expected
+ * to fall back to periodic rescans.
+ */
+class HotplugMonitor
+{
+public:
+    using Callback = std::function<void(const std::string& device_path)>;
+
+    /**
+     * @brief Starts watching the given device directory
+     * @param dev_dir Directory holding device nodes
+     */
+    explicit HotplugMonitor(const std::string& dev_dir = "/dev");
+
+    /**
+     * @brief Stops the watcher thread
+     */
+    ~HotplugMonitor();
+
+    HotplugMonitor(const HotplugMonitor&) = delete;
+    HotplugMonitor& operator=(const HotplugMonitor&) = delete;
+
+    /**
+     * @brief Returns true if the inotify watch was established
+     */
+    bool active() const;
+
+    /**
+     * @brief Registers a callback for created or re-permissioned tty nodes
+     * @return Handle to pass to unsubscribe()
+     */
+    size_t subscribe(Callback callback);
+
+    /**
+     * @brief Removes a callback added with subscribe()
+     */
+    void unsubscribe(size_t handle);
+
+private:
+    void _run();
+
+    std::string _dev_dir;
+    int _inotify_fd;
+    int _wake_fd;
+    std::mutex _mutex;
+    std::vector<std::pair<size_t, Callback>> _callbacks;
+    size_t _next_handle = 0;
+    std::atomic<bool> _running;
+    std::thread _thread;
+};
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "clock.hpp"
+#include "servo-bus.hpp"
+#include "servo-data.hpp"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Decides when nobody is moving the arms, so acquisition can slow down
+ *
+ * Each joint keeps an anchor position. A fresh reading further than the
+ * deadband from the anchor counts as motion and becomes the new anchor, so
+ * sensor noise never counts as motion while a slow drift does once it adds
+ * up. The arms are idle once no joint has moved for idle_after.
+ */
+class IdleDetector
+{
+public:
+    struct Config
+    {
+        uint16_t deadband = 8;                               // Position ticks a joint must move to count
+        Clock::duration idle_after = std::chrono::seconds(10);
+    };
+
+    /**
+     * @brief Creates a detector that starts out active
+     * @param config Deadband and idle timeout
+     */
+    explicit IdleDetector(const Config &config);
+
+    /**
+     * @brief Checks the arms' newest readings for motion
+     * @param arms Per-joint state of each arm
+     * @param cycles Newest cycle of each arm; joints with an older reading are skipped
+     * @param now Current time
+     * @return true if any joint moved
+     */
+    bool observe(const std::vector<const std::vector<ServoData> *> &arms, const std::vector<uint64_t> &cycles,
+                 Clock::time_point now);
+
+    /**
+     * @brief Returns true once nothing has moved for the idle timeout
+     */
+    bool idle(Clock::time_point now) const;
+
+private:
+    struct Anchor
+    {
+        bool set = false;
+        uint16_t position = 0;
+    };
+
+    Config _config;
+    std::vector<std::vector<Anchor>> _anchors;
+    Clock::time_point _last_motion;
+    bool _started;
+};
+
+/**
+ * @brief Measures process CPU and bus utilisation separately while active and while idle
+ *
+ * Each call to sample() charges the CPU time, bus busy time and wall time
+ * since the previous call to the state given in that previous call.
+ */
+class UsageMeter
+{
+public:
+    UsageMeter();
+
+    /**
+     * @brief Charges the time since the last sample and starts a new interval
+     * @param idle State the acquisition is in from now on
+     * @param buses Buses whose busy time is measured
+     */
+    void sample(bool idle, const std::vector<const ServoBus *> &buses);
+
+    /**
+     * @brief Process CPU use in a state, as a percentage of one core
+     * @return 0 until time has been spent in the state
+     */
+    double cpuPercent(bool idle) const;
+
+    /**
+     * @brief Bus utilisation in a state, averaged over the buses, in percent
+     */
+    double busPercent(bool idle) const;
+
+    /**
+     * @brief Wall time spent in a state, in seconds
+     */
+    double seconds(bool idle) const;
+
+private:
+    struct Totals
+    {
+        double wall_s = 0.0;
+        double cpu_s = 0.0;
+        double bus_s = 0.0;   // Summed over buses
+    };
+
+    Totals _totals[2];   // Indexed by idle
+    bool _idle;
+    size_t _bus_count;
+    std::chrono::steady_clock::time_point _last_wall;
+    double _last_cpu_s;
+    double _last_bus_s;
+};
+
+/**
+ * @brief Formats the acquisition power state and the usage measured in each state
+ * @param idle Whether acquisition is in the slow keep-alive mode
+ * @param keep_alive Poll period used while idle
+ * @param meter Usage measured so far
+ */
+std::string formatPowerLine(bool idle, std::chrono::milliseconds keep_alive, const UsageMeter &meter);
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "clock.hpp"
+#include "servo-data.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Recent motion of one joint as a ring of min/max envelopes, one per time bucket
+ *
+ * Time is cut into fixed buckets and the ring holds the newest few of them.
+ * A reading only widens the envelope of the bucket it was sampled in, and
+ * moving into a new bucket clears the ones that fell off the end, so adding
+ * costs the same however often the history is drawn. Keeping the extremes
+ * rather than an average means a single-reading glitch or an oscillation
+ * faster than the bucket still shows up as a tall column.
+ */
+class JointHistory
+{
+public:
+    struct Envelope
+    {
+        bool set = false;   // false if no reading fell in the bucket
+        uint16_t low = 0;
+        uint16_t high = 0;
+    };
+
+    /**
+     * @brief Creates an empty history
+     * @param columns Buckets kept, the width of the sparkline
+     * @param bucket Time covered by each bucket
+     */
+    explicit JointHistory(size_t columns = 20, Clock::duration bucket = std::chrono::milliseconds(250));
+
+    /**
+     * @brief Adds a joint's reading if it is one not seen before; O(1)
+     *
+     * Readings are told apart by their sequence, so the same state can be
+     * offered every frame. Joints never read successfully are skipped.
+     */
+    void observe(const ServoData &servo);
+
+    /**
+     * @brief Adds one reading to the bucket it was sampled in
+     *
+     * Readings older than the oldest bucket kept are dropped.
+     */
+    void add(uint16_t position, Clock::time_point sampled);
+
+    /**
+     * @brief Envelope of a bucket counted back from the one holding now
+     * @param age 0 for the bucket holding now, columns() - 1 for the oldest shown
+     * @param now Current time, so a joint that stopped reporting shows gaps
+     */
+    Envelope envelope(size_t age, Clock::time_point now) const;
+
+    size_t columns() const;
+    Clock::duration bucket() const;
+
+private:
+    int64_t _bucketOf(Clock::time_point time) const;
+
+    std::vector<Envelope> _ring;
+    Clock::duration _bucket;
+    int64_t _newest;          // Bucket number of the newest reading
+    uint64_t _sequence;       // Sequence of the last reading observed
+};
+
+/**
+ * @brief Feeds the joints' new readings to their histories
+ * @param histories One history per joint
+ * @param arm_data Per-joint state of the arm
+ */
+void observeHistories(std::vector<JointHistory> &histories, const std::vector<ServoData> &arm_data);
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "clock.hpp"
+#include "servo-data.hpp"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Every joint of every arm at one common instant
+ *
+ * Joints are ServoData so aligned snapshots can go anywhere live arm state
+ * goes; a joint that could not be aligned carries an error instead.
+ */
+struct AlignedSnapshot
+{
+    Clock::time_point time{};
+    std::vector<std::vector<ServoData>> arms;
+};
+
+/**
+ * @brief Aligns joint readings taken at different times onto a common time grid
+ *
+ * A sweep reads the joints one after another, so joint 1 of one arm and the
+ * last joint of another can be tens of milliseconds apart. The resampler
+ * keeps a short history of timestamped readings per joint and linearly
+ * interpolates all of them at the same instants, spaced grid_period apart
+ * from the first instant every joint had been read by.
+ *
+ * Grid points are only released once every live joint has a reading at or
+ * after them, so nothing is extrapolated. A joint that has never been read,
+ * or whose newest reading falls more than stale_after behind the others, is
+ * left out of that wait and reported with an error until it reads again.
+ */
+class JointResampler
+{
+public:
+    /**
+     * @brief Creates a resampler
+     * @param arm_count Number of arms fed through observe()
+     * @param joint_count Joints per arm
+     * @param grid_period Spacing of the output grid
+     * @param stale_after Lag behind the newest joint at which a joint is given up on
+     * @param history Readings kept per joint; must cover stale_after plus one sweep
+     */
+    JointResampler(size_t arm_count, size_t joint_count, Clock::duration grid_period,
+                   Clock::duration stale_after, size_t history = 16);
+
+    /**
+     * @brief Adds the readings of one arm that are newer than those already held
+     * @param arm Arm index
+     * @param arm_data Per-joint state; joints whose sequence has not changed are skipped
+     */
+    void observe(size_t arm, const std::vector<ServoData>& arm_data);
+
+    /**
+     * @brief Latest instant every live joint can be interpolated at
+     * @return Default time_point until some joint has been read
+     */
+    Clock::time_point alignedUntil() const;
+
+    /**
+     * @brief Interpolates every joint at an arbitrary instant
+     *
+     * Instants outside a joint's history hold its nearest reading.
+     * @param time Instant to align at
+     * @param snapshot Filled in with one ServoData per joint
+     * @return false if no joint has been read yet
+     */
+    bool sample(Clock::time_point time, AlignedSnapshot& snapshot) const;
+
+    /**
+     * @brief Releases the next grid point that every live joint has reached
+     *
+     * Call repeatedly after observe() until it returns false. A consumer
+     * that falls behind the held history resumes at the newest grid point.
+     * @param snapshot Filled in when a grid point is released
+     * @return false if the next grid point is not covered yet
+     */
+    bool next(AlignedSnapshot& snapshot);
+
+    /**
+     * @brief Spread between the earliest and latest newest reading across live joints
+     */
+    Clock::duration skew() const;
+
+    /**
+     * @brief Grid points dropped because the consumer fell behind the history
+     */
+    uint64_t skipped() const;
+
+private:
+    struct Reading
+    {
+        Clock::time_point time;
+        uint16_t position;
+    };
+
+    struct JointHistory
+    {
+        std::vector<Reading> readings;  // Ring buffer, oldest at head once full
+        size_t head = 0;
+        uint64_t sequence = 0;
+        ServoData latest;
+    };
+
+    const Reading& _reading(const JointHistory& joint, size_t age) const;
+    size_t _count(const JointHistory& joint) const;
+    bool _live(const JointHistory& joint, Clock::time_point newest) const;
+    Clock::time_point _newest() const;
+    Clock::time_point _heldFrom() const;
+
+    size_t _joint_count;
+    Clock::duration _grid_period;
+    Clock::duration _stale_after;
+    size_t _history;
+    std::vector<JointHistory> _joints;  // arm * joint_count + joint
+    bool _grid_started;
+    Clock::time_point _next_grid;
+    uint64_t _skipped;
+};
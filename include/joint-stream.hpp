@@ -0,0 +1,253 @@
+#pragma once
+
+#include "servo-data.hpp"
+#include <netinet/in.h>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief One leader cycle as carried in a joint-state datagram
+ */
+struct JointStateFrame
+{
+    static constexpr size_t MAX_ARMS = 2;
+    static constexpr size_t MAX_JOINTS = 6;
+    static constexpr uint16_t INVALID_POSITION = 0xFFFF;  // Joint failed to read this cycle
+
+    uint32_t sequence = 0;
+    uint32_t session = 0;      // Picked at random per publisher; a new value means the leader restarted
+    int64_t timestamp_ns = 0;  // Sender's wall clock (CLOCK_REALTIME) when the cycle was sampled
+    bool emergency_stop = false;
+    uint8_t arm_count = 0;
+    uint8_t joint_count = 0;
+    std::array<uint16_t, MAX_ARMS * MAX_JOINTS> positions{};
+
+    /**
+     * @brief Position of one joint, or INVALID_POSITION
+     */
+    uint16_t position(size_t arm, size_t joint) const
+    {
+        return positions[arm * joint_count + joint];
+    }
+};
+
+/**
+ * @brief Largest encoded frame in bytes
+ */
+constexpr size_t MAX_JOINT_STATE_DATAGRAM = 22 + 2 * JointStateFrame::MAX_ARMS * JointStateFrame::MAX_JOINTS;
+
+/**
+ * @brief Serialises a frame into the little-endian wire format
+ * @param frame Frame to encode
+ * @param buffer At least MAX_JOINT_STATE_DATAGRAM bytes
+ * @return Number of bytes written
+ */
+size_t encodeJointState(const JointStateFrame& frame, uint8_t* buffer);
+
+/**
+ * @brief Parses a datagram produced by encodeJointState()
+ * @param buffer Received bytes
+ * @param length Number of bytes received
+ * @param frame Filled in on success
+ * @return false if the datagram is truncated or not a joint-state frame
+ */
+bool decodeJointState(const uint8_t* buffer, size_t length, JointStateFrame& frame);
+
+/**
+ * @brief Parses "a.b.c.d:port" into an IPv4 socket address
+ * @throws std::runtime_error if the endpoint is malformed
+ */
+sockaddr_in parseEndpoint(const std::string& endpoint);
+
+/**
+ * @brief Current CLOCK_REALTIME in nanoseconds, the time base of frame timestamps
+ */
+int64_t wallClockNanoseconds();
+
+/**
+ * @brief Playout delay bounds and sizing of a JitterBuffer
+ */
+struct JitterBufferConfig
+{
+    std::chrono::microseconds min_delay{1000};
+    std::chrono::microseconds max_delay{100000};
+    double jitter_multiplier = 3.0;
+    size_t capacity = 64;  // Frames held at most; the oldest is given up beyond this
+};
+
+/**
+ * @brief Reorders frames and releases them after an adaptive playout delay
+ *
+ * The one-way transit of each frame is measured against the lowest transit
+ * seen recently, which absorbs any constant offset between the two hosts'
+ * clocks. The playout delay tracks the RFC 3550 interarrival jitter estimate
+ * times a multiplier, clamped to [min_delay, max_delay]. Frames that never
+ * play out count as lost; frames arriving after their slot has passed count
+ * as late.
+ *
+ * A restarted sender is recognised by a new session, by a frame whose
+ * sequence went back while its timestamp moved forward, by a sequence far
+ * behind the newest one or by a run of late frames. The buffer then starts
+ * over from that frame instead of discarding the new stream as late.
+ */
+class JitterBuffer
+{
+public:
+    using Config = JitterBufferConfig;
+
+    struct Stats
+    {
+        uint64_t received = 0;
+        uint64_t played = 0;
+        uint64_t lost = 0;        // Sequence numbers skipped at playout
+        uint64_t late = 0;        // Arrived after their slot, or duplicates of played frames
+        uint64_t duplicates = 0;  // Same sequence number already waiting in the buffer
+        uint64_t reordered = 0;   // Arrived behind a newer frame
+        uint64_t restarts = 0;    // Sender restarts detected; the buffer started over each time
+        double jitter_us = 0.0;
+        double delay_us = 0.0;    // Current playout delay beyond the base transit
+    };
+
+    explicit JitterBuffer(const Config& config = Config());
+
+    /**
+     * @brief Adds a received frame
+     * @param frame Decoded frame
+     * @param arrival_ns Receive time on the wall clock
+     */
+    void push(const JointStateFrame& frame, int64_t arrival_ns);
+
+    /**
+     * @brief Releases the next frame whose playout time has come
+     * @param frame Filled in when a frame is released
+     * @param now_ns Current wall clock time
+     * @return false if nothing is due yet
+     */
+    bool pop(JointStateFrame& frame, int64_t now_ns);
+
+    /**
+     * @brief Wall clock time at which the next buffered frame becomes due
+     * @return -1 if the buffer is empty
+     */
+    int64_t nextPlayout() const;
+
+    Stats stats() const;
+
+private:
+    int64_t _targetDelay() const;
+    int64_t _playoutTime(const JointStateFrame& frame) const;
+    void _reset();
+
+    Config _config;
+    std::vector<JointStateFrame> _frames;  // Sorted by sequence number
+    bool _started;
+    uint32_t _next_sequence;
+    uint32_t _highest_sequence;
+    uint32_t _session;
+    int64_t _highest_timestamp;
+    uint32_t _late_run;           // Consecutive frames behind the playout point
+    int64_t _base_transit;
+    int64_t _window_min_transit;
+    uint32_t _window_count;
+    int64_t _last_transit;
+    double _jitter_ns;
+    Stats _stats;
+};
+
+/**
+ * @brief Sends one datagram per leader cycle to a unicast or multicast endpoint
+ *
+ * publish() uses a non-blocking send and never throws, so it can sit on the
+ * acquisition path; failed sends are only counted.
+ */
+class JointStatePublisher
+{
+public:
+    /**
+     * @brief Opens the sending socket
+     * @param endpoint Destination "a.b.c.d:port"; multicast groups are supported
+     * @param multicast_ttl Hop limit for multicast destinations
+     * @throws std::runtime_error if the endpoint is malformed or the socket cannot be created
+     */
+    explicit JointStatePublisher(const std::string& endpoint, int multicast_ttl = 1);
+
+    ~JointStatePublisher();
+
+    JointStatePublisher(const JointStatePublisher&) = delete;
+    JointStatePublisher& operator=(const JointStatePublisher&) = delete;
+
+    /**
+     * @brief Sends the current positions of up to MAX_ARMS arms
+     * @param arms Per-joint state per arm; joints with an error are sent as INVALID_POSITION
+     * @param emergency_stop Whether the leader's emergency stop is latched
+     * @param timestamp_ns Wall clock time the positions were sampled
+     */
+    void publish(const std::vector<const std::vector<ServoData>*>& arms, bool emergency_stop, int64_t timestamp_ns);
+
+    /**
+     * @brief Sends a prepared frame, stamping it with the next sequence number
+     */
+    void publish(JointStateFrame& frame);
+
+    uint64_t sent() const;
+    uint64_t sendErrors() const;
+
+private:
+    int _fd;
+    sockaddr_in _destination;
+    uint32_t _session;
+    uint32_t _sequence;
+    uint64_t _sent;
+    uint64_t _send_errors;
+};
+
+/**
+ * @brief Receives joint-state datagrams and plays them out through a JitterBuffer
+ */
+class JointStateSubscriber
+{
+public:
+    /**
+     * @brief Binds to the endpoint, joining it if it is a multicast group
+     * @param endpoint Local "a.b.c.d:port"; port 0 picks a free port
+     * @param config Jitter buffer settings
+     * @throws std::runtime_error if the endpoint is malformed or cannot be bound
+     */
+    explicit JointStateSubscriber(const std::string& endpoint,
+                                  const JitterBuffer::Config& config = JitterBuffer::Config());
+
+    ~JointStateSubscriber();
+
+    JointStateSubscriber(const JointStateSubscriber&) = delete;
+    JointStateSubscriber& operator=(const JointStateSubscriber&) = delete;
+
+    /**
+     * @brief Waits for the next frame to play out
+     * @param frame Filled in when a frame is released
+     * @param timeout Longest time to wait
+     * @return false on timeout
+     */
+    bool receive(JointStateFrame& frame, std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Port actually bound, useful with port 0
+     */
+    uint16_t port() const;
+
+    JitterBuffer::Stats stats() const;
+
+    /**
+     * @brief Datagrams dropped because they did not decode
+     */
+    uint64_t malformed() const;
+
+private:
+    void _drainSocket();
+
+    int _fd;
+    JitterBuffer _buffer;
+    uint64_t _malformed;
+};
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Latest leader-to-follower latency estimate
+ */
+struct LatencyEstimate
+{
+    bool valid = false;         // False until the arms have moved enough to correlate
+    double lag_ms = 0.0;        // How far measured positions trail the commands
+    double correlation = 0.0;   // Normalised peak height, 1 for a perfect delayed copy
+    double rms = 0.0;           // Tracking error with the lag removed, in position ticks
+    uint64_t updates = 0;       // Estimates computed so far, valid or not
+};
+
+/**
+ * @brief Estimates teleoperation latency by cross-correlating commands with measured positions
+ *
+ * The control loop feeds timestamped commands (leader positions) and the
+ * positions the follower then measured. A background thread periodically
+ * resamples the most recent window of both onto a uniform grid, cross-
+ * correlates them with an FFT per joint, sums the joints and takes the
+ * lag of the peak, refined between grid points by fitting a parabola.
+ * Joints that did not move contribute nothing, so the estimate stays
+ * invalid until something moves enough to time it.
+ *
+ * Timestamps are wall clock nanoseconds so commands can carry the leader's
+ * own sample time; leader and follower clocks must then be synchronised.
+ */
+class LatencyEstimator
+{
+public:
+    struct Config
+    {
+        std::chrono::milliseconds grid_period{5};   // Resampling resolution
+        std::chrono::milliseconds window{8000};     // History correlated per estimate
+        std::chrono::milliseconds max_lag{1000};    // Largest lag searched for
+        std::chrono::milliseconds interval{1000};   // Time between estimates
+        double min_correlation = 0.5;               // Weaker peaks are reported as invalid
+    };
+
+    /**
+     * @brief Starts the estimator thread
+     * @param channels Joints fed through addCommand() and addMeasurement()
+     * @param config Window and grid settings
+     */
+    explicit LatencyEstimator(size_t channels, const Config& config);
+
+    /**
+     * @brief Stops the estimator thread
+     */
+    ~LatencyEstimator();
+
+    LatencyEstimator(const LatencyEstimator&) = delete;
+    LatencyEstimator& operator=(const LatencyEstimator&) = delete;
+
+    /**
+     * @brief Adds the position a joint was commanded to; cheap, call from the control loop
+     * @param channel Joint index
+     * @param time_ns Wall clock time the command refers to
+     * @param position Commanded position
+     */
+    void addCommand(size_t channel, int64_t time_ns, double position);
+
+    /**
+     * @brief Adds a position the follower measured for a joint
+     * @param channel Joint index
+     * @param time_ns Wall clock time of the measurement
+     * @param position Measured position
+     */
+    void addMeasurement(size_t channel, int64_t time_ns, double position);
+
+    /**
+     * @brief Most recent estimate
+     */
+    LatencyEstimate estimate() const;
+
+private:
+    struct Sample
+    {
+        int64_t time_ns;
+        double position;
+    };
+
+    struct Channel
+    {
+        std::deque<Sample> commands;
+        std::deque<Sample> measurements;
+    };
+
+    void _run();
+    LatencyEstimate _compute(const std::vector<Channel>& channels, uint64_t updates) const;
+    void _trim(std::deque<Sample>& samples, int64_t newest_ns);
+
+    Config _config;
+    size_t _grid_size;   // Grid points per window
+    size_t _fft_size;    // Power of two holding the window twice, so the correlation does not wrap
+    mutable std::mutex _mutex;
+    std::condition_variable _wake;
+    std::vector<Channel> _channels;
+    LatencyEstimate _estimate;
+    bool _running;
+    std::thread _thread;
+};
+
+/**
+ * @brief Formats an estimate as one status line
+ */
+std::string formatLatencyLine(const LatencyEstimate& estimate);
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief One named value exported for monitoring
+ */
+struct Metric
+{
+    enum Type
+    {
+        GAUGE,     // Current value, may go up or down
+        COUNTER    // Running total since start, never decreases
+    };
+
+    std::string name;   // e.g. perseus_follower_latency_ms
+    double value;
+    std::string help;   // One line description, may be empty
+    Type type = GAUGE;
+};
+
+/**
+ * @brief Replaces a metrics file with the given values
+ *
+ * Written in the Prometheus text exposition format, so node_exporter's
+ * textfile collector (or anything that reads key value lines) can pick it
+ * up. The file is written beside the target and renamed over it, so a
+ * reader never sees it half written.
+ * @param path File to replace
+ * @param metrics Values to export
+ * @return false if the file could not be written
+ */
+bool writeMetricsFile(const std::string& path, const std::vector<Metric>& metrics);
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+/**
+ * @brief Bounded lock-free multi-producer single-consumer queue
+ *
+ * Ring of preallocated cells after Dmitry Vyukov's bounded queue: each cell
+ * carries a sequence number that tells producers whether it is free and the
+ * consumer whether it is filled. push() claims a cell with one
+ * compare-exchange and constructs the value in place, so neither side ever
+ * allocates or blocks. pop() may only be called from one thread. A pop()
+ * racing a push() that has claimed its cell but not filled it yet reports
+ * empty, and the element becomes visible on a later pop(); order is FIFO by
+ * claim.
+ */
+template <typename T>
+class MpscQueue
+{
+public:
+    /**
+     * @brief Allocates the cells
+     * @param capacity Elements held at most, rounded up to a power of two
+     */
+    explicit MpscQueue(size_t capacity)
+        : _capacity(_roundUp(capacity)), _mask(_capacity - 1), _cells(new Cell[_capacity]), _head(0), _tail(0)
+    {
+        for (size_t i = 0; i < _capacity; ++i)
+        {
+            _cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~MpscQueue()
+    {
+        // Destroy whatever was pushed and never popped
+        for (size_t pos = _tail;; ++pos)
+        {
+            Cell& cell = _cells[pos & _mask];
+            if (cell.sequence.load(std::memory_order_acquire) != pos + 1)
+            {
+                break;
+            }
+            cell.value()->~T();
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    /**
+     * @brief Appends a value; safe to call from any number of threads
+     * @return false, leaving value untouched, if the queue is full
+     */
+    bool push(T&& value)
+    {
+        size_t pos = _head.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;)
+        {
+            cell = &_cells[pos & _mask];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const ptrdiff_t lag = static_cast<ptrdiff_t>(sequence - pos);
+            if (lag == 0)
+            {
+                if (_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (lag < 0)
+            {
+                return false;  // The consumer has not freed this cell yet
+            }
+            else
+            {
+                pos = _head.load(std::memory_order_relaxed);
+            }
+        }
+        new (cell->storage) T(std::move(value));
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Removes the oldest value; consumer thread only
+     * @return false if no filled element was available
+     */
+    bool pop(T& out)
+    {
+        Cell& cell = _cells[_tail & _mask];
+        if (cell.sequence.load(std::memory_order_acquire) != _tail + 1)
+        {
+            return false;
+        }
+        T* value = cell.value();
+        out = std::move(*value);
+        value->~T();
+        cell.sequence.store(_tail + _capacity, std::memory_order_release);
+        ++_tail;
+        return true;
+    }
+
+    size_t capacity() const
+    {
+        return _capacity;
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence{0};
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* value()
+        {
+            return std::launder(reinterpret_cast<T*>(storage));
+        }
+    };
+
+    static size_t _roundUp(size_t capacity)
+    {
+        size_t rounded = 1;
+        while (rounded < capacity)
+        {
+            rounded <<= 1;
+        }
+        return rounded;
+    }
+
+    size_t _capacity;
+    size_t _mask;
+    std::unique_ptr<Cell[]> _cells;
+    alignas(64) std::atomic<size_t> _head;  // Next cell to claim; advanced by producers
+    alignas(64) size_t _tail;               // Next cell to read; consumer only
+};
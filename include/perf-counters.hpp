@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Hardware and software event counters read via perf_event_open
+ *
+ * Each event is opened on its own so that a missing PMU (common in VMs) or a
+ * restrictive perf_event_paranoid setting only disables the affected counters.
+ */
+class PerfCounters
+{
+public:
+    enum Event
+    {
+        CYCLES = 0,
+        INSTRUCTIONS,
+        CACHE_MISSES,
+        CONTEXT_SWITCHES,
+        EVENT_COUNT
+    };
+
+    /**
+     * @brief Counter deltas accumulated between start() and stop()
+     */
+    struct Sample
+    {
+        std::array<uint64_t, EVENT_COUNT> values{};
+        std::array<bool, EVENT_COUNT> valid{};
+    };
+
+    /**
+     * @brief Opens the counters for the calling thread, disabled
+     */
+    PerfCounters();
+
+    /**
+     * @brief Closes any counters that were opened
+     */
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    /**
+     * @brief Returns true if at least one counter could be opened
+     */
+    bool available() const;
+
+    /**
+     * @brief Resets and enables all open counters
+     */
+    void start();
+
+    /**
+     * @brief Disables the counters and returns their values since start()
+     */
+    Sample stop();
+
+    /**
+     * @brief Short printable name of an event
+     */
+    static const char* eventName(Event event);
+
+private:
+    std::array<int, EVENT_COUNT> _fds;
+};
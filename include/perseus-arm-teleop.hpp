@@ -1,5 +1,6 @@
 #pragma once
 
+#include "clock.hpp"
 #include <boost/asio.hpp>
 #include <string>
 #include <vector>
@@ -11,12 +12,24 @@
 class ST3215ServoReader 
 {
 public:
+    /**
+     * @brief Outcome of one servo's part of a sync read
+     */
+    struct ServoReply
+    {
+        uint8_t id = 0;
+        std::vector<uint8_t> data;  // Empty if error is set
+        std::string error;
+        Clock::time_point completed{};  // When the servo's reply finished arriving; unset if error is set
+    };
+
     /**
      * @brief Constructs a new ST3215ServoReader
      * @param port Serial port path (e.g., "/dev/ttyACM0")
      * @param baud_rate Baud rate for serial communication
+     * @param clock Clock used for settle delays, retries and timeouts
      */
-    ST3215ServoReader(const std::string& port, unsigned int baud_rate);
+    ST3215ServoReader(const std::string& port, unsigned int baud_rate, Clock& clock = Clock::system());
     
     /**
      * @brief Destructor ensures serial port is properly closed
@@ -27,19 +40,141 @@ public:
      * @brief Reads the current position of a specified servo
      * @param servo_id ID of the servo to read from
      * @return Current position value (0-4095)
+     * @throws EmergencyStopError if an emergency stop cancels the transaction
      * @throws std::runtime_error if communication fails after retries
      */
     uint16_t readPosition(uint8_t servo_id);
 
+    /**
+     * @brief Reads a block of registers from one servo
+     * @param servo_id ID of the servo to read from
+     * @param address First register address
+     * @param size Number of bytes to read
+     * @return Register contents, size bytes long
+     * @throws EmergencyStopError if an emergency stop cancels the transaction
+     * @throws std::runtime_error if communication fails after retries
+     */
+    std::vector<uint8_t> readRegisters(uint8_t servo_id, uint8_t address, uint8_t size);
+
+    /**
+     * @brief Reads the same registers from several servos with one SYNC_READ
+     *
+     * A single attempt is made; servos that fail to answer get an error in
+     * their reply instead of failing the whole call.
+     * @param servo_ids Servos to read, answered in this order
+     * @param address First register address
+     * @param size Number of bytes to read from each servo
+     * @return One reply per requested ID, in request order
+     * @throws EmergencyStopError if an emergency stop cancels the transaction
+     * @throws std::runtime_error if the request cannot be sent
+     */
+    std::vector<ServoReply> syncRead(const std::vector<uint8_t>& servo_ids, uint8_t address, uint8_t size);
+
+    /**
+     * @brief syncRead() into a caller-owned vector, reusing its replies' storage
+     * @param replies Replaced by one reply per requested ID, in request order
+     */
+    void syncRead(const std::vector<uint8_t>& servo_ids, uint8_t address, uint8_t size,
+                  std::vector<ServoReply>& replies);
+
+    /**
+     * @brief Writes the same registers on several servos with one SYNC_WRITE
+     *
+     * Broadcast instructions are not answered, so success only means the
+     * packet went out on the bus.
+     * @param servo_ids Servos to write
+     * @param address First register address
+     * @param size Number of bytes written to each servo
+     * @param data size bytes per servo, concatenated in servo_ids order
+     * @throws EmergencyStopError if an emergency stop is active or triggered meanwhile
+     * @throws std::runtime_error if data has the wrong length or the write fails
+     */
+    void syncWrite(const std::vector<uint8_t>& servo_ids, uint8_t address, uint8_t size,
+                   const std::vector<uint8_t>& data);
+
+    /**
+     * @brief Checks whether the underlying device is still present
+     * @return false once the port has been hung up, e.g. by a USB disconnect
+     */
+    bool isConnected();
+
+    /**
+     * @brief Decodes a complete position reply packet
+     * @param packet Reply bytes starting at the 0xFF 0xFF header
+     * @param length Number of valid bytes in packet
+     * @param servo_id ID of the servo the reply is expected from
+     * @return Position value carried by the reply (0-4095)
+     * @throws std::runtime_error if the packet is malformed or reports servo errors
+     */
+    static uint16_t parsePositionResponse(const uint8_t* packet, size_t length, uint8_t servo_id);
+
+    /**
+     * @brief Validates a status packet and locates its parameter bytes
+     * @param packet Reply bytes starting at the 0xFF 0xFF header
+     * @param length Number of valid bytes in packet
+     * @param servo_id ID of the servo the reply is expected from
+     * @param payload_size Set to the number of parameter bytes
+     * @return Pointer to the first parameter byte inside packet
+     * @throws std::runtime_error if the packet is malformed, fails its checksum or reports servo errors
+     */
+    static const uint8_t* parseStatusPacket(const uint8_t* packet, size_t length, uint8_t servo_id,
+                                            size_t& payload_size);
+
 private:
     /**
-     * @brief Performs a single attempt to read the position
+     * @brief Performs a single attempt to read a block of registers
      * @param servo_id ID of the servo to read from
+     * @param address First register address
+     * @param size Number of bytes to read
      * @param timeout Maximum time to wait for response
-     * @return Current position value (0-4095)
+     * @param generation Emergency stop generation at transaction start
+     * @return Register contents, size bytes long
+     * @throws EmergencyStopError if an emergency stop is triggered meanwhile
      * @throws std::runtime_error if communication fails
      */
-    uint16_t _readPositionOnce(uint8_t servo_id, const std::chrono::milliseconds& timeout);
+    std::vector<uint8_t> _readRegistersOnce(uint8_t servo_id, uint8_t address, uint8_t size,
+                                            const std::chrono::milliseconds& timeout, uint64_t generation);
+
+    /**
+     * @brief Flushes the port, writes a command and waits the minimum response time
+     * @param command Complete instruction packet
+     * @param generation Emergency stop generation at transaction start
+     * @param expect_reply Whether to wait the servo's minimum response time afterwards
+     * @throws std::runtime_error if the command cannot be written
+     */
+    void _sendCommand(const std::vector<uint8_t>& command, uint64_t generation, bool expect_reply = true);
+
+    /**
+     * @brief Reads one status packet into response_buffer
+     * @param response_buffer Buffer of at least 256 bytes
+     * @param timeout Maximum time to wait for each part of the packet
+     * @param generation Emergency stop generation at transaction start
+     * @return Total packet length including header
+     * @throws std::runtime_error on timeout or malformed header
+     */
+    size_t _readStatusPacket(uint8_t* response_buffer, const std::chrono::milliseconds& timeout,
+                             uint64_t generation);
+
+    /**
+     * @brief Reads exactly count bytes, waiting with poll() between chunks
+     * @param dest Destination buffer
+     * @param count Number of bytes to read
+     * @param timeout Maximum time to wait for all bytes
+     * @param generation Emergency stop generation at transaction start
+     * @param what Name of the part being read, used in error messages
+     * @throws EmergencyStopError if an emergency stop is triggered meanwhile
+     * @throws std::runtime_error on timeout or port errors
+     */
+    void _readExact(uint8_t* dest, size_t count, const std::chrono::milliseconds& timeout,
+                    uint64_t generation, const char* what);
+
+    /**
+     * @brief Sleeps on the reader's clock, waking early for an emergency stop
+     * @param duration Time to wait
+     * @param generation Emergency stop generation at transaction start
+     * @throws EmergencyStopError if an emergency stop is triggered meanwhile
+     */
+    void _pause(const std::chrono::milliseconds& duration, uint64_t generation);
 
     /**
      * @brief Creates a read command packet according to ST3215 protocol
@@ -50,6 +185,28 @@ private:
      */
     std::vector<uint8_t> _createReadCommand(uint8_t id, uint8_t address, uint8_t size);
 
+    /**
+     * @brief Creates a broadcast SYNC_READ packet
+     * @param ids Servo IDs to read, in reply order
+     * @param address Memory address to read from
+     * @param size Number of bytes to read from each servo
+     * @return Vector containing the complete command packet
+     */
+    std::vector<uint8_t> _createSyncReadCommand(const std::vector<uint8_t>& ids, uint8_t address, uint8_t size);
+
+    /**
+     * @brief Creates a broadcast SYNC_WRITE packet
+     * @param ids Servo IDs to write
+     * @param address Memory address to write to
+     * @param size Number of bytes written to each servo
+     * @param data size bytes per servo, in ids order
+     * @return Vector containing the complete command packet
+     */
+    std::vector<uint8_t> _createSyncWriteCommand(const std::vector<uint8_t>& ids, uint8_t address, uint8_t size,
+                                                 const std::vector<uint8_t>& data);
+
     boost::asio::io_service _io_service;
     boost::asio::serial_port _serial_port;
+    Clock& _clock;
+    int _estop_slot;
 };
\ No newline at end of file
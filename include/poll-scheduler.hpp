@@ -0,0 +1,87 @@
+#pragma once
+
+#include "clock.hpp"
+#include "servo-data.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Shares a fixed number of joint reads per cycle out by how fast each joint moves
+ *
+ * Every cycle each joint earns credit in proportion to its weight, one plus
+ * its recent speed over velocity_scale, and the budget joints holding the
+ * most credit are read. A joint that has sat unread for max_skip cycles is
+ * read next regardless, so a stationary joint still notices when it starts
+ * moving. Speed rises as soon as a reading shows it and decays over about
+ * half a second, so a joint that stops is backed off quickly but not after
+ * a single still reading.
+ */
+class PollScheduler
+{
+public:
+    struct Config
+    {
+        size_t budget = 4;              // Joint reads per cycle
+        double velocity_scale = 500.0;  // Speed, in ticks per second, that doubles a joint's share
+        size_t max_skip = 10;           // Cycles a joint may go unread
+    };
+
+    /**
+     * @brief Creates a scheduler with no motion seen yet, so joints start out read in turn
+     * @param joints Joints of the arm
+     * @param config Budget and weighting
+     */
+    PollScheduler(size_t joints, const Config &config);
+
+    /**
+     * @brief Picks the joints to read this cycle
+     * @return One flag per joint; at most budget are set
+     */
+    const std::vector<bool> &select();
+
+    /**
+     * @brief Updates joint speeds and update rates from a completed cycle
+     * @param arm_data Per-joint state of the arm
+     * @param cycle Arm cycle just completed; joints not refreshed in it are skipped
+     * @param now Completion time of the cycle
+     */
+    void observe(const std::vector<ServoData> &arm_data, uint64_t cycle, Clock::time_point now);
+
+    /**
+     * @brief Update rate of each joint in Hz, smoothed over recent reads
+     */
+    std::vector<double> rates() const;
+
+    /**
+     * @brief Recent speed of a joint in ticks per second
+     */
+    double velocity(size_t joint) const;
+
+    size_t budget() const;
+
+private:
+    struct Joint
+    {
+        double credit = 0.0;
+        double velocity = 0.0;
+        double interval_s = 0.0;   // Smoothed time between fresh readings
+        size_t skipped = 0;        // Cycles since the joint was last selected
+        uint16_t position = 0;
+        Clock::time_point sampled{};
+    };
+
+    Config _config;
+    std::vector<Joint> _joints;
+    std::vector<bool> _selected;
+    std::vector<size_t> _order;
+    Clock::time_point _now;
+};
+
+/**
+ * @brief Formats each joint's update rate as one status line
+ * @param arm_number 1-based arm number shown in the line
+ * @param scheduler Scheduler polling the arm
+ */
+std::string formatPollLine(int arm_number, const PollScheduler &scheduler);
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "clock.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Constant-memory estimate of one joint's usable range
+ *
+ * Readings are counted in a fixed histogram over the 0-4095 position space
+ * and the range is read off as low and high quantiles, so a handful of bad
+ * readings cannot widen it the way they widen a raw min/max.
+ *
+ * A reading that jumps more than glitch_threshold away from the previous
+ * one is held back for one reading. If the next reading is back near the
+ * previous one, the jump was an isolated glitch and is rejected; otherwise
+ * it was real motion and is counted.
+ */
+class RangeEstimator
+{
+public:
+    static constexpr size_t BIN_WIDTH = 16;
+    static constexpr size_t BIN_COUNT = 4096 / BIN_WIDTH;
+
+    /**
+     * @brief Creates an empty estimator
+     * @param glitch_threshold Jump between consecutive readings that needs confirming
+     * @param tail Fraction of readings ignored at each end of the range
+     */
+    explicit RangeEstimator(uint16_t glitch_threshold = 256, double tail = 0.005);
+
+    /**
+     * @brief Adds one position reading; O(1)
+     */
+    void add(uint16_t position);
+
+    /**
+     * @brief Adds the readings another estimator accepted and rejected
+     *
+     * Lets independent stretches of a recording be estimated in parallel and
+     * combined. Glitch rejection does not look across the seam, so a glitch
+     * that is the first or last reading of a stretch is kept or lost.
+     */
+    void merge(const RangeEstimator& other);
+
+    /**
+     * @brief Position below which a fraction q of accepted readings lie
+     * @param q Quantile in [0, 1]
+     * @return 0 if nothing has been accepted yet
+     */
+    uint16_t quantile(double q) const;
+
+    /**
+     * @brief Robust lower bound, the tail quantile
+     */
+    uint16_t low() const;
+
+    /**
+     * @brief Robust upper bound, the 1 - tail quantile
+     */
+    uint16_t high() const;
+
+    uint16_t min() const;        // Smallest accepted reading
+    uint16_t max() const;        // Largest accepted reading
+    uint64_t samples() const;    // Readings accepted
+    uint64_t rejected() const;   // Readings rejected as glitches
+
+    /**
+     * @brief Accepted readings in one histogram bin
+     * @param bin Bin index; bin b holds positions [b * BIN_WIDTH, (b + 1) * BIN_WIDTH)
+     */
+    uint32_t binCount(size_t bin) const;
+
+    /**
+     * @brief Number of bins holding at least one reading, the range covered so far
+     */
+    size_t coveredBins() const;
+
+private:
+    void _accept(uint16_t position);
+
+    std::array<uint32_t, BIN_COUNT> _bins;
+    uint16_t _glitch_threshold;
+    double _tail;
+    uint64_t _samples;
+    uint64_t _rejected;
+    size_t _covered;
+    uint16_t _min;
+    uint16_t _max;
+    uint16_t _last;
+    uint16_t _pending;
+    bool _has_pending;
+};
+
+/**
+ * @brief Decides when sweeping the joints has stopped adding range coverage
+ *
+ * Fed the total covered bins over all joints; converged once coverage has
+ * grown at least once and then stayed flat for the quiet period, so a
+ * session in which nothing is moved never converges.
+ */
+class ConvergenceDetector
+{
+public:
+    /**
+     * @brief Creates a detector
+     * @param quiet_period Time without new coverage that counts as converged
+     */
+    explicit ConvergenceDetector(Clock::duration quiet_period);
+
+    /**
+     * @brief Records the current coverage
+     * @param covered_bins Covered bins summed over all joints being calibrated
+     * @param now Current time
+     * @return converged(now)
+     */
+    bool update(size_t covered_bins, Clock::time_point now);
+
+    bool converged(Clock::time_point now) const;
+
+    /**
+     * @brief Time since coverage last grew, zero before the first growth
+     */
+    Clock::duration quietFor(Clock::time_point now) const;
+
+    Clock::duration quietPeriod() const;
+
+private:
+    Clock::duration _quiet_period;
+    size_t _covered;
+    bool _started;
+    bool _grown;
+    Clock::time_point _last_growth;
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Settings for running acquisition with real-time guarantees
+ */
+struct RealtimeConfig
+{
+    bool enabled = false;
+    std::vector<int> cpus;              // CPUs acquisition threads are pinned to, round robin
+    int priority = 80;                  // SCHED_FIFO priority for acquisition threads
+    size_t stack_prefault_bytes = 512 * 1024;
+    size_t heap_prefault_bytes = 16 * 1024 * 1024;
+};
+
+/**
+ * @brief Parses a list of indices such as "2,3" or "2-5"
+ * @param list Comma-separated indices and ascending ranges, digits only
+ * @param limit Every index must be below this
+ * @throws std::runtime_error on malformed input, an index out of range or a reversed range
+ */
+std::vector<int> parseIndexList(const std::string &list, int limit);
+
+/**
+ * @brief Parses a CPU list such as "2,3" or "2-5" against the CPUs of this machine
+ * @throws std::runtime_error on malformed input or a CPU that does not exist
+ */
+std::vector<int> parseCpuList(const std::string &list);
+
+/**
+ * @brief Locks all current and future pages and pre-faults stack and heap
+ *
+ * Also stops glibc from trimming or mmap-ing heap memory so freed blocks are
+ * reused instead of being returned to the kernel and faulted in again.
+ * @throws std::runtime_error if mlockall() is refused (needs CAP_IPC_LOCK
+ *         or a sufficient RLIMIT_MEMLOCK)
+ */
+void lockProcessMemory(const RealtimeConfig &config);
+
+/**
+ * @brief Pins the calling thread and switches it to SCHED_FIFO
+ * @param config Real-time settings
+ * @param thread_index Index of the acquisition thread, selects the CPU
+ * @throws std::runtime_error if affinity or scheduling cannot be applied
+ */
+void configureRealtimeThread(const RealtimeConfig &config, size_t thread_index);
+
+/**
+ * @brief Touches stack pages of the calling thread so later use cannot fault
+ */
+void prefaultStack(size_t bytes);
+
+/**
+ * @brief Counts page faults taken by one thread since a steady-state mark
+ *
+ * Must be used from the thread being monitored.
+ */
+class FaultMonitor
+{
+public:
+    /**
+     * @brief Records the current fault counts of the calling thread as baseline
+     */
+    void markSteadyState();
+
+    /**
+     * @brief Returns true once markSteadyState() has been called
+     */
+    bool steady() const;
+
+    /**
+     * @brief Minor faults since the steady-state mark
+     */
+    long minorFaults() const;
+
+    /**
+     * @brief Major faults since the steady-state mark
+     */
+    long majorFaults() const;
+
+private:
+    bool _steady = false;
+    long _minor_base = 0;
+    long _major_base = 0;
+};
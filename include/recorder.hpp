@@ -0,0 +1,228 @@
+#pragma once
+
+#include "clock.hpp"
+#include "servo-data.hpp"
+#include "spsc-ring.hpp"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief One arm cycle as stored in a recording
+ *
+ * Fixed 64 byte little-endian layout so recordings can be mapped and
+ * indexed directly. Positions of joints that failed to read that cycle are
+ * INVALID_POSITION.
+ */
+struct ArmRecord
+{
+    static constexpr size_t MAX_JOINTS = 6;
+    static constexpr uint16_t INVALID_POSITION = 0xFFFF;
+    static constexpr uint8_t FLAG_EMERGENCY_STOP = 1u << 0;
+    static constexpr uint8_t FLAG_ALIGNED = 1u << 1;  // Positions interpolated to time_ns
+
+    uint64_t cycle;                          // Arm cycle, or grid index for aligned records
+    int64_t time_ns;                         // Wall clock (CLOCK_REALTIME) of the cycle
+    int32_t joint_offset_us[MAX_JOINTS];     // Each joint's sample time relative to time_ns
+    uint16_t positions[MAX_JOINTS];
+    uint8_t arm;
+    uint8_t joint_count;
+    uint8_t flags;
+    uint8_t reserved[9];
+};
+
+static_assert(sizeof(ArmRecord) == 64, "ArmRecord is a fixed on-disk layout");
+
+/**
+ * @brief File header, one ArmRecord in size so records stay 64 byte aligned
+ */
+struct RecordingHeader
+{
+    static constexpr char MAGIC[8] = {'P', 'E', 'R', 'S', 'R', 'E', 'C', '1'};
+
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    int64_t started_ns;  // Wall clock when recording started
+    uint8_t reserved[40];
+};
+
+static_assert(sizeof(RecordingHeader) == sizeof(ArmRecord), "Header occupies one record slot");
+
+/**
+ * @brief Builds the record for one arm cycle
+ * @param arm Arm index
+ * @param cycle Arm cycle; joints not refreshed in it are recorded as invalid. With
+ *        FLAG_ALIGNED, the grid index, and every joint aligned at now is kept
+ * @param arm_data Per-joint state of the arm
+ * @param flags FLAG_* bits
+ * @param wall_ns Wall clock time corresponding to now
+ * @param now Current time on the clock joint samples were stamped with
+ */
+ArmRecord makeArmRecord(size_t arm, uint64_t cycle, const std::vector<ServoData>& arm_data, uint8_t flags,
+                        int64_t wall_ns, Clock::time_point now);
+
+/**
+ * @brief What the recorder does when the writer falls behind and the ring fills
+ */
+enum class RecordPolicy
+{
+    BLOCK,        // Wait for space; the only policy that can delay the caller
+    DROP_OLDEST,  // Overwrite the oldest queued record
+    DROP_NEWEST,  // Discard the record being added
+    DECIMATE      // Keep every 2nd cycle past half full, every 4th past three quarters, then drop newest
+};
+
+/**
+ * @brief Parses "block", "drop-oldest", "drop-newest" or "decimate"
+ * @throws std::runtime_error for any other name
+ */
+RecordPolicy parseRecordPolicy(const std::string& name);
+
+/**
+ * @brief Name of a policy as accepted by parseRecordPolicy()
+ */
+const char* recordPolicyName(RecordPolicy policy);
+
+/**
+ * @brief Writes ArmRecords to a file from a background thread
+ *
+ * The acquisition thread hands records over through a bounded lock-free
+ * SPSC ring; record() never allocates, locks or makes a system call, so a
+ * stalled disk can only cost records (counted per policy), never cycles,
+ * unless BLOCK is chosen. The writer thread batches records into large
+ * page-aligned buffers and writes each batch with one write() call, so
+ * every batch starts at a multiple of the batch size in the file. When
+ * recording is slow a partial batch is written early, and its remainder
+ * follows once the batch fills.
+ */
+class Recorder
+{
+public:
+    struct Stats
+    {
+        uint64_t recorded = 0;       // Records queued for writing
+        uint64_t written = 0;        // Records that reached the file
+        uint64_t dropped_oldest = 0;
+        uint64_t dropped_newest = 0;
+        uint64_t decimated = 0;
+        uint64_t blocked = 0;        // record() calls that had to wait (BLOCK only)
+        uint64_t write_errors = 0;   // Failed writes; their records are lost
+        uint64_t bytes = 0;
+        size_t queued = 0;
+        size_t high_watermark = 0;   // Most records ever queued at once
+        size_t capacity = 0;
+        double max_write_ms = 0.0;   // Longest single write() call
+    };
+
+    /**
+     * @brief Creates the file, writes its header and starts the writer thread
+     * @param path File to create or truncate
+     * @param policy Behaviour when the ring is full
+     * @param capacity Records the ring holds
+     * @param batch_bytes Bytes per write, rounded up to whole pages
+     * @throws std::runtime_error if the file cannot be created
+     */
+    Recorder(const std::string& path, RecordPolicy policy, size_t capacity = 4096, size_t batch_bytes = 64 * 1024);
+
+    /**
+     * @brief Drains the ring, writes the final partial batch and closes the file
+     */
+    ~Recorder();
+
+    Recorder(const Recorder&) = delete;
+    Recorder& operator=(const Recorder&) = delete;
+
+    /**
+     * @brief Queues one record; call from a single producer thread
+     */
+    void record(const ArmRecord& record);
+
+    Stats stats() const;
+
+    RecordPolicy policy() const;
+
+private:
+    void _run();
+    size_t _flush(size_t from, size_t to);
+
+    int _fd;
+    RecordPolicy _policy;
+    SpscRing<ArmRecord> _ring;
+    size_t _batch_bytes;
+    uint8_t* _buffer;
+    std::atomic<uint64_t> _recorded;
+    std::atomic<uint64_t> _written;
+    std::atomic<uint64_t> _dropped_oldest;
+    std::atomic<uint64_t> _dropped_newest;
+    std::atomic<uint64_t> _decimated;
+    std::atomic<uint64_t> _blocked;
+    std::atomic<uint64_t> _write_errors;
+    std::atomic<uint64_t> _bytes;
+    std::atomic<size_t> _high_watermark;
+    std::atomic<int64_t> _max_write_ns;
+    std::atomic<bool> _running;
+    std::thread _thread;
+};
+
+/**
+ * @brief Formats the recorder's counters as one status line
+ */
+std::string formatRecorderLine(const Recorder& recorder);
+
+/**
+ * @brief Read-only memory mapping of a recording written by Recorder
+ *
+ * Records are used in place from the page cache, so scanning a recording is
+ * bounded by how fast the kernel can read it ahead, not by copying.
+ */
+class RecordingFile
+{
+public:
+    /**
+     * @brief Maps a recording and checks its header
+     * @param path Recording to open
+     * @throws std::runtime_error if the file cannot be mapped or is not a recording
+     */
+    explicit RecordingFile(const std::string& path);
+
+    ~RecordingFile();
+
+    RecordingFile(const RecordingFile&) = delete;
+    RecordingFile& operator=(const RecordingFile&) = delete;
+
+    const RecordingHeader& header() const;
+
+    /**
+     * @brief Whole records in the file; a trailing partial record is ignored
+     */
+    size_t size() const;
+
+    const ArmRecord* records() const;
+
+    /**
+     * @brief Bytes mapped, the header and any partial record included
+     */
+    size_t bytes() const;
+
+private:
+    void* _data;
+    size_t _bytes;
+};
+
+/**
+ * @brief A contiguous run of records from one recording
+ */
+struct RecordBlock
+{
+    size_t file;   // Index of the recording it came from
+    const ArmRecord* begin;
+    const ArmRecord* end;
+};
+
+/**
+ * @brief Splits recordings into blocks of at most block_records records, in file order
+ */
+std::vector<RecordBlock> splitRecordings(const std::vector<const RecordingFile*>& files, size_t block_records);
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "clock.hpp"
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @brief Detects gaps and staleness in a stream of sequence-numbered samples
+ *
+ * Consumers feed it the sequence number of the newest sample they hold each
+ * time they look. Skipped numbers are counted as missed, a repeated number
+ * means nothing new arrived, and the spacing of new numbers gives the
+ * effective sample rate actually reaching this consumer.
+ */
+class SampleTracker
+{
+public:
+    /**
+     * @brief Creates a tracker
+     * @param stale_after Age beyond which the newest sample counts as stale
+     */
+    explicit SampleTracker(std::chrono::milliseconds stale_after = std::chrono::milliseconds(500));
+
+    /**
+     * @brief Records the newest sample seen by the consumer
+     * @param sequence Sample sequence number; 0 means no sample yet
+     * @param sampled When the sample was taken
+     * @return Number of sequence numbers skipped since the previous new sample
+     */
+    uint64_t observe(uint64_t sequence, Clock::time_point sampled);
+
+    /**
+     * @brief Returns true if no sample is newer than the stale limit
+     * @param now Current time on the clock the samples were stamped with
+     */
+    bool stale(Clock::time_point now) const;
+
+    /**
+     * @brief Age of the newest sample
+     */
+    Clock::duration age(Clock::time_point now) const;
+
+    /**
+     * @brief Effective rate of new samples in Hz, smoothed over recent samples
+     */
+    double rate() const;
+
+    uint64_t lastSequence() const;
+    uint64_t received() const;  // Distinct samples observed
+    uint64_t missed() const;    // Sequence numbers never observed
+    uint64_t restarts() const;  // Times the sequence went backwards, e.g. a producer restart
+
+private:
+    std::chrono::milliseconds _stale_after;
+    uint64_t _last_sequence;
+    Clock::time_point _last_sampled;
+    double _interval_s;
+    uint64_t _received;
+    uint64_t _missed;
+    uint64_t _restarts;
+};
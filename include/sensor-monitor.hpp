@@ -0,0 +1,109 @@
+#pragma once
+
+#include "clock.hpp"
+#include "servo-data.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Flags joints whose readings look stuck or impossible, from the readings alone
+ *
+ * A servo that keeps answering with a cached position looks healthy in
+ * ServoData, so each fresh reading is checked against the rest of the arm
+ * and against its own history; nothing extra is read from the bus.
+ *
+ * - FROZEN: the same position came back frozen_readings times in a row
+ *   while the arm's other joints travelled at least activity_travel ticks
+ *   between them. Travel only counts once a joint leaves a deadband around
+ *   where it last counted, so sensor noise on still joints never adds up to
+ *   activity. Clears on the next different reading.
+ * - IMPLAUSIBLE: a reading outside the 12-bit position range, or one that
+ *   jumped faster than max_speed since the previous reading.
+ * - TIMING: a new reading whose reply did not complete after the previous
+ *   one's, i.e. an old reply handed out again.
+ *
+ * IMPLAUSIBLE and TIMING stay raised for hold after the last occurrence.
+ */
+class SensorMonitor
+{
+public:
+    enum Fault : uint8_t
+    {
+        FROZEN = 1 << 0,
+        IMPLAUSIBLE = 1 << 1,
+        TIMING = 1 << 2
+    };
+
+    struct Config
+    {
+        size_t frozen_readings = 100;     // Identical readings in a row before a joint can be frozen
+        uint32_t activity_travel = 512;   // Ticks the other joints must move meanwhile
+        uint16_t deadband = 8;            // Ticks a joint must move before its travel counts
+        double max_speed = 8000.0;        // Ticks per second; well beyond what the servo can turn
+        Clock::duration hold = std::chrono::seconds(2);
+    };
+
+    /**
+     * @brief Creates a monitor with every joint healthy
+     * @param joints Joints of the arm
+     * @param config Thresholds
+     */
+    SensorMonitor(size_t joints, const Config &config);
+
+    /**
+     * @brief Checks the readings refreshed in a completed cycle
+     * @param arm_data Per-joint state of the arm
+     * @param cycle Arm cycle just completed; joints not refreshed in it are skipped
+     * @param now Completion time of the cycle
+     */
+    void observe(const std::vector<ServoData> &arm_data, uint64_t cycle, Clock::time_point now);
+
+    /**
+     * @brief Faults currently raised on a joint, a mask of Fault values
+     */
+    uint8_t faults(size_t joint) const;
+
+    /**
+     * @brief Joints with any fault raised
+     */
+    size_t flagged() const;
+
+    /**
+     * @brief Number of times a fault was raised since construction
+     * @param fault One Fault value
+     */
+    uint64_t events(Fault fault) const;
+
+    size_t joints() const;
+
+private:
+    struct Joint
+    {
+        bool seen = false;
+        uint16_t position = 0;
+        Clock::time_point sampled{};
+        size_t repeats = 0;           // Readings identical to the first of the current run
+        uint64_t others_at_run = 0;   // Other joints' travel when the run started
+        bool anchored = false;
+        uint16_t anchor = 0;          // Position travel was last counted from
+        uint64_t travel = 0;          // Ticks moved outside the deadband, ever
+        uint8_t faults = 0;
+        Clock::time_point implausible_at{};
+        Clock::time_point timing_at{};
+    };
+
+    void _raise(Joint &joint, Fault fault);
+
+    Config _config;
+    std::vector<Joint> _joints;
+    uint64_t _travel;                 // Sum of every joint's travel
+    uint64_t _events[3];
+};
+
+/**
+ * @brief Formats the joints flagged on each arm and the fault counts as one status line
+ * @param monitors One monitor per arm, in arm order
+ */
+std::string formatSensorLine(const std::vector<const SensorMonitor *> &monitors);
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief Lists /dev/ttyUSB* and /dev/ttyACM* devices, sorted by path
+ */
+std::vector<std::string> findSerialPorts();
+
+/**
+ * @brief Returns true if a /dev entry name looks like a servo bus adapter
+ */
+bool isSerialPortName(const std::string &filename);
+
+/**
+ * @brief Looks up the USB serial number of the adapter behind a tty
+ * @param port Device path such as "/dev/ttyACM0" (symlinks are resolved)
+ * @return Serial string from sysfs, or empty if the port is not USB backed
+ */
+std::string usbSerialForPort(const std::string &port);
+
+/**
+ * @brief Finds the current device path of the adapter with a USB serial
+ * @param serial Serial as returned by usbSerialForPort()
+ * @return Device path, or empty if no such adapter is plugged in
+ */
+std::string findPortByUsbSerial(const std::string &serial);
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "arm-link.hpp"
+#include "mpsc-queue.hpp"
+#include "realtime.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Traffic classes on a shared servo bus; lower values are served first
+ */
+enum class BusPriority
+{
+    CONTROL = 0,     // Positions feeding the UI, recorder or follower
+    DIAGNOSTIC = 1   // Temperatures, voltages and other health reads
+};
+
+/**
+ * @brief Owns one arm's port and serves register reads from any thread
+ *
+ * Clients enqueue requests on a bounded lock-free MPSC queue and get a
+ * future back.
+ * Each cycle the bus thread drains the queue, merges every request for the
+ * same register block into a single SYNC_READ and answers all of them from
+ * it. Writes are merged the same way into one SYNC_WRITE per block, the
+ * latest value winning per servo, and go out before the cycle's reads.
+ * Control groups always run; diagnostic-only groups run while the
+ * per-cycle budget allows and are otherwise carried over to the next cycle.
+ */
+class ServoBus
+{
+public:
+    static constexpr size_t MAX_WRITE_SIZE = 4;
+    static constexpr size_t QUEUE_CAPACITY = 1024;   // Requests waiting at most; beyond it they fail at once
+
+    /**
+     * @brief Counters describing bus activity since construction
+     */
+    struct Stats
+    {
+        uint64_t cycles = 0;
+        uint64_t requests = 0;
+        uint64_t sync_reads = 0;
+        uint64_t sync_writes = 0;
+        uint64_t deferred = 0;        // Diagnostic groups pushed to a later cycle
+        uint64_t busy_ns = 0;         // Time spent serving cycles; its growth rate is the bus utilisation
+        bool steady = false;          // Fault counts below are valid
+        long minor_faults = 0;        // Page faults on the bus thread in steady state
+        long major_faults = 0;
+    };
+
+    /**
+     * @brief Starts the bus-owner thread
+     * @param link Connection the bus thread has exclusive use of
+     * @param rt Real-time settings applied to the bus thread, if enabled
+     * @param thread_index Acquisition thread index used for CPU selection
+     * @param max_sync_reads_per_cycle Budget shared by all groups in a cycle
+     * @throws std::runtime_error if the real-time settings cannot be applied
+     */
+    ServoBus(ArmLink& link, const RealtimeConfig& rt = RealtimeConfig(), size_t thread_index = 0,
+             size_t max_sync_reads_per_cycle = 4);
+
+    /**
+     * @brief Stops the bus thread; outstanding requests get an error reply
+     */
+    ~ServoBus();
+
+    ServoBus(const ServoBus&) = delete;
+    ServoBus& operator=(const ServoBus&) = delete;
+
+    /**
+     * @brief Queues a register read; safe to call from any thread
+     * @param servo_id Servo to read from
+     * @param address First register address
+     * @param size Number of bytes to read
+     * @param priority Traffic class of the request
+     * @return Future resolved with the servo's reply, or an error reply if the queue is full
+     */
+    std::future<ST3215ServoReader::ServoReply> read(uint8_t servo_id, uint8_t address, uint8_t size,
+                                                    BusPriority priority = BusPriority::CONTROL);
+
+    /**
+     * @brief Queues a register write; safe to call from any thread
+     * @param servo_id Servo to write to
+     * @param address First register address
+     * @param data Bytes to write
+     * @param size Number of bytes, at most MAX_WRITE_SIZE
+     * @param priority Traffic class of the request
+     * @return Future resolved once the write has gone out, with empty data, or an error reply if the
+     *         queue is full
+     * @throws std::runtime_error if size exceeds MAX_WRITE_SIZE
+     */
+    std::future<ST3215ServoReader::ServoReply> write(uint8_t servo_id, uint8_t address, const uint8_t* data,
+                                                     uint8_t size, BusPriority priority = BusPriority::CONTROL);
+
+    /**
+     * @brief Snapshot of the bus counters
+     */
+    Stats stats() const;
+
+private:
+    struct Request
+    {
+        uint8_t servo_id = 0;
+        uint8_t address = 0;
+        uint8_t size = 0;
+        BusPriority priority = BusPriority::CONTROL;
+        bool write = false;
+        std::array<uint8_t, MAX_WRITE_SIZE> data{};  // Write payload, kept inline so requests never allocate
+        std::promise<ST3215ServoReader::ServoReply> reply;
+    };
+
+    /**
+     * @brief One merged SYNC_READ or SYNC_WRITE of a cycle
+     */
+    struct Group
+    {
+        bool write = false;
+        uint8_t address = 0;
+        uint8_t size = 0;
+        BusPriority priority = BusPriority::CONTROL;
+        std::vector<uint8_t> ids;
+        std::vector<uint8_t> data;                           // Write payload, size bytes per ID
+        std::vector<ST3215ServoReader::ServoReply> replies;  // One per ID once the group has run
+    };
+
+    std::future<ST3215ServoReader::ServoReply> _submit(Request request);
+
+    void _run(std::promise<void> started);
+    void _drainQueue(std::vector<Request>& pending);
+    void _serveCycle(std::vector<Request>& pending);
+    void _waitForWork();
+
+    ArmLink& _link;
+    RealtimeConfig _rt;
+    size_t _thread_index;
+    size_t _max_sync_reads;
+    MpscQueue<Request> _queue;
+    std::vector<Group> _groups;     // Bus thread only; reused every cycle and only grown, never shrunk
+    std::vector<size_t> _order;     // Bus thread only; _groups indices in the order they are served
+    int _wake_fd;
+    std::atomic<bool> _sleeping;
+    std::atomic<bool> _running;
+
+    std::atomic<uint64_t> _cycles;
+    std::atomic<uint64_t> _requests;
+    std::atomic<uint64_t> _sync_reads;
+    std::atomic<uint64_t> _sync_writes;
+    std::atomic<uint64_t> _deferred;
+    std::atomic<uint64_t> _busy_ns;
+    std::atomic<bool> _steady;
+    std::atomic<long> _minor_faults;
+    std::atomic<long> _major_faults;
+    std::thread _thread;
+};
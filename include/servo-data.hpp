@@ -0,0 +1,25 @@
+#pragma once
+
+#include "clock.hpp"
+#include <cstdint>
+#include <string>
+
+// Structure to hold servo data including min/max values
+struct ServoData
+{
+    uint16_t current = 0;
+    uint16_t min = 4095;
+    uint16_t max = 0;
+    int temperature = -1;  // Celsius, -1 until first diagnostic read
+    uint64_t sequence = 0;        // Arm cycle of the last successful read, 0 if never read
+    Clock::time_point sampled{};  // When the last successful read completed
+    std::string error;
+
+    /**
+     * @brief Returns true if the reading was not refreshed in the given arm cycle
+     */
+    bool staleAt(uint64_t arm_cycle) const
+    {
+        return sequence != arm_cycle;
+    }
+};
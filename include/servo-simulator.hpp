@@ -0,0 +1,126 @@
+#pragma once
+
+#include "clock.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Emulates a bus of ST3215 servos behind a pseudo terminal
+ *
+ * The slave side of the pty can be opened by ST3215ServoReader exactly like a
+ * real /dev/ttyACM device, so the full serial path is exercised without
+ * hardware. Each servo sweeps sinusoidally around its centre position, driven
+ * by the supplied Clock. On a VirtualClock the simulator registers an idle
+ * probe so time never advances while a request is still being answered.
+ */
+class ST3215Simulator
+{
+public:
+    /**
+     * @brief Creates the pty and starts answering requests
+     * @param servo_ids IDs of the servos present on the simulated bus
+     * @param clock Clock the motion model is evaluated against
+     * @throws std::runtime_error if the pseudo terminal cannot be created
+     */
+    explicit ST3215Simulator(const std::vector<uint8_t>& servo_ids = {1, 2, 3, 4, 5, 6},
+                             Clock& clock = Clock::system());
+
+    /**
+     * @brief Stops the responder thread and closes the pty
+     */
+    ~ST3215Simulator();
+
+    ST3215Simulator(const ST3215Simulator&) = delete;
+    ST3215Simulator& operator=(const ST3215Simulator&) = delete;
+
+    /**
+     * @brief Path of the slave side to hand to ST3215ServoReader
+     *
+     * A new path is allocated by each replug().
+     */
+    const std::string& portName() const;
+
+    /**
+     * @brief Emulates pulling the USB cable: the reader's fd is hung up
+     */
+    void unplug();
+
+    /**
+     * @brief Emulates plugging the adapter back in on a fresh pty
+     */
+    void replug();
+
+    /**
+     * @brief Sets the centre and amplitude of a servo's sweep
+     * @param servo_id Servo to configure
+     * @param center Centre position (0-4095)
+     * @param amplitude Peak deviation from the centre in ticks
+     * @param period Duration of one full sweep
+     */
+    void setMotion(uint8_t servo_id, uint16_t center, uint16_t amplitude,
+                   std::chrono::milliseconds period);
+
+    /**
+     * @brief Number of request packets answered so far
+     */
+    uint64_t requestCount() const;
+
+    /**
+     * @brief Returns the Goal Position register of a servo
+     *
+     * A servo that has been sent a goal stops sweeping and reports the goal
+     * as its present position while torque is enabled.
+     */
+    uint16_t goalPosition(uint8_t servo_id);
+
+    /**
+     * @brief Returns the Torque Enable register of a servo
+     */
+    bool torqueEnabled(uint8_t servo_id);
+
+    /**
+     * @brief Clock time at which torque was last disabled on any servo
+     */
+    Clock::time_point lastTorqueDisableTime() const;
+
+private:
+    struct Servo
+    {
+        bool present = false;
+        uint16_t center = 2048;
+        uint16_t amplitude = 0;
+        std::chrono::milliseconds period{2000};
+        bool following = false;  // Set by the first Goal Position write
+        std::array<uint8_t, 256> memory{};
+    };
+
+    void _openPty();
+    void _run();
+    size_t _handleFrames(std::vector<uint8_t>& rx);
+    void _handlePacket(uint8_t id, uint8_t instruction, const uint8_t* params, size_t param_count);
+    void _write(Servo& servo, uint8_t address, const uint8_t* data, size_t size);
+    void _updatePosition(Servo& servo);
+    void _reply(uint8_t id, uint8_t error, const uint8_t* data, size_t size);
+    bool _idle() const;
+
+    int _master_fd;
+    int _slave_fd;
+    std::string _slave_name;
+    std::array<Servo, 256> _servos;
+    std::mutex _mutex;
+    Clock& _clock;
+    VirtualClock* _virtual_clock;
+    size_t _idle_probe;
+    Clock::time_point _start_time;
+    std::atomic<uint64_t> _requests;
+    std::atomic<Clock::duration::rep> _torque_disabled_at;
+    std::atomic<bool> _busy;
+    std::atomic<bool> _running;
+    std::thread _thread;
+};
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "clock.hpp"
+#include "servo-data.hpp"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+/**
+ * @brief Name of the shared memory segment perseus-armd publishes by default
+ */
+extern const char* const DEFAULT_SHARED_STATE_NAME;
+
+/**
+ * @brief Everything a client needs to draw one frame, copied out of shared memory
+ */
+struct StateSnapshot
+{
+    uint64_t sequence = 0;                     // Publish counter, increases by one per cycle
+    Clock::time_point published;               // Daemon's steady clock at publish time
+    std::vector<std::string> ports;            // Port path per arm
+    std::vector<std::string> link_status;      // ArmLink::statusText() per arm
+    std::vector<std::vector<ServoData>> arms;  // Per-joint state per arm
+    std::vector<uint64_t> arm_cycles;          // Completed acquisition cycles per arm
+    bool emergency_stop = false;
+    std::vector<std::string> status_lines;     // Daemon health lines for the UI
+};
+
+/**
+ * @brief Client requests carried back to the daemon through the segment
+ */
+enum SharedCommand : uint32_t
+{
+    COMMAND_RESET_EMERGENCY_STOP = 1u << 0
+};
+
+/**
+ * @brief Fixed layout of the segment; shared by both sides, never allocated directly
+ */
+struct SharedStateLayout;
+
+/**
+ * @brief Daemon side of the shared state segment
+ *
+ * Creates a POSIX shared memory segment and publishes snapshots into it
+ * under a seqlock. publish() never blocks and never allocates, so it can run
+ * on the acquisition thread; readers that catch a write in progress simply
+ * retry. The segment is unlinked when the publisher is destroyed.
+ */
+class SharedStatePublisher
+{
+public:
+    static constexpr size_t MAX_ARMS = 2;
+    static constexpr size_t MAX_JOINTS = 6;
+    static constexpr size_t MAX_STATUS_LINES = 8;
+
+    /**
+     * @brief Creates the segment, replacing one left behind by a dead daemon
+     * @param name shm_open() name, starting with '/'
+     * @throws std::runtime_error if another live daemon owns the name or the
+     *         segment cannot be created
+     */
+    explicit SharedStatePublisher(const std::string& name = DEFAULT_SHARED_STATE_NAME);
+
+    /**
+     * @brief Unmaps and unlinks the segment; attached clients see the daemon vanish
+     */
+    ~SharedStatePublisher();
+
+    SharedStatePublisher(const SharedStatePublisher&) = delete;
+    SharedStatePublisher& operator=(const SharedStatePublisher&) = delete;
+
+    /**
+     * @brief Publishes one cycle's state
+     *
+     * Arms, joints and status lines beyond the MAX_* limits are dropped and
+     * strings are truncated to their fixed field sizes.
+     * @param ports Port path per arm
+     * @param link_status Link status text per arm
+     * @param arms Per-joint state per arm, including each joint's sequence and sample time
+     * @param arm_cycles Completed acquisition cycles per arm
+     * @param emergency_stop Whether the emergency stop is latched
+     * @param status_lines Health lines to show below the joint view
+     * @param now Publish time on the daemon's clock
+     */
+    void publish(const std::vector<std::string>& ports,
+                 const std::vector<std::string>& link_status,
+                 const std::vector<const std::vector<ServoData>*>& arms,
+                 const std::vector<uint64_t>& arm_cycles,
+                 bool emergency_stop,
+                 const std::vector<std::string>& status_lines,
+                 Clock::time_point now);
+
+    /**
+     * @brief Returns and clears the SharedCommand bits set by clients
+     */
+    uint32_t takeCommands();
+
+private:
+    std::string _name;
+    SharedStateLayout* _state;
+};
+
+/**
+ * @brief UI side of the shared state segment
+ *
+ * Attaching and detaching has no effect on the daemon. If the daemon
+ * restarts, the client reattaches to the new segment on the next read.
+ */
+class SharedStateClient
+{
+public:
+    /**
+     * @brief Prepares to attach; no segment needs to exist yet
+     * @param name shm_open() name used by the daemon
+     */
+    explicit SharedStateClient(const std::string& name = DEFAULT_SHARED_STATE_NAME);
+
+    /**
+     * @brief Detaches from the segment
+     */
+    ~SharedStateClient();
+
+    SharedStateClient(const SharedStateClient&) = delete;
+    SharedStateClient& operator=(const SharedStateClient&) = delete;
+
+    /**
+     * @brief Copies a consistent snapshot out of the segment
+     * @param snapshot Filled in on success
+     * @return false if no daemon is publishing under the name, or it is
+     *         stuck mid-publish
+     */
+    bool read(StateSnapshot& snapshot);
+
+    /**
+     * @brief Returns the attached daemon's pid, or -1 when detached
+     */
+    pid_t daemonPid() const;
+
+    /**
+     * @brief Asks the daemon to trigger its emergency stop
+     *
+     * Delivered as SIGUSR1 so the stop runs from the daemon's signal handler
+     * without waiting for its next cycle.
+     * @return false if no daemon is attached
+     */
+    bool requestEmergencyStop();
+
+    /**
+     * @brief Sets SharedCommand bits for the daemon to act on next cycle
+     * @return false if no daemon is attached
+     */
+    bool sendCommand(uint32_t command);
+
+private:
+    bool _attach();
+    void _detach();
+
+    std::string _name;
+    SharedStateLayout* _state;
+};
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Bounded lock-free single-producer single-consumer ring
+ *
+ * Every operation is a handful of atomic loads and stores on preallocated
+ * slots, so neither side ever allocates, blocks or waits for the other.
+ * push() from one thread and pop() from another; pushOverwrite() is the
+ * producer's alternative to push() that makes room by discarding the oldest
+ * element. Because an overwrite can race a pop() reading the same slot, pop()
+ * claims the element with a compare-exchange after copying it and retries if
+ * the producer got there first; T must therefore be trivially copyable.
+ */
+template <typename T>
+class SpscRing
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SpscRing elements are copied while possibly racing");
+
+public:
+    /**
+     * @brief Allocates the slots
+     * @param capacity Elements held at most, rounded up to a power of two
+     */
+    explicit SpscRing(size_t capacity)
+        : _slots(_roundUp(capacity)), _mask(_slots.size() - 1), _head(0), _tail(0)
+    {
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    /**
+     * @brief Appends a value; producer thread only
+     * @return false, leaving the ring unchanged, if it is full
+     */
+    bool push(const T& value)
+    {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) >= _slots.size())
+        {
+            return false;
+        }
+        _slots[head & _mask] = value;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Appends a value, discarding the oldest one if full; producer thread only
+     * @return true if an element was discarded to make room
+     */
+    bool pushOverwrite(const T& value)
+    {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        size_t tail = _tail.load(std::memory_order_acquire);
+        bool discarded = false;
+        if (head - tail >= _slots.size())
+        {
+            // Fails only if the consumer just popped, which makes room as well
+            discarded = _tail.compare_exchange_strong(tail, tail + 1, std::memory_order_acq_rel);
+        }
+        _slots[head & _mask] = value;
+        _head.store(head + 1, std::memory_order_release);
+        return discarded;
+    }
+
+    /**
+     * @brief Removes the oldest value; consumer thread only
+     * @return false if the ring is empty
+     */
+    bool pop(T& out)
+    {
+        size_t tail = _tail.load(std::memory_order_acquire);
+        while (tail != _head.load(std::memory_order_acquire))
+        {
+            out = _slots[tail & _mask];
+            if (_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Elements currently held; a snapshot when called from a third thread
+     */
+    size_t size() const
+    {
+        const size_t tail = _tail.load(std::memory_order_acquire);
+        const size_t head = _head.load(std::memory_order_acquire);
+        return std::min(head - tail, _slots.size());
+    }
+
+    size_t capacity() const
+    {
+        return _slots.size();
+    }
+
+private:
+    static size_t _roundUp(size_t capacity)
+    {
+        size_t rounded = 1;
+        while (rounded < capacity)
+        {
+            rounded <<= 1;
+        }
+        return rounded;
+    }
+
+    std::vector<T> _slots;
+    size_t _mask;
+    alignas(64) std::atomic<size_t> _head;  // Next slot to write; advanced by the producer
+    alignas(64) std::atomic<size_t> _tail;  // Next slot to read; advanced by the consumer, or the producer overwriting
+};
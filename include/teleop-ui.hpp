@@ -0,0 +1,103 @@
+#pragma once
+
+#include "clock.hpp"
+#include "fleet-monitor.hpp"
+#include "joint-history.hpp"
+#include "range-estimator.hpp"
+#include "servo-data.hpp"
+#include "terminal-display.hpp"
+#include <string>
+#include <vector>
+
+/**
+ * @brief Draws a 40 column position bar with min/max markers
+ * @param display Target display
+ * @param y Row to draw on
+ * @param x Column of the opening bracket
+ * @param current Current position (0-4095)
+ * @param min Lowest position seen so far
+ * @param max Highest position seen so far
+ */
+void displayProgressBar(Display &display, int y, int x, uint16_t current, uint16_t min, uint16_t max);
+
+/**
+ * @brief Draws a 40 column coverage heat strip in place of the position bar
+ *
+ * Each column is shaded by how many readings fell in its share of 0-4095,
+ * so gaps in a calibration sweep stand out. The robust bounds are marked
+ * in the min/max colours and the current position is shown in reverse video.
+ * @param display Target display
+ * @param y Row to draw on
+ * @param x Column of the opening bracket
+ * @param range Joint's range estimator
+ * @param current Current position (0-4095)
+ */
+void displayHeatStrip(Display &display, int y, int x, const RangeEstimator &range, uint16_t current);
+
+/**
+ * @brief Draws a joint's recent motion as a sparkline, oldest bucket on the left
+ *
+ * The scale fits the envelopes shown, widened to a minimum span so a still
+ * joint's noise stays flat. A bucket whose envelope is tall is drawn as a
+ * bar, in reverse video when it spans most of the scale, so glitches and
+ * oscillations stand out; empty buckets are left blank.
+ * @param display Target display
+ * @param y Row to draw on
+ * @param x Column of the oldest bucket
+ * @param history Joint's history
+ * @param now Current time
+ */
+void displaySparkline(Display &display, int y, int x, const JointHistory &history, Clock::time_point now);
+
+/**
+ * @brief Returns the directory calibration files are saved to
+ */
+std::string getWorkingDirectory();
+
+/**
+ * @brief Renders one frame of the per-joint view for both arms
+ * @param display Target display
+ * @param arm1_data Six joints of the first arm
+ * @param arm2_data Six joints of the second arm
+ * @param arm1_status Link state shown next to the first arm's heading
+ * @param arm2_status Link state shown next to the second arm's heading
+ * @param extra_lines Additional status lines drawn below the instructions
+ * @param now Current time, used to show each joint's sample age; omitted hides the ages
+ * @param ranges Per-joint range estimators per arm; joints with one get a heat strip
+ * @param histories Per-joint histories per arm; joints with one get a sparkline
+ */
+void displayServoValues(Display &display,
+                        const std::vector<ServoData> &arm1_data,
+                        const std::vector<ServoData> &arm2_data,
+                        const std::string &arm1_status = "",
+                        const std::string &arm2_status = "",
+                        const std::vector<std::string> &extra_lines = {},
+                        Clock::time_point now = Clock::time_point(),
+                        const std::vector<const std::vector<RangeEstimator> *> &ranges = {},
+                        const std::vector<const std::vector<JointHistory> *> &histories = {});
+
+/**
+ * @brief Renders one frame of the fleet summary, one row per arm
+ *
+ * Only the rows that fit on the screen are read from the monitor, so a
+ * frame costs the same however many arms there are.
+ * @param display Target display
+ * @param fleet Arms being sampled
+ * @param selected Arm highlighted for drill-down
+ * @param first First arm shown; moved as needed to keep the selection on screen
+ * @param extra_lines Additional status lines drawn below the table
+ */
+void displayFleetSummary(Display &display, const FleetMonitor &fleet, size_t selected, size_t &first,
+                         const std::vector<std::string> &extra_lines = {});
+
+/**
+ * @brief Number of arm rows displayFleetSummary() fits on the screen
+ * @param display Target display
+ * @param extra_lines Number of status lines drawn below the table
+ */
+size_t fleetPageSize(const Display &display, size_t extra_lines);
+
+/**
+ * @brief Formats the renderer in use and what its frames cost as one status line
+ */
+std::string formatDisplayLine(const Display &display);
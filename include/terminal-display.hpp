@@ -0,0 +1,247 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include <termios.h>
+
+// The ncurses handle types, declared as ncurses does so its function-like
+// macros (clear, erase, refresh...) stay out of every includer
+typedef struct screen SCREEN;
+typedef struct _win_st WINDOW;
+
+/**
+ * @brief Character-cell screen the joint view draws on, with keyboard input
+ *
+ * Drawing only changes a frame being built; present() puts it on the
+ * terminal. Backends count the bytes each frame sent to the terminal where
+ * they can, so the cost of the UI over a remote link can be read off directly.
+ */
+class Display
+{
+public:
+    /**
+     * @brief Colours used by the joint view, white on black unless noted
+     */
+    enum Color : uint8_t
+    {
+        DEFAULT = 0,   // Terminal default colours
+        LOW = 1,       // Blue, lowest position seen
+        HIGH = 2,      // Green, highest position seen
+        CURRENT = 3    // White, current position
+    };
+
+    static constexpr uint8_t DIM = 1 << 0;
+    static constexpr uint8_t REVERSE = 1 << 1;
+
+    // Aggregate so {LOW} or {CURRENT, DIM} can be passed inline; omitted fields are zero
+    struct Style
+    {
+        Color color;
+        uint8_t attributes;   // DIM and REVERSE flags
+    };
+
+    static constexpr int NO_KEY = -1;
+
+    // Keys readKey() reports for escape sequences, beyond the range of plain characters
+    static constexpr int ARROW_UP = 0x100;
+    static constexpr int ARROW_DOWN = 0x101;
+    static constexpr int PAGE_UP = 0x102;
+    static constexpr int PAGE_DOWN = 0x103;
+
+    virtual ~Display() = default;
+
+    /**
+     * @brief Starts a new, blank frame
+     */
+    virtual void beginFrame() = 0;
+
+    /**
+     * @brief Draws text into the frame; anything beyond the screen edge is dropped
+     * @param y Row
+     * @param x Column of the first character
+     * @param text Characters to draw, no control characters
+     * @param style Colour and attributes of every character drawn
+     */
+    virtual void print(int y, int x, const std::string &text, Style style = {DEFAULT, 0}) = 0;
+
+    /**
+     * @brief Sends the frame to the terminal
+     */
+    virtual void present() = 0;
+
+    /**
+     * @brief Returns the next key pressed, or NO_KEY without waiting
+     */
+    virtual int readKey() = 0;
+
+    /**
+     * @brief Waits for and returns the next key pressed
+     */
+    virtual int waitKey() = 0;
+
+    /**
+     * @brief Number of rows on the screen
+     */
+    virtual int rows() const = 0;
+
+    /**
+     * @brief Returns false on terminals that cannot show colour
+     */
+    virtual bool hasColors() const = 0;
+
+    /**
+     * @brief Name shown in the status line
+     */
+    virtual const char *name() const = 0;
+
+    /**
+     * @brief Returns false if the frame byte counts below are not measured
+     */
+    virtual bool countsBytes() const
+    {
+        return true;
+    }
+
+    size_t lastFrameBytes() const;       // Bytes sent by the latest present()
+    double averageFrameBytes() const;    // Smoothed over recent frames
+    uint64_t frames() const;
+
+protected:
+    void _countFrame(size_t bytes);
+
+private:
+    size_t _last_frame_bytes = 0;
+    double _average_frame_bytes = 0.0;
+    uint64_t _frames = 0;
+};
+
+/**
+ * @brief Display drawn through ncurses on the controlling terminal
+ *
+ * curses writes to the output descriptor directly, so its frame bytes can
+ * only be counted from the file offset: they are measured when drawing to a
+ * regular file, as the benchmark does, but not on a terminal.
+ */
+class CursesDisplay : public Display
+{
+public:
+    /**
+     * @brief Starts curses on stdin and stdout
+     * @throws std::runtime_error if the terminal cannot be initialised
+     */
+    CursesDisplay();
+
+    /**
+     * @brief Starts curses on the given streams, e.g. a temporary file for benchmarks
+     * @param terminal Terminal type, as in TERM
+     * @param out Stream the screen is written to
+     * @param in Stream keys are read from
+     * @throws std::runtime_error if the terminal type is unknown
+     */
+    CursesDisplay(const char *terminal, FILE *out, FILE *in);
+
+    /**
+     * @brief Ends curses and restores the terminal
+     */
+    ~CursesDisplay() override;
+
+    CursesDisplay(const CursesDisplay &) = delete;
+    CursesDisplay &operator=(const CursesDisplay &) = delete;
+
+    void beginFrame() override;
+    void print(int y, int x, const std::string &text, Style style = {DEFAULT, 0}) override;
+    void present() override;
+    int readKey() override;
+    int waitKey() override;
+    int rows() const override;
+    bool hasColors() const override;
+    bool countsBytes() const override;
+    const char *name() const override;
+
+private:
+    FILE *_out;
+    SCREEN *_screen;
+    WINDOW *_window;
+    off_t _presented;        // Output offset after the previous frame, -1 if not seekable
+};
+
+/**
+ * @brief Display that writes ANSI escape sequences itself, one write() per frame
+ *
+ * The frame is a grid of compact cells. present() diffs it against what
+ * the terminal already shows and emits only cursor moves, colour changes
+ * and characters for the cells that differ, so a mostly static view costs
+ * a few dozen bytes per frame instead of a full repaint. The screen size
+ * is rechecked every frame and a resize forces one full repaint.
+ */
+class AnsiDisplay : public Display
+{
+public:
+    /**
+     * @brief Switches the terminal to the alternate screen with raw, non-blocking keys
+     * @param out_fd Terminal to draw on
+     * @param in_fd Terminal to read keys from
+     */
+    explicit AnsiDisplay(int out_fd = 1, int in_fd = 0);
+
+    /**
+     * @brief Restores the terminal mode and the normal screen
+     */
+    ~AnsiDisplay() override;
+
+    AnsiDisplay(const AnsiDisplay &) = delete;
+    AnsiDisplay &operator=(const AnsiDisplay &) = delete;
+
+    void beginFrame() override;
+    void print(int y, int x, const std::string &text, Style style = {DEFAULT, 0}) override;
+    void present() override;
+    int readKey() override;
+    int waitKey() override;
+    int rows() const override;
+    bool hasColors() const override;
+    const char *name() const override;
+
+private:
+    struct Cell
+    {
+        char ch = ' ';
+        uint8_t color = DEFAULT;
+        uint8_t attributes = 0;
+
+        bool operator==(const Cell &other) const
+        {
+            return ch == other.ch && color == other.color && attributes == other.attributes;
+        }
+        bool operator!=(const Cell &other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+    void _resize();
+    void _writeAll(const std::string &bytes);
+    void _appendStyle(const Cell &cell);
+
+    int _out_fd;
+    int _in_fd;
+    bool _restore_termios;
+    struct termios _saved_termios;
+    int _rows;
+    int _cols;
+    std::vector<Cell> _frame;     // Being drawn
+    std::vector<Cell> _shown;     // On the terminal
+    bool _repaint;                // Terminal contents unknown, redraw everything
+    std::string _output;          // Reused per frame
+    Cell _pen;                    // Style the terminal is currently set to
+};
+
+/**
+ * @brief Creates the display selected on the command line
+ * @param ansi true for AnsiDisplay, false for CursesDisplay
+ */
+std::unique_ptr<Display> makeDisplay(bool ansi);
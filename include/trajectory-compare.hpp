@@ -0,0 +1,76 @@
+#pragma once
+
+#include "block-runner.hpp"
+#include "recorder.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Valid readings of one joint from a recording, in recording order
+ */
+struct JointTrack
+{
+    std::vector<int64_t> time_ns;   // Wall clock of each reading, per-joint sample offset applied
+    std::vector<float> position;
+};
+
+/**
+ * @brief Splits one arm of a recording into per-joint tracks
+ *
+ * Invalid readings are left out, so a track can have gaps but never
+ * holds a placeholder position.
+ * @param file Recording to read
+ * @param arm Arm index as recorded
+ * @return One track per joint the arm recorded
+ */
+std::vector<JointTrack> extractJointTracks(const RecordingFile& file, size_t arm);
+
+/**
+ * @brief Typical spacing of an arm's records, the median interval between consecutive cycles
+ * @return 0 if the arm has fewer than two records
+ */
+int64_t typicalRecordPeriod(const RecordingFile& file, size_t arm);
+
+/**
+ * @brief Linearly interpolates a track onto a uniform grid
+ *
+ * Grid points before the first or after the last reading hold that reading.
+ * @param track Track to sample
+ * @param start_ns Time of the first grid point
+ * @param period_ns Grid spacing
+ * @param count Grid points to fill
+ * @param out Receives count positions
+ * @return false, leaving out untouched, if the track is empty
+ */
+bool resampleTrack(const JointTrack& track, int64_t start_ns, int64_t period_ns, size_t count, float* out);
+
+/**
+ * @brief Outcome of aligning two equally long trajectories with dynamic time warping
+ */
+struct DtwResult
+{
+    double cost = 0.0;          // Mean absolute position difference along the warping path
+    double direct_cost = 0.0;   // Mean absolute difference without warping, for comparison
+    double mean_lag = 0.0;      // Mean of j - i along the path, in samples; positive if b trails a
+    size_t path_length = 0;
+};
+
+/**
+ * @brief Banded dynamic time warping between two trajectories
+ *
+ * Only cells with |i - j| <= band are evaluated, so the cost is O(n * band)
+ * rather than O(n^2), and a match can never be more than band samples
+ * apart. Each cost matrix row is computed in two passes: the part of the
+ * recurrence that depends only on the previous row runs four cells at a
+ * time, and a scalar pass then folds in the dependency along the row. The
+ * warping path is recovered from one direction byte per cell, taken from
+ * the caller's scratch arena.
+ * @param a First trajectory
+ * @param b Second trajectory, as many samples as a
+ * @param n Samples in each
+ * @param band Largest index offset a match may have
+ * @param scratch Arena for the rows and direction matrix
+ * @return The alignment; all zero if n is 0
+ */
+DtwResult bandedDtw(const float* a, const float* b, size_t n, size_t band, ScratchArena& scratch);
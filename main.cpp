@@ -1,17 +1,33 @@
+#include "acquisition.hpp"
+#include "arm-link.hpp"
+#include "calibration.hpp"
+#include "emergency-stop.hpp"
+#include "fleet-monitor.hpp"
+#include "hotplug-monitor.hpp"
+#include "joint-history.hpp"
+#include "joint-stream.hpp"
+#include "realtime.hpp"
 #include "perseus-arm-teleop.hpp"
+#include "poll-scheduler.hpp"
+#include "recorder.hpp"
+#include "sensor-monitor.hpp"
+#include "serial-ports.hpp"
+#include "servo-bus.hpp"
+#include "servo-simulator.hpp"
+#include "shared-state.hpp"
+#include "teleop-ui.hpp"
 #include <iostream>
 #include <thread>
 #include <filesystem>
 #include <vector>
 #include <algorithm>
-#include <ncurses.h>
 #include <csignal>
 #include <atomic>
-#include <yaml-cpp/yaml.h>
 #include <chrono>
 #include <iomanip>
 #include <sstream>
 #include <fstream>
+#include <memory>
 
 static std::atomic<bool> running(true);
 
@@ -20,24 +36,10 @@ void signalHandler(int signum)
     running = false;
 }
 
-// Find available serial ports
-std::vector<std::string> findSerialPorts()
+// External emergency stop, e.g. `kill -USR1 <pid>` from a watchdog
+void emergencyStopHandler(int signum)
 {
-    std::vector<std::string> ports;
-    const std::filesystem::path dev_path("/dev");
-
-    for (const auto &entry : std::filesystem::directory_iterator(dev_path))
-    {
-        std::string filename = entry.path().filename().string();
-        if (filename.find("ttyUSB") != std::string::npos ||
-            filename.find("ttyACM") != std::string::npos)
-        {
-            ports.push_back(entry.path().string());
-        }
-    }
-
-    std::sort(ports.begin(), ports.end());
-    return ports;
+    EmergencyStop::instance().trigger();
 }
 
 // Let user select ports for both arms
@@ -130,222 +132,306 @@ std::pair<std::string, std::string> selectSerialPorts(const std::vector<std::str
     return {port1, port2};
 }
 
-// Create a colored progress bar string
-void displayProgressBar(WINDOW *win, int y, int x, uint16_t current, uint16_t min, uint16_t max)
+void exportCalibrationData(const std::vector<ServoData> &arm1_data,
+                           const std::vector<ServoData> &arm2_data,
+                           const std::vector<RangeEstimator> &arm1_ranges,
+                           const std::vector<RangeEstimator> &arm2_ranges,
+                           const std::string &port1,
+                           const std::string &port2)
 {
-    // Clamp values to 0-4095
-    current = std::min(current, static_cast<uint16_t>(4095));
-    min = std::min(min, static_cast<uint16_t>(4095));
-    max = std::min(max, static_cast<uint16_t>(4095));
-
-    const size_t barLength = 40;
+    // Create filename with timestamp
+    const std::string timestamp = calibrationTimestamp();
+    const std::string filename = calibrationFileName(timestamp);
 
-    // Calculate positions
-    size_t currentPos = static_cast<size_t>((static_cast<double>(current) / 4095.0) * barLength);
-    size_t minPos = static_cast<size_t>((static_cast<double>(min) / 4095.0) * barLength);
-    size_t maxPos = static_cast<size_t>((static_cast<double>(max) / 4095.0) * barLength);
+    writeCalibrationFile(filename, timestamp, {port1, port2}, {&arm1_data, &arm2_data},
+                         {&arm1_ranges, &arm2_ranges});
 
-    // Print opening bracket
-    mvwaddch(win, y, x, '[');
-    x++;
+    std::cout << "\nCalibration data exported to: " << filename << std::endl;
+}
 
-    // Print bar with colors
-    for (size_t i = 0; i < barLength; i++)
+// Range covered so far over every joint of both arms
+size_t totalCoverage(const std::vector<RangeEstimator> &arm1_ranges, const std::vector<RangeEstimator> &arm2_ranges)
+{
+    size_t covered = 0;
+    for (const auto *ranges : {&arm1_ranges, &arm2_ranges})
     {
-        if (has_colors())
+        for (const auto &range : *ranges)
         {
-            if (i == minPos)
-            {
-                wattron(win, COLOR_PAIR(1)); // Blue for min
-                waddch(win, '#');
-                wattroff(win, COLOR_PAIR(1));
-            }
-            else if (i == maxPos)
-            {
-                wattron(win, COLOR_PAIR(2)); // Green for max
-                waddch(win, '#');
-                wattroff(win, COLOR_PAIR(2));
-            }
-            else if (i < currentPos)
-            {
-                if (i < minPos)
-                {
-                    wattron(win, COLOR_PAIR(3) | A_DIM); // Dimmed white for positions before min
-                    waddch(win, '#');
-                    wattroff(win, COLOR_PAIR(3) | A_DIM);
-                }
-                else
-                {
-                    wattron(win, COLOR_PAIR(3)); // Bright white for current valid position
-                    waddch(win, '#');
-                    wattroff(win, COLOR_PAIR(3));
-                }
-            }
-            else
-            {
-                waddch(win, ' ');
-            }
-        }
-        else
-        {
-            // For non-color displays, still show all positions but with different characters
-            if (i < currentPos)
-            {
-                waddch(win, (i < minPos) ? '.' : '#');
-            }
-            else
-            {
-                waddch(win, ' ');
-            }
+            covered += range.coveredBins();
         }
     }
-
-    // Print closing bracket
-    waddch(win, ']');
+    return covered;
 }
 
-// Structure to hold servo data including min/max values
-struct ServoData
-{
-    uint16_t current = 0;
-    uint16_t min = 4095;
-    uint16_t max = 0;
-    std::string error;
-};
-
-std::string getWorkingDirectory()
+// Calibration progress: how much range has been swept and how long since it last grew
+std::string formatCoverageLine(size_t covered, size_t joints, const ConvergenceDetector &convergence,
+                               bool auto_save, Clock::time_point now)
 {
-    return std::filesystem::current_path().string();
+    std::ostringstream line;
+    line << "Coverage: " << covered << " of " << joints * RangeEstimator::BIN_COUNT << " bins";
+    if (convergence.converged(now))
+    {
+        line << ", converged" << (auto_save ? " - saving" : " - press 's' to save");
+    }
+    else if (convergence.quietFor(now) > Clock::duration::zero())
+    {
+        const double quiet = std::chrono::duration<double>(convergence.quietFor(now)).count();
+        const double period = std::chrono::duration<double>(convergence.quietPeriod()).count();
+        line << std::fixed << std::setprecision(1) << ", no new coverage for " << quiet << " of " << period << " s";
+    }
+    else
+    {
+        line << ", move every joint through its full range";
+    }
+    return line.str();
 }
 
-// Display servo values in ncurses window for both arms
-// Display servo values in ncurses window for both arms
-void displayServoValues(WINDOW *win,
-    const std::vector<ServoData> &arm1_data,
-    const std::vector<ServoData> &arm2_data)
+// Export calibration data, reporting the outcome on the save status row
+void saveCalibration(Display &display,
+                     const std::vector<ServoData> &arm1_data,
+                     const std::vector<ServoData> &arm2_data,
+                     const std::vector<RangeEstimator> &arm1_ranges,
+                     const std::vector<RangeEstimator> &arm2_ranges,
+                     const std::string &port1,
+                     const std::string &port2)
 {
-werase(win);
+    const std::string blank(72, ' ');
+    display.print(25, 0, "Saving calibration data...");
+    display.present();
 
-// Display header
-mvwprintw(win, 0, 0, "Perseus Arms Servo Positions (0-4095)");
-mvwprintw(win, 1, 0, "--------------------------------------------------------");
-
-// Column headers
-mvwprintw(win, 2, 2, "Servo    Current    Min      Max      Range");
-mvwprintw(win, 3, 0, "--------------------------------------------------------");
+    try
+    {
+        exportCalibrationData(arm1_data, arm2_data, arm1_ranges, arm2_ranges, port1, port2);
+        display.print(25, 0, blank);
+        display.print(25, 0, "Calibration data saved successfully! Press any key to continue");
+        display.present();
 
-// Display first arm's servos
-mvwprintw(win, 4, 0, "Arm 1:");
-for (size_t i = 0; i < 6; ++i)
-{
-int row = i + 5;
-const auto &servo = arm1_data[i];
+        // Wait for any key
+        display.waitKey();
 
-if (servo.error.empty())
-{
-mvwprintw(win, row, 2, "%-8d %8u  %8u  %8u  ",
-   static_cast<int>(i + 1),
-   servo.current,
-   servo.min,
-   servo.max);
-displayProgressBar(win, row, 42, servo.current, servo.min, servo.max);
-}
-else
-{
-mvwprintw(win, row, 2, "%d: Error: %s",
-   static_cast<int>(i + 1),
-   servo.error.c_str());
-}
+        // Clear status line
+        display.print(25, 0, blank);
+        display.present();
+    }
+    catch (const std::exception& e)
+    {
+        display.print(25, 0, blank);
+        display.print(25, 0, std::string("Error saving calibration: ") + e.what());
+        display.present();
+        Clock::system().sleepFor(std::chrono::seconds(2));
+
+        // Clear error message
+        display.print(25, 0, blank);
+        display.present();
+    }
 }
 
-mvwprintw(win, 11, 0, "--------------------------------------------------------");
-
-// Display second arm's servos
-mvwprintw(win, 12, 0, "Arm 2:");
-for (size_t i = 0; i < 6; ++i)
+// Thin client: draws whatever perseus-armd publishes. Acquisition keeps
+// running in the daemon whether or not this process is attached.
+int runAttached(const std::string &shm_name, Clock::duration quiet_period, bool auto_save, bool ansi)
 {
-int row = i + 13;
-const auto &servo = arm2_data[i];
-
-if (servo.error.empty())
-{
-mvwprintw(win, row, 2, "%-8d %8u  %8u  %8u  ",
-   static_cast<int>(i + 1),
-   servo.current,
-   servo.min,
-   servo.max);
-displayProgressBar(win, row, 42, servo.current, servo.min, servo.max);
-}
-else
-{
-mvwprintw(win, row, 2, "%-8d Error: %s",
-   static_cast<int>(i + 1),
-   servo.error.c_str());
-}
-}
+    SharedStateClient client(shm_name);
+    StateSnapshot snapshot;
+    std::vector<SampleTracker> trackers(2);
+    std::vector<std::vector<RangeEstimator>> ranges(2, std::vector<RangeEstimator>(6));
+    std::vector<uint64_t> ranged_cycles(2);
+    std::vector<std::vector<JointHistory>> histories(2, std::vector<JointHistory>(6));
+    ConvergenceDetector convergence(quiet_period);
+    bool saved = false;
+    std::vector<ServoData> empty_arm(6);
+    std::unique_ptr<Display> display = makeDisplay(ansi);
+
+    while (running)
+    {
+        const Clock::time_point now = Clock::system().now();
+        const bool attached = client.read(snapshot);
+        if (attached && snapshot.arms.size() >= 2)
+        {
+            std::vector<std::string> status_lines;
+            if (snapshot.emergency_stop)
+            {
+                status_lines.push_back("EMERGENCY STOP ACTIVE - torque disabled on all ports, press 'r' to re-arm");
+            }
+            status_lines.insert(status_lines.end(), snapshot.status_lines.begin(), snapshot.status_lines.end());
+            for (size_t arm = 0; arm < 2; ++arm)
+            {
+                trackers[arm].observe(snapshot.arm_cycles[arm], snapshot.published);
+                observeRanges(ranges[arm], snapshot.arms[arm], snapshot.arm_cycles[arm], ranged_cycles[arm]);
+                observeHistories(histories[arm], snapshot.arms[arm]);
+                status_lines.push_back(formatSampleLine(static_cast<int>(arm + 1), snapshot.arm_cycles[arm],
+                                                        trackers[arm], snapshot.arms[arm], now));
+            }
+            const size_t covered = totalCoverage(ranges[0], ranges[1]);
+            convergence.update(covered, now);
+            status_lines.push_back(formatCoverageLine(covered, 12, convergence, auto_save, now));
+            const auto age = std::chrono::duration_cast<std::chrono::milliseconds>(now - snapshot.published);
+            std::ostringstream attach_status;
+            attach_status << "Attached to perseus-armd pid " << client.daemonPid() << ", cycle "
+                          << snapshot.sequence << ", " << age.count() << " ms old";
+            status_lines.push_back(attach_status.str());
+            status_lines.push_back(formatDisplayLine(*display));
+            displayServoValues(*display, snapshot.arms[0], snapshot.arms[1], snapshot.link_status[0],
+                               snapshot.link_status[1], status_lines, now, {&ranges[0], &ranges[1]},
+                               {&histories[0], &histories[1]});
+
+            if (auto_save && convergence.converged(now))
+            {
+                exportCalibrationData(snapshot.arms[0], snapshot.arms[1], ranges[0], ranges[1], snapshot.ports[0],
+                                      snapshot.ports[1]);
+                saved = true;
+                break;
+            }
+        }
+        else
+        {
+            displayServoValues(*display, empty_arm, empty_arm, "no daemon", "no daemon",
+                               {"Waiting for perseus-armd on " + shm_name + " ..."});
+        }
 
-mvwprintw(win, 19, 0, "--------------------------------------------------------");
+        int ch = display->readKey();
+        if (ch == ' ' || ch == 'x' || ch == 'X')
+        {
+            client.requestEmergencyStop();
+        }
+        else if (ch == 'r' || ch == 'R')
+        {
+            client.sendCommand(COMMAND_RESET_EMERGENCY_STOP);
+        }
+        else if ((ch == 's' || ch == 'S') && attached && snapshot.arms.size() >= 2)
+        {
+            saveCalibration(*display, snapshot.arms[0], snapshot.arms[1], ranges[0], ranges[1], snapshot.ports[0],
+                            snapshot.ports[1]);
+        }
 
-// Add instructions and working directory
-mvwprintw(win, 20, 0, "Instructions:");
-mvwprintw(win, 21, 0, "1. Move both arms through their full range of motion");
-mvwprintw(win, 22, 0, "2. Press 's' to save calibration when done");
-mvwprintw(win, 23, 0, "3. Press Ctrl+C to exit");
-mvwprintw(win, 24, 0, "Save directory: %s", getWorkingDirectory().c_str());
+        Clock::system().sleepFor(std::chrono::milliseconds(50));
+    }
 
-wrefresh(win);
+    display.reset();
+    if (saved)
+    {
+        std::cout << "Coverage converged; calibration saved." << std::endl;
+    }
+    std::cout << "Detached from perseus-armd." << std::endl;
+    return 0;
 }
 
-
-void exportCalibrationData(const std::vector<ServoData> &arm1_data,
-                           const std::vector<ServoData> &arm2_data,
-                           const std::string &port1,
-                           const std::string &port2)
+// Fleet mode: any number of arms, sampled by a worker pool and shown as a
+// summary table; Enter opens the usual per-joint view on an arm's pair.
+int runFleet(const std::vector<std::string> &ports, size_t workers, bool ansi)
 {
-    YAML::Node config;
-
-    // Add metadata
-    auto now = std::chrono::system_clock::now();
-    auto time = std::chrono::system_clock::to_time_t(now);
-    std::stringstream ss;
-    ss << std::put_time(std::localtime(&time), "%Y-%m-%d_%H-%M-%S");
+    Clock &clock = Clock::system();
+    HotplugMonitor hotplug;
+    FleetMonitor::Config config;
+    config.workers = workers;
+    FleetMonitor fleet(ports, config, clock, &hotplug);
+    std::unique_ptr<Display> display = makeDisplay(ansi);
+
+    size_t selected = 0;
+    size_t first = 0;
+    bool drill_down = false;
+    std::vector<ServoData> arm1_data, arm2_data(6);
+    std::vector<std::string> status_lines;
+    while (running)
+    {
+        status_lines.clear();
+        if (EmergencyStop::instance().triggered())
+        {
+            status_lines.push_back("EMERGENCY STOP ACTIVE - torque disabled on all ports, press 'r' to re-arm");
+        }
+        status_lines.push_back(formatDisplayLine(*display));
 
-    config["timestamp"] = ss.str();
-    config["arm1_port"] = port1;
-    config["arm2_port"] = port2;
+        // Arms pair up in the order given, as leader and follower are cabled
+        const size_t pair = selected / 2 * 2;
+        if (drill_down)
+        {
+            const FleetMonitor::ArmSummary summary1 = fleet.summary(pair);
+            fleet.joints(pair, arm1_data);
+            std::string status2 = "none";
+            arm2_data.assign(6, ServoData());
+            if (pair + 1 < fleet.arms())
+            {
+                const FleetMonitor::ArmSummary summary2 = fleet.summary(pair + 1);
+                fleet.joints(pair + 1, arm2_data);
+                status2 = "fleet arm " + std::to_string(pair + 2) + ", " + summary2.port + ", " + summary2.link;
+            }
+            status_lines.push_back("Press 'b' to go back to the fleet summary");
+            displayServoValues(*display, arm1_data, arm2_data,
+                               "fleet arm " + std::to_string(pair + 1) + ", " + summary1.port + ", " + summary1.link,
+                               status2, status_lines, clock.now());
+        }
+        else
+        {
+            displayFleetSummary(*display, fleet, selected, first, status_lines);
+        }
 
-    // Add calibration data for arm 1
-    YAML::Node arm1_node;
-    for (size_t i = 0; i < arm1_data.size(); ++i)
-    {
-        YAML::Node servo;
-        servo["id"] = i + 1;
-        servo["min"] = arm1_data[i].min;
-        servo["max"] = arm1_data[i].max;
-        arm1_node["servos"].push_back(servo);
-    }
-    config["arm1"] = arm1_node;
+        const size_t page = fleetPageSize(*display, status_lines.size());
+        const int ch = display->readKey();
+        if (ch == ' ' || ch == 'x' || ch == 'X')
+        {
+            EmergencyStop::instance().trigger();
+        }
+        else if (ch == 'r' || ch == 'R')
+        {
+            EmergencyStop::instance().reset();
+        }
+        else if (drill_down)
+        {
+            drill_down = !(ch == 'b' || ch == 'B' || ch == 'q' || ch == 0x1b);
+        }
+        else if ((ch == 'j' || ch == Display::ARROW_DOWN) && selected + 1 < fleet.arms())
+        {
+            ++selected;
+        }
+        else if ((ch == 'k' || ch == Display::ARROW_UP) && selected > 0)
+        {
+            --selected;
+        }
+        else if (ch == Display::PAGE_DOWN && fleet.arms() > 0)
+        {
+            selected = std::min(selected + page, fleet.arms() - 1);
+        }
+        else if (ch == Display::PAGE_UP)
+        {
+            selected -= std::min(selected, page);
+        }
+        else if ((ch == '\n' || ch == '\r') && fleet.arms() > 0)
+        {
+            drill_down = true;
+        }
 
-    // Add calibration data for arm 2
-    YAML::Node arm2_node;
-    for (size_t i = 0; i < arm2_data.size(); ++i)
-    {
-        YAML::Node servo;
-        servo["id"] = i + 1;
-        servo["min"] = arm2_data[i].min;
-        servo["max"] = arm2_data[i].max;
-        arm2_node["servos"].push_back(servo);
+        clock.sleepFor(std::chrono::milliseconds(100));
     }
-    config["arm2"] = arm2_node;
-
-    // Create filename with timestamp
-    std::string filename = ss.str() + "_perseus_arm_calibration.yaml";
 
-    // Save to file
-    std::ofstream fout(filename);
-    fout << config;
+    display.reset();
+    std::cout << "Fleet of " << fleet.arms() << " arms stopped." << std::endl;
+    return 0;
+}
 
-    std::cout << "\nCalibration data exported to: " << filename << std::endl;
+void printUsage(const char *argv0)
+{
+    std::cout << "Usage: " << argv0 << " [options] [ARM1_PORT ARM2_PORT]\n"
+              << "  --sim                Use two simulated arms instead of serial ports\n"
+              << "  --rt                 Lock memory, pin and run acquisition under SCHED_FIFO\n"
+              << "                       (exits with 1 if a bus thread page-faults once warmed up)\n"
+              << "  --rt-cpus LIST       CPUs for acquisition threads, e.g. 2,3 or 2-3\n"
+              << "  --rt-priority N      SCHED_FIFO priority (default 80)\n"
+              << "  --auto-save N        Save calibration and exit once no joint has gained range\n"
+              << "                       coverage for N seconds\n"
+              << "  --record FILE        Record every arm cycle to FILE\n"
+              << "  --record-policy P    What to do when storage falls behind: block,\n"
+              << "                       drop-oldest, drop-newest (default) or decimate\n"
+              << "  --poll-budget N      Read only N joints per arm each cycle, favouring the\n"
+              << "                       joints that are moving (default: all six)\n"
+              << "  --ansi               Draw with plain ANSI sequences, sending only what changed\n"
+              << "                       in one write per frame, instead of curses\n"
+              << "  --fleet              Monitor every port given (or found) as a fleet summary\n"
+              << "                       with drill-down into each arm pair; --record,\n"
+              << "                       --poll-budget and --rt are not supported with it\n"
+              << "  --workers N          Threads sampling the fleet (default 4)\n"
+              << "  --arms N             Simulated arms with --sim --fleet (default 8)\n"
+              << "  --attach             Show the arms published by a running perseus-armd\n"
+              << "  --shm NAME           Shared memory name used with --attach (default "
+              << DEFAULT_SHARED_STATE_NAME << ")\n";
 }
 
 int main(int argc, char *argv[])
@@ -354,13 +440,165 @@ int main(int argc, char *argv[])
     {
         // Set up signal handling
         signal(SIGINT, signalHandler);
+        signal(SIGUSR1, emergencyStopHandler);
+
+        // Split flags from positional port arguments
+        bool simulate = false;
+        bool attach = false;
+        bool ansi = false;
+        bool fleet = false;
+        size_t fleet_workers = 4;
+        size_t simulated_arms = 8;
+        bool auto_save = false;
+        Clock::duration quiet_period = std::chrono::seconds(10);
+        std::string shm_name = DEFAULT_SHARED_STATE_NAME;
+        std::string record_path;
+        RecordPolicy record_policy = RecordPolicy::DROP_NEWEST;
+        size_t poll_budget = 0;
+        RealtimeConfig rt_config;
+        std::vector<std::string> positional;
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg == "--sim")
+            {
+                simulate = true;
+            }
+            else if (arg == "--rt")
+            {
+                rt_config.enabled = true;
+            }
+            else if (arg == "--rt-cpus" && i + 1 < argc)
+            {
+                rt_config.cpus = parseCpuList(argv[++i]);
+            }
+            else if (arg == "--rt-priority" && i + 1 < argc)
+            {
+                rt_config.priority = std::stoi(argv[++i]);
+            }
+            else if (arg == "--auto-save" && i + 1 < argc)
+            {
+                auto_save = true;
+                quiet_period = std::chrono::seconds(std::max(1, std::stoi(argv[++i])));
+            }
+            else if (arg == "--record" && i + 1 < argc)
+            {
+                record_path = argv[++i];
+            }
+            else if (arg == "--record-policy" && i + 1 < argc)
+            {
+                record_policy = parseRecordPolicy(argv[++i]);
+            }
+            else if (arg == "--poll-budget" && i + 1 < argc)
+            {
+                poll_budget = static_cast<size_t>(std::max(1, std::stoi(argv[++i])));
+            }
+            else if (arg == "--ansi")
+            {
+                ansi = true;
+            }
+            else if (arg == "--fleet")
+            {
+                fleet = true;
+            }
+            else if (arg == "--workers" && i + 1 < argc)
+            {
+                fleet_workers = static_cast<size_t>(std::max(1, std::stoi(argv[++i])));
+            }
+            else if (arg == "--arms" && i + 1 < argc)
+            {
+                simulated_arms = static_cast<size_t>(std::max(1, std::stoi(argv[++i])));
+            }
+            else if (arg == "--attach")
+            {
+                attach = true;
+            }
+            else if (arg == "--shm" && i + 1 < argc)
+            {
+                shm_name = argv[++i];
+            }
+            else if (arg == "--help")
+            {
+                printUsage(argv[0]);
+                return 0;
+            }
+            else if (arg.rfind("--", 0) == 0)
+            {
+                printUsage(argv[0]);
+                return 1;
+            }
+            else
+            {
+                positional.push_back(arg);
+            }
+        }
+
+        if (attach)
+        {
+            return runAttached(shm_name, quiet_period, auto_save, ansi);
+        }
+
+        if (fleet && (!record_path.empty() || poll_budget > 0 || rt_config.enabled))
+        {
+            std::cerr << "--record, --poll-budget and --rt do not apply to --fleet" << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        Clock &clock = Clock::system();
+
+        if (fleet)
+        {
+            std::vector<std::unique_ptr<ST3215Simulator>> simulators;
+            std::vector<std::string> ports = positional;
+            if (simulate)
+            {
+                ports.clear();
+                for (size_t i = 0; i < simulated_arms; ++i)
+                {
+                    simulators.push_back(
+                        std::make_unique<ST3215Simulator>(std::vector<uint8_t>{1, 2, 3, 4, 5, 6}, clock));
+                    ports.push_back(simulators.back()->portName());
+                }
+            }
+            else if (ports.empty())
+            {
+                ports = findSerialPorts();
+            }
+            if (ports.empty())
+            {
+                std::cerr << "No serial ports found for the fleet" << std::endl;
+                return 1;
+            }
+            return runFleet(ports, fleet_workers, ansi);
+        }
+
+        // Lock memory before any large allocations so they are faulted in now
+        if (rt_config.enabled)
+        {
+            lockProcessMemory(rt_config);
+        }
+
+        // Simulated arms answer on pseudo terminals, so everything past
+        // port selection runs unchanged
+        std::unique_ptr<ST3215Simulator> sim1, sim2;
+        if (simulate)
+        {
+            sim1 = std::make_unique<ST3215Simulator>(std::vector<uint8_t>{1, 2, 3, 4, 5, 6}, clock);
+            sim2 = std::make_unique<ST3215Simulator>(std::vector<uint8_t>{1, 2, 3, 4, 5, 6}, clock);
+        }
 
         // Get port paths
         std::string port_path1, port_path2;
-        if (argc > 2)
+        if (simulate)
+        {
+            port_path1 = sim1->portName();
+            port_path2 = sim2->portName();
+        }
+        else if (positional.size() >= 2)
         {
-            port_path1 = argv[1];
-            port_path2 = argv[2];
+            port_path1 = positional[0];
+            port_path2 = positional[1];
         }
         else
         {
@@ -370,124 +608,150 @@ int main(int argc, char *argv[])
             port_path2 = p2;
         }
 
+        // Create the recording before the screen takes over so errors are readable
+        std::unique_ptr<Recorder> recorder;
+        if (!record_path.empty())
+        {
+            recorder = std::make_unique<Recorder>(record_path, record_policy);
+        }
+
         std::cout << "Using serial ports:\nArm 1: " << port_path1
                   << "\nArm 2: " << port_path2 << std::endl;
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+        clock.sleepFor(std::chrono::seconds(1));
 
-        // Initialize ncurses
-        WINDOW *win = initscr();
-        cbreak();
-        noecho();
-        curs_set(0);
-        nodelay(win, TRUE);
-        keypad(win, TRUE);
+        std::unique_ptr<Display> display = makeDisplay(ansi);
 
-        // Initialize colors if terminal supports them
-        if (has_colors())
-        {
-            start_color();
-            init_pair(1, COLOR_BLUE, COLOR_BLACK);  // For min value
-            init_pair(2, COLOR_GREEN, COLOR_BLACK); // For max value
-            init_pair(3, COLOR_WHITE, COLOR_BLACK); // For current value
-        }
-
-        // Initialize servo readers and data storage for both arms
-        ST3215ServoReader reader1(port_path1, 1000000);
-        ST3215ServoReader reader2(port_path2, 1000000);
+        // Initialize servo links and data storage for both arms. Each link
+        // reopens its port in the background if the adapter is replugged.
+        HotplugMonitor hotplug;
+        ArmLink link1(port_path1, 1000000, clock, &hotplug);
+        ArmLink link2(port_path2, 1000000, clock, &hotplug);
         std::vector<ServoData> arm1_data(6);
         std::vector<ServoData> arm2_data(6);
 
+        // Each port gets a bus-owner thread; the UI is just one of its clients.
+        // The bus threads are the acquisition threads pinned in --rt mode.
+        ServoBus bus1(link1, rt_config, 0);
+        ServoBus bus2(link2, rt_config, 1);
+        // With a poll budget, bus time goes to the joints that are moving
+        std::unique_ptr<PollScheduler> scheduler1, scheduler2;
+        if (poll_budget > 0)
+        {
+            PollScheduler::Config poll_config;
+            poll_config.budget = poll_budget;
+            scheduler1 = std::make_unique<PollScheduler>(arm1_data.size(), poll_config);
+            scheduler2 = std::make_unique<PollScheduler>(arm2_data.size(), poll_config);
+        }
+        ArmPoller poller1(bus1, arm1_data, 10, clock, scheduler1.get());
+        ArmPoller poller2(bus2, arm2_data, 10, clock, scheduler2.get());
+        SampleTracker tracker1, tracker2;
+        std::vector<RangeEstimator> ranges1(6), ranges2(6);
+        uint64_t ranged_cycle1 = 0, ranged_cycle2 = 0;
+        std::vector<JointHistory> histories1(6), histories2(6);
+        SensorMonitor sensors1(arm1_data.size(), SensorMonitor::Config());
+        SensorMonitor sensors2(arm2_data.size(), SensorMonitor::Config());
+        ConvergenceDetector convergence(quiet_period);
+        bool saved = false;
+        std::vector<std::string> status_lines;
+
         // Main loop
         while (running)
         {
-            // Read all servo positions from first arm
-            for (uint8_t i = 0; i < 6; ++i)
+            // Read all servo positions from both arms, queueing both before
+            // waiting so the two buses work in parallel
+            poller1.request();
+            poller2.request();
+            poller1.collect();
+            poller2.collect();
+            observeRanges(ranges1, arm1_data, poller1.cycle(), ranged_cycle1);
+            observeRanges(ranges2, arm2_data, poller2.cycle(), ranged_cycle2);
+            observeHistories(histories1, arm1_data);
+            observeHistories(histories2, arm2_data);
+            if (recorder)
             {
-                try
-                {
-                    auto& servo = arm1_data[i];
-                    servo.current = reader1.readPosition(i + 1);
-                    servo.min = std::min(servo.min, servo.current);
-                    servo.max = std::max(servo.max, servo.current);
-                    servo.error.clear();
-                }
-                catch (const std::exception& e)
-                {
-                    arm1_data[i].error = e.what();
-                }
+                const int64_t wall_now = wallClockNanoseconds();
+                const Clock::time_point sampled_now = clock.now();
+                const uint8_t flags = EmergencyStop::instance().triggered() ? ArmRecord::FLAG_EMERGENCY_STOP : 0;
+                recorder->record(makeArmRecord(0, poller1.cycle(), arm1_data, flags, wall_now, sampled_now));
+                recorder->record(makeArmRecord(1, poller2.cycle(), arm2_data, flags, wall_now, sampled_now));
             }
 
-            // Read all servo positions from second arm
-            for (uint8_t i = 0; i < 6; ++i)
+            status_lines.clear();
+            if (EmergencyStop::instance().triggered())
             {
-                try
-                {
-                    auto& servo = arm2_data[i];
-                    servo.current = reader2.readPosition(i + 1);
-                    servo.min = std::min(servo.min, servo.current);
-                    servo.max = std::max(servo.max, servo.current);
-                    servo.error.clear();
-                }
-                catch (const std::exception& e)
-                {
-                    arm2_data[i].error = e.what();
-                }
+                status_lines.push_back("EMERGENCY STOP ACTIVE - torque disabled on all ports, press 'r' to re-arm");
             }
+            const Clock::time_point now = clock.now();
+            tracker1.observe(poller1.cycle(), now);
+            tracker2.observe(poller2.cycle(), now);
+            sensors1.observe(arm1_data, poller1.cycle(), now);
+            sensors2.observe(arm2_data, poller2.cycle(), now);
+            status_lines.push_back(formatTemperatureLine(1, arm1_data));
+            status_lines.push_back(formatTemperatureLine(2, arm2_data));
+            status_lines.push_back(formatSampleLine(1, poller1.cycle(), tracker1, arm1_data, now));
+            status_lines.push_back(formatSampleLine(2, poller2.cycle(), tracker2, arm2_data, now));
+            status_lines.push_back(formatSensorLine({&sensors1, &sensors2}));
+            if (poll_budget > 0)
+            {
+                status_lines.push_back(formatPollLine(1, *scheduler1));
+                status_lines.push_back(formatPollLine(2, *scheduler2));
+            }
+            const size_t covered = totalCoverage(ranges1, ranges2);
+            convergence.update(covered, now);
+            status_lines.push_back(formatCoverageLine(covered, 12, convergence, auto_save, now));
+            if (rt_config.enabled)
+            {
+                status_lines.push_back(formatRealtimeLine(rt_config, {&bus1, &bus2}));
+            }
+            if (recorder)
+            {
+                status_lines.push_back(formatRecorderLine(*recorder));
+            }
+            status_lines.push_back(formatDisplayLine(*display));
 
             // Update display with both arms' data
-            displayServoValues(win, arm1_data, arm2_data);
+            displayServoValues(*display, arm1_data, arm2_data, link1.statusText(), link2.statusText(),
+                               status_lines, now, {&ranges1, &ranges2}, {&histories1, &histories2});
+
+            // A converged session ends itself instead of waiting for the operator
+            if (auto_save && convergence.converged(now))
+            {
+                exportCalibrationData(arm1_data, arm2_data, ranges1, ranges2, port_path1, port_path2);
+                saved = true;
+                break;
+            }
 
             // Handle keyboard input for saving
-            int ch = wgetch(win);
-            if (ch == 's' || ch == 'S')
+            int ch = display->readKey();
+            if (ch == ' ' || ch == 'x' || ch == 'X')
             {
-                mvwprintw(win, 25, 0, "Saving calibration data...");
-                wrefresh(win);
-                
-                try 
-                {
-                    exportCalibrationData(arm1_data, arm2_data, port_path1, port_path2);
-                    mvwprintw(win, 25, 0, "                                                                        ");
-                    mvwprintw(win, 25, 0, "Calibration data saved successfully! Press any key to continue");
-                    wrefresh(win);
-                    
-                    // Wait for any key
-                    nodelay(win, FALSE);  // Switch to blocking mode temporarily
-                    wgetch(win);
-                    nodelay(win, TRUE);   // Switch back to non-blocking
-                    
-                    // Clear status line
-                    mvwprintw(win, 25, 0, "                                                                        ");
-                    wrefresh(win);
-                }
-                catch (const std::exception& e)
-                {
-                    mvwprintw(win, 25, 0, "                                                                        ");
-                    mvwprintw(win, 25, 0, "Error saving calibration: %s", e.what());
-                    wrefresh(win);
-                    std::this_thread::sleep_for(std::chrono::seconds(2));
-                    
-                    // Clear error message
-                    mvwprintw(win, 25, 0, "                                                                        ");
-                    wrefresh(win);
-                }
+                EmergencyStop::instance().trigger();
+            }
+            else if (ch == 'r' || ch == 'R')
+            {
+                EmergencyStop::instance().reset();
+            }
+            else if (ch == 's' || ch == 'S')
+            {
+                saveCalibration(*display, arm1_data, arm2_data, ranges1, ranges2, port_path1, port_path2);
             }
 
             // Delay to prevent overwhelming servos
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            clock.sleepFor(std::chrono::milliseconds(100));
         }
 
         // Clean up
-        endwin();
+        display.reset();
+        if (saved)
+        {
+            std::cout << "Coverage converged; calibration saved." << std::endl;
+        }
+        const bool faulted = reportSteadyStateFaults(rt_config, {&bus1, &bus2});
         std::cout << "Program terminated by user." << std::endl;
-        return 0;
+        return faulted ? 1 : 0;
     }
     catch (const std::exception &e)
     {
-        if (isendwin() == FALSE)
-        {
-            endwin();
-        }
         std::cerr << "Error: " << e.what() << std::endl;
         return 1;
     }
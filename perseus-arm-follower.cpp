@@ -0,0 +1,428 @@
+#include "acquisition.hpp"
+#include "arm-link.hpp"
+#include "calibration.hpp"
+#include "emergency-stop.hpp"
+#include "hotplug-monitor.hpp"
+#include "joint-stream.hpp"
+#include "latency-estimator.hpp"
+#include "metrics.hpp"
+#include "realtime.hpp"
+#include "sample-tracker.hpp"
+#include "sensor-monitor.hpp"
+#include "servo-bus.hpp"
+#include "servo-simulator.hpp"
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <csignal>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+
+// Follower: plays leader joint states received over UDP out to local arms
+// through the bus write path. Follower arm N mirrors leader arm N.
+
+static std::atomic<bool> running(true);
+static std::atomic<bool> rearm_requested(false);
+
+void signalHandler(int signum)
+{
+    running = false;
+}
+
+void emergencyStopHandler(int signum)
+{
+    EmergencyStop::instance().trigger();
+}
+
+void rearmHandler(int signum)
+{
+    rearm_requested = true;
+}
+
+// Clears the stop and powers the arms back up where they stand
+void rearm(std::vector<std::unique_ptr<ServoBus>> &buses, size_t joint_count)
+{
+    EmergencyStop::instance().reset();
+    for (size_t arm = 0; arm < buses.size(); ++arm)
+    {
+        const size_t enabled = enableTorque(*buses[arm], joint_count);
+        std::printf("Re-armed arm %zu: torque on %zu/%zu joints\n", arm + 1, enabled, joint_count);
+    }
+}
+
+void printUsage(const char *argv0)
+{
+    std::cout << "Usage: " << argv0 << " --listen ADDR:PORT [options] [ARM1_PORT [ARM2_PORT]]\n"
+              << "  --listen ADDR:PORT   Local address or multicast group perseus-armd streams to\n"
+              << "  --sim                Drive two simulated arms instead of serial ports\n"
+              << "  --rt                 Lock memory, pin and run the bus threads under SCHED_FIFO\n"
+              << "                       (exits with 1 if a bus thread page-faults once warmed up)\n"
+              << "  --rt-cpus LIST       CPUs for the bus threads, e.g. 2,3 or 2-3\n"
+              << "  --rt-priority N      SCHED_FIFO priority (default 80)\n"
+              << "  --min-delay-ms N     Lower bound of the jitter buffer delay (default 1)\n"
+              << "  --max-delay-ms N     Upper bound of the jitter buffer delay (default 100)\n"
+              << "  --poll-period-ms N   Read back the follower's positions every N ms (default 20);\n"
+              << "                       paused while the emergency stop is active\n"
+              << "  --calibration DIR    Map leader ranges onto the follower's using the newest\n"
+              << "  --leader-calibration DIR\n"
+              << "                       calibration file in each directory; both are reloaded\n"
+              << "                       whenever a new file is saved there\n"
+              << "  --metrics FILE       Rewrite FILE every second with latency, stream and sensor metrics\n"
+              << "                       in Prometheus text format\n"
+              << "SIGUSR1 stops the follower's arms and SIGUSR2 re-arms them, turning torque back on\n"
+              << "with each joint holding its current position. A stop mirrored from\n"
+              << "the leader is released by the leader; a local one only by SIGUSR2.\n";
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        signal(SIGINT, signalHandler);
+        signal(SIGTERM, signalHandler);
+        signal(SIGUSR1, emergencyStopHandler);
+        signal(SIGUSR2, rearmHandler);
+
+        bool simulate = false;
+        RealtimeConfig rt_config;
+        std::string listen_endpoint;
+        std::string calibration_dir;
+        std::string leader_calibration_dir;
+        std::string metrics_path;
+        std::chrono::milliseconds poll_period(20);
+        JitterBuffer::Config jitter_config;
+        std::vector<std::string> positional;
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg == "--sim")
+            {
+                simulate = true;
+            }
+            else if (arg == "--rt")
+            {
+                rt_config.enabled = true;
+            }
+            else if (arg == "--rt-cpus" && i + 1 < argc)
+            {
+                rt_config.cpus = parseCpuList(argv[++i]);
+            }
+            else if (arg == "--rt-priority" && i + 1 < argc)
+            {
+                rt_config.priority = std::stoi(argv[++i]);
+            }
+            else if (arg == "--listen" && i + 1 < argc)
+            {
+                listen_endpoint = argv[++i];
+            }
+            else if (arg == "--min-delay-ms" && i + 1 < argc)
+            {
+                jitter_config.min_delay = std::chrono::milliseconds(std::stoi(argv[++i]));
+            }
+            else if (arg == "--max-delay-ms" && i + 1 < argc)
+            {
+                jitter_config.max_delay = std::chrono::milliseconds(std::stoi(argv[++i]));
+            }
+            else if (arg == "--poll-period-ms" && i + 1 < argc)
+            {
+                poll_period = std::chrono::milliseconds(std::max(1, std::stoi(argv[++i])));
+            }
+            else if (arg == "--calibration" && i + 1 < argc)
+            {
+                calibration_dir = argv[++i];
+            }
+            else if (arg == "--leader-calibration" && i + 1 < argc)
+            {
+                leader_calibration_dir = argv[++i];
+            }
+            else if (arg == "--metrics" && i + 1 < argc)
+            {
+                metrics_path = argv[++i];
+            }
+            else if (arg == "--help")
+            {
+                printUsage(argv[0]);
+                return 0;
+            }
+            else if (arg.rfind("--", 0) == 0)
+            {
+                printUsage(argv[0]);
+                return 1;
+            }
+            else
+            {
+                positional.push_back(arg);
+            }
+        }
+        if (listen_endpoint.empty() || (!simulate && positional.empty()) ||
+            calibration_dir.empty() != leader_calibration_dir.empty())
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        // Lock memory before any large allocations so they are faulted in now
+        if (rt_config.enabled)
+        {
+            lockProcessMemory(rt_config);
+        }
+
+        Clock &clock = Clock::system();
+        std::vector<std::unique_ptr<ST3215Simulator>> simulators;
+        std::vector<std::string> ports = positional;
+        if (simulate)
+        {
+            ports.clear();
+            for (int i = 0; i < 2; ++i)
+            {
+                simulators.push_back(std::make_unique<ST3215Simulator>(std::vector<uint8_t>{1, 2, 3, 4, 5, 6}, clock));
+                ports.push_back(simulators.back()->portName());
+            }
+        }
+        ports.resize(std::min(ports.size(), JointStateFrame::MAX_ARMS));
+
+        JointStateSubscriber subscriber(listen_endpoint, jitter_config);
+        HotplugMonitor hotplug;
+        std::vector<std::unique_ptr<ArmLink>> links;
+        std::vector<std::unique_ptr<ServoBus>> buses;
+        std::vector<const ServoBus *> bus_list;
+        std::vector<std::vector<ServoData>> arm_data(ports.size(), std::vector<ServoData>(JointStateFrame::MAX_JOINTS));
+        std::vector<std::unique_ptr<ArmPoller>> pollers;
+        std::vector<SensorMonitor> sensors;
+        for (size_t i = 0; i < ports.size(); ++i)
+        {
+            links.push_back(std::make_unique<ArmLink>(ports[i], 1000000, clock, &hotplug));
+            buses.push_back(std::make_unique<ServoBus>(*links.back(), rt_config, i));
+            bus_list.push_back(buses.back().get());
+            pollers.push_back(std::make_unique<ArmPoller>(*buses.back(), arm_data[i], 10, clock));
+            sensors.emplace_back(arm_data[i].size(), SensorMonitor::Config());
+            std::cout << "Follower arm " << i + 1 << ": " << ports[i] << std::endl;
+        }
+        std::cout << "Listening for joint states on " << listen_endpoint << std::endl;
+
+        // Recalibrating either side takes effect on the next frame, no restart
+        std::unique_ptr<CalibrationWatcher> calibration, leader_calibration;
+        if (!calibration_dir.empty())
+        {
+            calibration = std::make_unique<CalibrationWatcher>(calibration_dir);
+            leader_calibration = std::make_unique<CalibrationWatcher>(leader_calibration_dir);
+        }
+        std::shared_ptr<const CalibrationTable> follower_table, leader_table;
+        uint64_t reported_rejections = 0;
+
+        JointStateFrame frame;
+        std::vector<std::future<ST3215ServoReader::ServoReply>> writes;
+        uint64_t write_errors = 0;
+        SampleTracker tracker;
+
+        // Commands are timed by the leader's sample stamp, so the lag covers
+        // the whole path: network, jitter buffer, bus and servo response
+        LatencyEstimator latency(ports.size() * JointStateFrame::MAX_JOINTS, LatencyEstimator::Config());
+        Clock::time_point last_report = clock.now();
+
+        // Positions are read back on their own schedule, not per frame, so a
+        // fast stream never queues a sweep behind every write
+        Clock::time_point next_poll = clock.now();
+
+        // A leader stop is ours to release only if nothing triggered the stop since
+        bool stopped_by_leader = false;
+        uint64_t leader_stop_generation = 0;
+        while (running)
+        {
+            if (rearm_requested.exchange(false))
+            {
+                rearm(buses, JointStateFrame::MAX_JOINTS);
+                stopped_by_leader = false;
+            }
+
+            const Clock::time_point waited = clock.now();
+            const auto timeout = next_poll > waited
+                                     ? std::chrono::ceil<std::chrono::milliseconds>(next_poll - waited)
+                                     : std::chrono::milliseconds(0);
+            if (subscriber.receive(frame, std::min(timeout, std::chrono::milliseconds(100))))
+            {
+                // Frames count from 0 but the tracker reserves 0 for "nothing yet"
+                tracker.observe(static_cast<uint64_t>(frame.sequence) + 1, clock.now());
+
+                // Mirror the leader's emergency stop. Its release re-arms us only if
+                // the stop was the leader's; a local stop stays latched until SIGUSR2
+                if (frame.emergency_stop && !EmergencyStop::instance().triggered())
+                {
+                    EmergencyStop::instance().trigger();
+                    stopped_by_leader = true;
+                    leader_stop_generation = EmergencyStop::instance().generation();
+                }
+                else if (!frame.emergency_stop && stopped_by_leader)
+                {
+                    if (EmergencyStop::instance().generation() == leader_stop_generation)
+                    {
+                        rearm(buses, JointStateFrame::MAX_JOINTS);
+                    }
+                    stopped_by_leader = false;
+                }
+
+                // One table snapshot per frame, however often the files change
+                if (calibration)
+                {
+                    auto follower_now = calibration->current();
+                    auto leader_now = leader_calibration->current();
+                    if (follower_now != follower_table || leader_now != leader_table)
+                    {
+                        follower_table = follower_now;
+                        leader_table = leader_now;
+                        std::printf("Calibration: leader %s, follower %s\n",
+                                    leader_table ? leader_table->path.c_str() : "none",
+                                    follower_table ? follower_table->path.c_str() : "none");
+                    }
+                }
+
+                // One write per joint; each bus folds them into a single SYNC_WRITE
+                for (size_t arm = 0; arm < buses.size() && arm < frame.arm_count; ++arm)
+                {
+                    for (size_t joint = 0; joint < frame.joint_count; ++joint)
+                    {
+                        uint16_t position = frame.position(arm, joint);
+                        if (position == JointStateFrame::INVALID_POSITION || frame.emergency_stop)
+                        {
+                            continue;
+                        }
+                        if (leader_table && follower_table)
+                        {
+                            position = mapJointPosition(position, leader_table->joint(arm, joint),
+                                                        follower_table->joint(arm, joint));
+                        }
+                        const uint8_t goal[2] = {static_cast<uint8_t>(position & 0xFF),
+                                                 static_cast<uint8_t>(position >> 8)};
+                        writes.push_back(buses[arm]->write(static_cast<uint8_t>(joint + 1), 0x2A, goal, 2));
+                        latency.addCommand(arm * JointStateFrame::MAX_JOINTS + joint, frame.timestamp_ns, position);
+                    }
+                }
+
+                for (auto &write : writes)
+                {
+                    if (!write.get().error.empty())
+                    {
+                        ++write_errors;
+                    }
+                }
+                writes.clear();
+            }
+
+            // Read back where the follower actually is; nothing moves while stopped
+            const bool poll_due = clock.now() >= next_poll;
+            if (poll_due)
+            {
+                next_poll = std::max(next_poll + poll_period, clock.now());
+            }
+            if (poll_due && !EmergencyStop::instance().triggered())
+            {
+                for (auto &poller : pollers)
+                {
+                    poller->request();
+                }
+                const int64_t wall_now = wallClockNanoseconds();
+                const Clock::time_point now = clock.now();
+                for (size_t arm = 0; arm < pollers.size(); ++arm)
+                {
+                    pollers[arm]->collect();
+                    sensors[arm].observe(arm_data[arm], pollers[arm]->cycle(), now);
+                    for (size_t joint = 0; joint < arm_data[arm].size(); ++joint)
+                    {
+                        const ServoData &servo = arm_data[arm][joint];
+                        if (!servo.staleAt(pollers[arm]->cycle()))
+                        {
+                            const int64_t age_ns =
+                                std::chrono::duration_cast<std::chrono::nanoseconds>(now - servo.sampled).count();
+                            latency.addMeasurement(arm * JointStateFrame::MAX_JOINTS + joint, wall_now - age_ns,
+                                                   servo.current);
+                        }
+                    }
+                }
+            }
+
+            if (clock.now() - last_report >= std::chrono::seconds(1))
+            {
+                last_report = clock.now();
+                const auto stats = subscriber.stats();
+                std::printf("received %llu played %llu lost %llu late %llu restarts %llu jitter %.0f us "
+                            "delay %.0f us write errors %llu | %.1f Hz, missed %llu%s\n",
+                            static_cast<unsigned long long>(stats.received),
+                            static_cast<unsigned long long>(stats.played),
+                            static_cast<unsigned long long>(stats.lost),
+                            static_cast<unsigned long long>(stats.late),
+                            static_cast<unsigned long long>(stats.restarts), stats.jitter_us, stats.delay_us,
+                            static_cast<unsigned long long>(write_errors), tracker.rate(),
+                            static_cast<unsigned long long>(tracker.missed()),
+                            tracker.stale(clock.now()) ? ", STREAM STALE" : "");
+                const LatencyEstimate estimate = latency.estimate();
+                std::printf("%s\n", formatLatencyLine(estimate).c_str());
+                std::vector<const SensorMonitor *> monitors;
+                double flagged = 0.0;
+                double sensor_events[3] = {0.0, 0.0, 0.0};
+                for (const auto &monitor : sensors)
+                {
+                    monitors.push_back(&monitor);
+                    flagged += static_cast<double>(monitor.flagged());
+                    sensor_events[0] += static_cast<double>(monitor.events(SensorMonitor::FROZEN));
+                    sensor_events[1] += static_cast<double>(monitor.events(SensorMonitor::IMPLAUSIBLE));
+                    sensor_events[2] += static_cast<double>(monitor.events(SensorMonitor::TIMING));
+                }
+                std::printf("%s\n", formatSensorLine(monitors).c_str());
+                if (rt_config.enabled)
+                {
+                    std::printf("%s\n", formatRealtimeLine(rt_config, bus_list).c_str());
+                }
+                if (!metrics_path.empty() &&
+                    !writeMetricsFile(metrics_path,
+                                      {{"perseus_follower_latency_valid", estimate.valid ? 1.0 : 0.0,
+                                        "1 if the latency estimate is current"},
+                                       {"perseus_follower_latency_ms", estimate.lag_ms,
+                                        "Leader sample to follower measured position lag"},
+                                       {"perseus_follower_latency_correlation", estimate.correlation,
+                                        "Normalised cross-correlation peak behind the estimate"},
+                                       {"perseus_follower_tracking_rms_ticks", estimate.rms,
+                                        "Follower tracking error with the lag removed"},
+                                       {"perseus_follower_frames_received", static_cast<double>(stats.received), "",
+                                        Metric::COUNTER},
+                                       {"perseus_follower_frames_lost", static_cast<double>(stats.lost), "",
+                                        Metric::COUNTER},
+                                       {"perseus_follower_leader_restarts", static_cast<double>(stats.restarts),
+                                        "Leader restarts the jitter buffer started over for", Metric::COUNTER},
+                                       {"perseus_follower_write_errors", static_cast<double>(write_errors), "",
+                                        Metric::COUNTER},
+                                       {"perseus_follower_stream_rate_hz", tracker.rate(), ""},
+                                       {"perseus_follower_sensor_joints_flagged", flagged,
+                                        "Joints currently reading frozen, implausible or out of time"},
+                                       {"perseus_follower_sensor_frozen_events", sensor_events[0], "", Metric::COUNTER},
+                                       {"perseus_follower_sensor_implausible_events", sensor_events[1], "",
+                                        Metric::COUNTER},
+                                       {"perseus_follower_sensor_timing_events", sensor_events[2], "",
+                                        Metric::COUNTER}}))
+                {
+                    std::printf("Failed to write metrics to %s\n", metrics_path.c_str());
+                }
+                if (calibration &&
+                    calibration->rejected() + leader_calibration->rejected() != reported_rejections)
+                {
+                    reported_rejections = calibration->rejected() + leader_calibration->rejected();
+                    const std::string error = calibration->lastError().empty() ? leader_calibration->lastError()
+                                                                               : calibration->lastError();
+                    std::printf("Calibration files rejected: %llu, last: %s\n",
+                                static_cast<unsigned long long>(reported_rejections), error.c_str());
+                }
+                std::fflush(stdout);
+            }
+        }
+
+        const bool faulted = reportSteadyStateFaults(rt_config, bus_list);
+        std::cout << "perseus-arm-follower stopped." << std::endl;
+        return faulted ? 1 : 0;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
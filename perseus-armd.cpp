@@ -0,0 +1,362 @@
+#include "acquisition.hpp"
+#include "arm-link.hpp"
+#include "emergency-stop.hpp"
+#include "hotplug-monitor.hpp"
+#include "idle-detector.hpp"
+#include "joint-resampler.hpp"
+#include "joint-stream.hpp"
+#include "realtime.hpp"
+#include "recorder.hpp"
+#include "sensor-monitor.hpp"
+#include "serial-ports.hpp"
+#include "servo-bus.hpp"
+#include "servo-simulator.hpp"
+#include "shared-state.hpp"
+#include <iostream>
+#include <vector>
+#include <csignal>
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+// Acquisition daemon: owns both arm ports and publishes their state to
+// shared memory, so UI clients can come and go without touching the
+// control loop's timing.
+
+static std::atomic<bool> running(true);
+
+void signalHandler(int signum)
+{
+    running = false;
+}
+
+// External emergency stop; also how attached clients request one
+void emergencyStopHandler(int signum)
+{
+    EmergencyStop::instance().trigger();
+}
+
+void printUsage(const char *argv0)
+{
+    std::cout << "Usage: " << argv0 << " [options] [ARM1_PORT ARM2_PORT]\n"
+              << "  --sim                Use two simulated arms instead of serial ports\n"
+              << "  --rt                 Lock memory, pin and run acquisition under SCHED_FIFO\n"
+              << "                       (exits with 1 if a bus thread page-faults once warmed up)\n"
+              << "  --rt-cpus LIST       CPUs for acquisition threads, e.g. 2,3 or 2-3\n"
+              << "  --rt-priority N      SCHED_FIFO priority (default 80)\n"
+              << "  --period-ms N        Acquisition cycle period (default 100)\n"
+              << "  --shm NAME           Shared memory name to publish under (default "
+              << DEFAULT_SHARED_STATE_NAME << ")\n"
+              << "  --stream ADDR:PORT   Also send joint states over UDP, e.g. to a multicast\n"
+              << "                       group for perseus-arm-follower\n"
+              << "  --align              With --stream or --record, send and record all joints\n"
+              << "                       interpolated to common instants one period apart instead\n"
+              << "                       of as each sweep read them; adds up to a period of\n"
+              << "                       latency. Aligned records carry FLAG_ALIGNED and the grid\n"
+              << "                       index as their cycle. Shared memory always carries the\n"
+              << "                       raw sweeps\n"
+              << "  --record FILE        Record every arm cycle to FILE\n"
+              << "  --record-policy P    What to do when storage falls behind: block,\n"
+              << "                       drop-oldest, drop-newest (default) or decimate\n"
+              << "  --idle-after S       Drop to a slow keep-alive poll once no joint has moved\n"
+              << "                       for S seconds (default 10, 0 polls at full rate always)\n"
+              << "  --idle-period-ms N   Keep-alive poll period while idle (default 250)\n"
+              << "Without ports or --sim the first two serial ports found are used.\n";
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        signal(SIGINT, signalHandler);
+        signal(SIGTERM, signalHandler);
+        signal(SIGUSR1, emergencyStopHandler);
+
+        bool simulate = false;
+        RealtimeConfig rt_config;
+        std::string shm_name = DEFAULT_SHARED_STATE_NAME;
+        std::chrono::milliseconds period(100);
+        std::chrono::seconds idle_after(10);
+        std::chrono::milliseconds idle_period(250);
+        std::string stream_endpoint;
+        bool align = false;
+        std::string record_path;
+        RecordPolicy record_policy = RecordPolicy::DROP_NEWEST;
+        std::vector<std::string> positional;
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg == "--sim")
+            {
+                simulate = true;
+            }
+            else if (arg == "--rt")
+            {
+                rt_config.enabled = true;
+            }
+            else if (arg == "--rt-cpus" && i + 1 < argc)
+            {
+                rt_config.cpus = parseCpuList(argv[++i]);
+            }
+            else if (arg == "--rt-priority" && i + 1 < argc)
+            {
+                rt_config.priority = std::stoi(argv[++i]);
+            }
+            else if (arg == "--period-ms" && i + 1 < argc)
+            {
+                period = std::chrono::milliseconds(std::max(1, std::stoi(argv[++i])));
+            }
+            else if (arg == "--idle-after" && i + 1 < argc)
+            {
+                idle_after = std::chrono::seconds(std::max(0, std::stoi(argv[++i])));
+            }
+            else if (arg == "--idle-period-ms" && i + 1 < argc)
+            {
+                idle_period = std::chrono::milliseconds(std::max(1, std::stoi(argv[++i])));
+            }
+            else if (arg == "--shm" && i + 1 < argc)
+            {
+                shm_name = argv[++i];
+            }
+            else if (arg == "--stream" && i + 1 < argc)
+            {
+                stream_endpoint = argv[++i];
+            }
+            else if (arg == "--align")
+            {
+                align = true;
+            }
+            else if (arg == "--record" && i + 1 < argc)
+            {
+                record_path = argv[++i];
+            }
+            else if (arg == "--record-policy" && i + 1 < argc)
+            {
+                record_policy = parseRecordPolicy(argv[++i]);
+            }
+            else if (arg == "--help")
+            {
+                printUsage(argv[0]);
+                return 0;
+            }
+            else if (arg.rfind("--", 0) == 0)
+            {
+                printUsage(argv[0]);
+                return 1;
+            }
+            else
+            {
+                positional.push_back(arg);
+            }
+        }
+        if (align && stream_endpoint.empty() && record_path.empty())
+        {
+            std::cerr << "--align only applies to --stream and --record" << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        Clock &clock = Clock::system();
+
+        // Claim the name first so a second daemon fails before opening ports
+        SharedStatePublisher publisher(shm_name);
+
+        std::unique_ptr<JointStatePublisher> stream;
+        if (!stream_endpoint.empty())
+        {
+            stream = std::make_unique<JointStatePublisher>(stream_endpoint);
+        }
+
+        std::unique_ptr<Recorder> recorder;
+        if (!record_path.empty())
+        {
+            recorder = std::make_unique<Recorder>(record_path, record_policy);
+        }
+
+        if (rt_config.enabled)
+        {
+            lockProcessMemory(rt_config);
+        }
+
+        std::unique_ptr<ST3215Simulator> sim1, sim2;
+        if (simulate)
+        {
+            sim1 = std::make_unique<ST3215Simulator>(std::vector<uint8_t>{1, 2, 3, 4, 5, 6}, clock);
+            sim2 = std::make_unique<ST3215Simulator>(std::vector<uint8_t>{1, 2, 3, 4, 5, 6}, clock);
+        }
+
+        // No terminal to ask on, so fall back to the first two ports found
+        std::vector<std::string> ports;
+        if (simulate)
+        {
+            ports = {sim1->portName(), sim2->portName()};
+        }
+        else if (positional.size() >= 2)
+        {
+            ports = {positional[0], positional[1]};
+        }
+        else
+        {
+            ports = findSerialPorts();
+            if (ports.size() < 2)
+            {
+                throw std::runtime_error("Need two serial ports, found " + std::to_string(ports.size()));
+            }
+            ports.resize(2);
+        }
+        std::cout << "perseus-armd publishing on " << shm_name
+                  << (stream ? " and UDP " + stream_endpoint : std::string()) << "\nArm 1: " << ports[0]
+                  << "\nArm 2: " << ports[1] << std::endl;
+
+        HotplugMonitor hotplug;
+        ArmLink link1(ports[0], 1000000, clock, &hotplug);
+        ArmLink link2(ports[1], 1000000, clock, &hotplug);
+        std::vector<ServoData> arm1_data(6);
+        std::vector<ServoData> arm2_data(6);
+        ServoBus bus1(link1, rt_config, 0);
+        ServoBus bus2(link2, rt_config, 1);
+        ArmPoller poller1(bus1, arm1_data, 10, clock);
+        ArmPoller poller2(bus2, arm2_data, 10, clock);
+
+        // Aligned output trails the slowest joint; give up on one that stops
+        // answering after a few cycles rather than stall the stream
+        JointResampler resampler(2, 6, period, 4 * period);
+        AlignedSnapshot aligned;
+        uint64_t grid_index = 0;
+
+        // Idle carts poll just often enough to notice someone picking up an arm
+        IdleDetector::Config idle_config;
+        idle_config.idle_after = idle_after;
+        IdleDetector idle_detector(idle_config);
+        UsageMeter usage;
+        SensorMonitor sensors1(arm1_data.size(), SensorMonitor::Config());
+        SensorMonitor sensors2(arm2_data.size(), SensorMonitor::Config());
+        const bool low_power = idle_after.count() > 0 && idle_period > period;
+        bool idle = false;
+
+        std::vector<std::string> link_status(2);
+        std::vector<uint64_t> arm_cycles(2);
+        std::vector<std::string> status_lines;
+        status_lines.reserve(SharedStatePublisher::MAX_STATUS_LINES);
+
+        // Fixed-rate schedule; a slow cycle shortens the next sleep instead
+        // of shifting every later cycle
+        Clock::time_point next_cycle = clock.now();
+        while (running)
+        {
+            poller1.request();
+            poller2.request();
+            poller1.collect();
+            poller2.collect();
+            if (align)
+            {
+                resampler.observe(0, arm1_data);
+                resampler.observe(1, arm2_data);
+                const int64_t wall_now = wallClockNanoseconds();
+                const Clock::time_point now = clock.now();
+                const uint8_t flags = ArmRecord::FLAG_ALIGNED |
+                                      (EmergencyStop::instance().triggered() ? ArmRecord::FLAG_EMERGENCY_STOP : 0);
+                while (resampler.next(aligned))
+                {
+                    const int64_t age_ns =
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(now - aligned.time).count();
+                    if (stream)
+                    {
+                        stream->publish({&aligned.arms[0], &aligned.arms[1]}, EmergencyStop::instance().triggered(),
+                                        wall_now - age_ns);
+                    }
+                    if (recorder)
+                    {
+                        recorder->record(makeArmRecord(0, grid_index, aligned.arms[0], flags, wall_now - age_ns,
+                                                       aligned.time));
+                        recorder->record(makeArmRecord(1, grid_index, aligned.arms[1], flags, wall_now - age_ns,
+                                                       aligned.time));
+                    }
+                    ++grid_index;
+                }
+            }
+            else if (stream)
+            {
+                stream->publish({&arm1_data, &arm2_data}, EmergencyStop::instance().triggered(),
+                                wallClockNanoseconds());
+            }
+            if (recorder && !align)
+            {
+                const int64_t wall_now = wallClockNanoseconds();
+                const Clock::time_point now = clock.now();
+                const uint8_t flags = EmergencyStop::instance().triggered() ? ArmRecord::FLAG_EMERGENCY_STOP : 0;
+                recorder->record(makeArmRecord(0, poller1.cycle(), arm1_data, flags, wall_now, now));
+                recorder->record(makeArmRecord(1, poller2.cycle(), arm2_data, flags, wall_now, now));
+            }
+
+            if (publisher.takeCommands() & COMMAND_RESET_EMERGENCY_STOP)
+            {
+                EmergencyStop::instance().reset();
+            }
+
+            arm_cycles[0] = poller1.cycle();
+            arm_cycles[1] = poller2.cycle();
+            sensors1.observe(arm1_data, arm_cycles[0], clock.now());
+            sensors2.observe(arm2_data, arm_cycles[1], clock.now());
+            if (low_power)
+            {
+                const Clock::time_point now = clock.now();
+                idle_detector.observe({&arm1_data, &arm2_data}, arm_cycles, now);
+                const bool was_idle = idle;
+                idle = idle_detector.idle(now);
+                if (idle != was_idle)
+                {
+                    std::cout << (idle ? "Arms idle, polling every " + std::to_string(idle_period.count()) + " ms"
+                                       : std::string("Motion detected, polling at full rate"))
+                              << std::endl;
+                }
+                usage.sample(idle, {&bus1, &bus2});
+            }
+
+            link_status[0] = link1.statusText();
+            link_status[1] = link2.statusText();
+            status_lines.clear();
+            status_lines.push_back(formatTemperatureLine(1, arm1_data));
+            status_lines.push_back(formatTemperatureLine(2, arm2_data));
+            status_lines.push_back(formatSensorLine({&sensors1, &sensors2}));
+            if (rt_config.enabled)
+            {
+                status_lines.push_back(formatRealtimeLine(rt_config, {&bus1, &bus2}));
+            }
+            if (align)
+            {
+                const auto skew = std::chrono::duration_cast<std::chrono::microseconds>(resampler.skew());
+                status_lines.push_back("Aligned output: joint skew " + std::to_string(skew.count()) +
+                                       " us, grid points skipped " + std::to_string(resampler.skipped()));
+            }
+            if (recorder)
+            {
+                status_lines.push_back(formatRecorderLine(*recorder));
+            }
+            if (low_power)
+            {
+                status_lines.push_back(formatPowerLine(idle, idle_period, usage));
+            }
+            publisher.publish(ports, link_status, {&arm1_data, &arm2_data}, arm_cycles,
+                              EmergencyStop::instance().triggered(), status_lines, clock.now());
+
+            // Leaving idle takes effect on the very next cycle
+            next_cycle += idle ? std::chrono::duration_cast<Clock::duration>(idle_period) : period;
+            const Clock::time_point now = clock.now();
+            if (next_cycle < now)
+            {
+                next_cycle = now;
+            }
+            clock.sleepFor(next_cycle - now);
+        }
+
+        const bool faulted = reportSteadyStateFaults(rt_config, {&bus1, &bus2});
+        std::cout << "perseus-armd stopped." << std::endl;
+        return faulted ? 1 : 0;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
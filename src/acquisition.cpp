@@ -0,0 +1,270 @@
+#include "acquisition.hpp"
+#include <algorithm>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+bool sampleArm(ST3215ServoReader &reader, std::vector<ServoData> &arm_data)
+{
+    for (size_t i = 0; i < arm_data.size(); ++i)
+    {
+        try
+        {
+            updatePosition(arm_data[i], reader.readPosition(static_cast<uint8_t>(i + 1)));
+        }
+        catch (const std::exception& e)
+        {
+            arm_data[i].error = e.what();
+            if (!reader.isConnected())
+            {
+                // Skip the rest of the sweep instead of timing out on each joint
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+PendingReplies requestJoints(ServoBus &bus, size_t joint_count, uint8_t address, uint8_t size,
+                             BusPriority priority)
+{
+    PendingReplies replies;
+    replies.reserve(joint_count);
+    for (size_t i = 0; i < joint_count; ++i)
+    {
+        replies.push_back(bus.read(static_cast<uint8_t>(i + 1), address, size, priority));
+    }
+    return replies;
+}
+
+PendingReplies requestJoints(ServoBus &bus, const std::vector<bool> &selected, uint8_t address, uint8_t size,
+                             BusPriority priority)
+{
+    PendingReplies replies(selected.size());
+    for (size_t i = 0; i < selected.size(); ++i)
+    {
+        if (selected[i])
+        {
+            replies[i] = bus.read(static_cast<uint8_t>(i + 1), address, size, priority);
+        }
+    }
+    return replies;
+}
+
+void applyPositions(PendingReplies &replies, std::vector<ServoData> &arm_data, uint64_t cycle,
+                    Clock::time_point now)
+{
+    for (size_t i = 0; i < replies.size() && i < arm_data.size(); ++i)
+    {
+        if (!replies[i].valid())
+        {
+            continue;
+        }
+        auto reply = replies[i].get();
+        if (reply.error.empty() && reply.data.size() >= 2)
+        {
+            // Position is in little-endian format
+            updatePosition(arm_data[i],
+                           static_cast<uint16_t>(reply.data[0]) | (static_cast<uint16_t>(reply.data[1]) << 8),
+                           cycle, reply.completed != Clock::time_point() ? reply.completed : now);
+        }
+        else
+        {
+            arm_data[i].error = reply.error.empty() ? "Short reply" : reply.error;
+        }
+    }
+}
+
+bool applyTemperatures(PendingReplies &replies, std::vector<ServoData> &arm_data)
+{
+    bool done = true;
+    for (size_t i = 0; i < replies.size() && i < arm_data.size(); ++i)
+    {
+        if (!replies[i].valid())
+        {
+            continue;
+        }
+        if (replies[i].wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            done = false;
+            continue;
+        }
+        auto reply = replies[i].get();
+        if (reply.error.empty() && !reply.data.empty())
+        {
+            arm_data[i].temperature = reply.data[0];
+        }
+    }
+    return done;
+}
+
+void updatePosition(ServoData &servo, uint16_t position, uint64_t sequence, Clock::time_point sampled)
+{
+    servo.current = position;
+    servo.sequence = sequence;
+    servo.sampled = sampled;
+    servo.min = std::min(servo.min, servo.current);
+    servo.max = std::max(servo.max, servo.current);
+    servo.error.clear();
+}
+
+void observeRanges(std::vector<RangeEstimator> &ranges, const std::vector<ServoData> &arm_data, uint64_t cycle,
+                   uint64_t &last_cycle)
+{
+    if (cycle == last_cycle)
+    {
+        return;
+    }
+    last_cycle = cycle;
+    for (size_t i = 0; i < ranges.size() && i < arm_data.size(); ++i)
+    {
+        if (!arm_data[i].staleAt(cycle))
+        {
+            ranges[i].add(arm_data[i].current);
+        }
+    }
+}
+
+size_t enableTorque(ServoBus &bus, size_t joint_count)
+{
+    PendingReplies positions = requestJoints(bus, joint_count, 0x38, 2);
+    PendingReplies goals;
+    std::vector<uint8_t> holding;
+    for (size_t i = 0; i < positions.size(); ++i)
+    {
+        const ST3215ServoReader::ServoReply reply = positions[i].get();
+        if (reply.error.empty() && reply.data.size() == 2)
+        {
+            holding.push_back(static_cast<uint8_t>(i + 1));
+            goals.push_back(bus.write(holding.back(), 0x2A, reply.data.data(), 2));
+        }
+    }
+
+    // Torque goes on only once the servo holds its own position as the goal
+    const uint8_t on = 1;
+    PendingReplies torque;
+    for (size_t i = 0; i < goals.size(); ++i)
+    {
+        if (goals[i].get().error.empty())
+        {
+            torque.push_back(bus.write(holding[i], 0x28, &on, 1));
+        }
+    }
+    size_t enabled = 0;
+    for (auto &reply : torque)
+    {
+        enabled += reply.get().error.empty() ? 1 : 0;
+    }
+    return enabled;
+}
+
+ArmPoller::ArmPoller(ServoBus &bus, std::vector<ServoData> &arm_data, size_t diagnostic_interval, Clock &clock,
+                     PollScheduler *scheduler)
+    : _bus(bus), _arm_data(arm_data), _diagnostic_interval(std::max<size_t>(1, diagnostic_interval)),
+      _clock(clock), _scheduler(scheduler), _cycle(0)
+{
+}
+
+void ArmPoller::request()
+{
+    _positions = _scheduler ? requestJoints(_bus, _scheduler->select(), 0x38, 2)
+                            : requestJoints(_bus, _arm_data.size(), 0x38, 2);
+    if (_cycle % _diagnostic_interval == 0 && _temperatures.empty())
+    {
+        _temperatures = requestJoints(_bus, _arm_data.size(), 0x3F, 1, BusPriority::DIAGNOSTIC);
+    }
+}
+
+void ArmPoller::collect()
+{
+    ++_cycle;
+    const Clock::time_point now = _clock.now();
+    applyPositions(_positions, _arm_data, _cycle, now);
+    _positions.clear();
+    if (_scheduler)
+    {
+        _scheduler->observe(_arm_data, _cycle, now);
+    }
+    if (applyTemperatures(_temperatures, _arm_data))
+    {
+        _temperatures.clear();
+    }
+}
+
+uint64_t ArmPoller::cycle() const
+{
+    return _cycle;
+}
+
+std::string formatTemperatureLine(int arm_number, const std::vector<ServoData> &arm_data)
+{
+    std::ostringstream line;
+    line << "Arm " << arm_number << " temperature (C):";
+    for (const auto &servo : arm_data)
+    {
+        line << " " << (servo.temperature < 0 ? std::string("--") : std::to_string(servo.temperature));
+    }
+    return line.str();
+}
+
+std::string formatSampleLine(int arm_number, uint64_t cycle, const SampleTracker &tracker,
+                             const std::vector<ServoData> &arm_data, Clock::time_point now)
+{
+    const size_t stale = std::count_if(arm_data.begin(), arm_data.end(),
+                                       [&](const ServoData &servo) { return servo.staleAt(cycle); });
+    std::ostringstream line;
+    line << "Arm " << arm_number << " samples: cycle " << cycle << ", " << std::fixed << std::setprecision(1)
+         << tracker.rate() << " Hz, missed " << tracker.missed() << ", stale joints " << stale;
+    if (tracker.stale(now))
+    {
+        line << ", NO FRESH DATA";
+    }
+    return line.str();
+}
+
+std::string formatRealtimeLine(const RealtimeConfig &config, const std::vector<const ServoBus *> &buses)
+{
+    std::ostringstream line;
+    line << "RT: SCHED_FIFO " << config.priority;
+    for (size_t i = 0; i < buses.size(); ++i)
+    {
+        auto stats = buses[i]->stats();
+        line << " | bus " << i + 1 << " ";
+        if (stats.steady)
+        {
+            line << "steady-state faults " << stats.minor_faults << " minor, " << stats.major_faults << " major";
+            if (stats.minor_faults != 0 || stats.major_faults != 0)
+            {
+                line << " FAULTING";
+            }
+        }
+        else
+        {
+            line << "warming up";
+        }
+    }
+    return line.str();
+}
+
+bool reportSteadyStateFaults(const RealtimeConfig &config, const std::vector<const ServoBus *> &buses)
+{
+    bool faulted = false;
+    for (size_t i = 0; config.enabled && i < buses.size(); ++i)
+    {
+        const auto stats = buses[i]->stats();
+        if (!stats.steady)
+        {
+            continue;
+        }
+        std::cout << "Steady-state page faults on bus " << i + 1 << " thread: " << stats.minor_faults << " minor, "
+                  << stats.major_faults << " major" << std::endl;
+        if (stats.minor_faults != 0 || stats.major_faults != 0)
+        {
+            std::cerr << "Error: bus " << i + 1
+                      << " thread page-faulted in steady state; real-time latency was not guaranteed" << std::endl;
+            faulted = true;
+        }
+    }
+    return faulted;
+}
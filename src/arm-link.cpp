@@ -0,0 +1,239 @@
+#include "arm-link.hpp"
+#include "acquisition.hpp"
+#include "emergency-stop.hpp"
+#include "serial-ports.hpp"
+#include <unistd.h>
+#include <algorithm>
+#include <sstream>
+
+ArmLink::ArmLink(const std::string& port, unsigned int baud_rate, Clock& clock, HotplugMonitor* monitor)
+    : _port(port), _usb_serial(usbSerialForPort(port)), _baud_rate(baud_rate), _clock(clock),
+      _monitor(monitor), _subscription(0),
+      _reader(std::make_unique<ST3215ServoReader>(port, baud_rate, clock)), _connected(true)
+{
+    if (_monitor)
+    {
+        _subscription = _monitor->subscribe([this](const std::string&) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _device_event = true;
+            _wake.notify_all();
+        });
+    }
+    _thread = std::thread(&ArmLink::_reconnectLoop, this);
+}
+
+ArmLink::~ArmLink()
+{
+    if (_monitor)
+    {
+        _monitor->unsubscribe(_subscription);
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _wake.notify_all();
+    if (_thread.joinable())
+    {
+        _thread.join();
+    }
+}
+
+void ArmLink::sample(std::vector<ServoData>& arm_data)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_connected || !sampleArm(*_reader, arm_data))
+    {
+        if (_connected)
+        {
+            _markDisconnected();
+        }
+        for (auto& servo : arm_data)
+        {
+            servo.error = "Disconnected, waiting for device";
+        }
+        return;
+    }
+
+    bool any_ok = std::any_of(arm_data.begin(), arm_data.end(),
+                              [](const ServoData& servo) { return servo.error.empty(); });
+    if (any_ok && _awaiting_first_sample)
+    {
+        _awaiting_first_sample = false;
+        _last_recovery = _clock.now() - _device_seen_at;
+    }
+}
+
+std::vector<ST3215ServoReader::ServoReply> ArmLink::syncRead(const std::vector<uint8_t>& servo_ids,
+                                                             uint8_t address, uint8_t size)
+{
+    std::vector<ST3215ServoReader::ServoReply> replies;
+    syncRead(servo_ids, address, size, replies);
+    return replies;
+}
+
+void ArmLink::syncRead(const std::vector<uint8_t>& servo_ids, uint8_t address, uint8_t size,
+                       std::vector<ST3215ServoReader::ServoReply>& replies)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::string failure;
+    bool answered = false;
+    if (_connected)
+    {
+        try
+        {
+            _reader->syncRead(servo_ids, address, size, replies);
+            answered = true;
+        }
+        catch (const EmergencyStopError&)
+        {
+            throw;
+        }
+        catch (const std::exception& e)
+        {
+            failure = e.what();
+        }
+        if (!_reader->isConnected())
+        {
+            _markDisconnected();
+        }
+    }
+    if (!_connected)
+    {
+        failure = "Disconnected, waiting for device";
+    }
+
+    if (!answered || !_connected)
+    {
+        replies.resize(servo_ids.size());
+        for (size_t i = 0; i < servo_ids.size(); ++i)
+        {
+            replies[i].id = servo_ids[i];
+            replies[i].data.clear();
+            replies[i].error = failure;
+            replies[i].completed = Clock::time_point();
+        }
+        return;
+    }
+
+    bool any_ok = std::any_of(replies.begin(), replies.end(),
+                              [](const ST3215ServoReader::ServoReply& reply) { return reply.error.empty(); });
+    if (any_ok && _awaiting_first_sample)
+    {
+        _awaiting_first_sample = false;
+        _last_recovery = _clock.now() - _device_seen_at;
+    }
+}
+
+std::string ArmLink::syncWrite(const std::vector<uint8_t>& servo_ids, uint8_t address, uint8_t size,
+                               const std::vector<uint8_t>& data)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_connected)
+    {
+        return "Disconnected, waiting for device";
+    }
+    std::string failure;
+    try
+    {
+        _reader->syncWrite(servo_ids, address, size, data);
+    }
+    catch (const EmergencyStopError&)
+    {
+        throw;
+    }
+    catch (const std::exception& e)
+    {
+        failure = e.what();
+    }
+    if (!_reader->isConnected())
+    {
+        _markDisconnected();
+        failure = "Disconnected, waiting for device";
+    }
+    return failure;
+}
+
+bool ArmLink::connected() const
+{
+    return _connected;
+}
+
+std::string ArmLink::statusText() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::ostringstream ss;
+    ss << (_connected ? "connected" : "DISCONNECTED");
+    if (!_usb_serial.empty())
+    {
+        ss << " sn " << _usb_serial;
+    }
+    if (_reconnects > 0)
+    {
+        ss << ", " << _reconnects << " reconnect(s), last recovery "
+           << std::chrono::duration_cast<std::chrono::milliseconds>(_last_recovery).count() << " ms";
+    }
+    return ss.str();
+}
+
+Clock::duration ArmLink::lastRecoveryTime() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _last_recovery;
+}
+
+void ArmLink::_markDisconnected()
+{
+    // Called with _mutex held
+    _connected = false;
+    _device_seen_at = Clock::time_point();
+    _wake.notify_all();
+}
+
+void ArmLink::_reconnectLoop()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!_stopping)
+    {
+        // Hot-plug events wake us early; the timeout covers systems without
+        // inotify on /dev and udev permission changes we may have missed
+        _wake.wait_for(lock, std::chrono::milliseconds(100),
+                       [this]() { return _stopping || (!_connected && _device_event); });
+        _device_event = false;
+        if (_stopping || _connected)
+        {
+            continue;
+        }
+
+        lock.unlock();
+        std::string port = _usb_serial.empty() ? _port : findPortByUsbSerial(_usb_serial);
+        std::unique_ptr<ST3215ServoReader> reader;
+        Clock::time_point seen_at;
+        if (!port.empty() && ::access(port.c_str(), F_OK) == 0)
+        {
+            seen_at = _clock.now();
+            try
+            {
+                reader = std::make_unique<ST3215ServoReader>(port, _baud_rate, _clock);
+            }
+            catch (const std::exception&)
+            {
+                // Node exists but is not usable yet (udev still applying permissions)
+            }
+        }
+        lock.lock();
+
+        if (!port.empty() && _device_seen_at == Clock::time_point() && seen_at != Clock::time_point())
+        {
+            _device_seen_at = seen_at;
+        }
+        if (reader && reader->isConnected() && !_stopping)
+        {
+            _reader = std::move(reader);
+            _port = port;
+            _connected = true;
+            _awaiting_first_sample = true;
+            ++_reconnects;
+        }
+    }
+}
@@ -0,0 +1,181 @@
+#include "block-runner.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+
+uint64_t packRange(uint64_t begin, uint64_t end)
+{
+    return (begin << 32) | end;
+}
+
+uint64_t rangeBegin(uint64_t range)
+{
+    return range >> 32;
+}
+
+uint64_t rangeEnd(uint64_t range)
+{
+    return range & 0xFFFFFFFFu;
+}
+
+}
+
+void* ScratchArena::allocate(size_t bytes, size_t alignment)
+{
+    while (true)
+    {
+        if (_chunk < _chunks.size())
+        {
+            Chunk& chunk = _chunks[_chunk];
+            const uintptr_t base = reinterpret_cast<uintptr_t>(chunk.data.get());
+            const uintptr_t aligned = (base + _used + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+            if (aligned + bytes <= base + chunk.size)
+            {
+                _used = aligned + bytes - base;
+                return reinterpret_cast<void*>(aligned);
+            }
+            // Move on to the next chunk, allocating one big enough if there is none
+            ++_chunk;
+            _used = 0;
+            continue;
+        }
+        const size_t size = std::max(DEFAULT_CHUNK_BYTES, bytes + alignment);
+        _chunks.push_back({std::make_unique<unsigned char[]>(size), size});
+        _chunk = _chunks.size() - 1;
+        _used = 0;
+    }
+}
+
+void ScratchArena::reset()
+{
+    _chunk = 0;
+    _used = 0;
+}
+
+size_t ScratchArena::capacity() const
+{
+    size_t total = 0;
+    for (const auto& chunk : _chunks)
+    {
+        total += chunk.size;
+    }
+    return total;
+}
+
+BlockRunner::BlockRunner(size_t threads)
+    : _threads(std::max<size_t>(1, threads ? threads : std::thread::hardware_concurrency())), _shares(_threads),
+      _arenas(_threads), _steals(_threads)
+{
+}
+
+const BlockRunner::Stats& BlockRunner::stats() const
+{
+    return _stats;
+}
+
+size_t BlockRunner::threads() const
+{
+    return _threads;
+}
+
+void BlockRunner::_execute(size_t block_count, Task& task)
+{
+    if (block_count > 0xFFFFFFFFu)
+    {
+        throw std::runtime_error("Too many blocks for one run: " + std::to_string(block_count));
+    }
+
+    // Contiguous shares, so each worker starts out reading its own stretch in order
+    for (size_t w = 0; w < _threads; ++w)
+    {
+        _shares[w].range.store(packRange(block_count * w / _threads, block_count * (w + 1) / _threads));
+        _steals[w].store(0);
+    }
+
+    _stats = Stats();
+    _stats.workers = _threads;
+    _stats.blocks = block_count;
+    _stats.per_worker.assign(_threads, 0);
+
+    std::vector<std::thread> workers;
+    for (size_t w = 1; w < _threads; ++w)
+    {
+        workers.emplace_back(&BlockRunner::_work, this, w, std::ref(task));
+    }
+    _work(0, task);
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    for (size_t w = 0; w < _threads; ++w)
+    {
+        _stats.steals += _steals[w].load();
+    }
+}
+
+void BlockRunner::_work(size_t worker, Task& task)
+{
+    ScratchArena& arena = _arenas[worker];
+    size_t block;
+    while (_takeOwn(worker, block) || _steal(worker, block))
+    {
+        arena.reset();
+        task(block, arena);
+        ++_stats.per_worker[worker];
+    }
+}
+
+bool BlockRunner::_takeOwn(size_t worker, size_t& block)
+{
+    std::atomic<uint64_t>& share = _shares[worker].range;
+    uint64_t range = share.load(std::memory_order_acquire);
+    while (rangeBegin(range) < rangeEnd(range))
+    {
+        if (share.compare_exchange_weak(range, packRange(rangeBegin(range) + 1, rangeEnd(range)),
+                                        std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            block = rangeBegin(range);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool BlockRunner::_steal(size_t thief, size_t& block)
+{
+    // No new work ever appears, so once every share reads empty the run is over
+    while (true)
+    {
+        size_t victim = _threads;
+        uint64_t victim_range = 0;
+        uint64_t most = 0;
+        for (size_t w = 0; w < _threads; ++w)
+        {
+            const uint64_t range = _shares[w].range.load(std::memory_order_acquire);
+            const uint64_t remaining = rangeEnd(range) - std::min(rangeBegin(range), rangeEnd(range));
+            if (w != thief && remaining > most)
+            {
+                victim = w;
+                victim_range = range;
+                most = remaining;
+            }
+        }
+        if (victim == _threads)
+        {
+            return false;
+        }
+
+        // Take from the back, away from where the owner is working
+        const uint64_t end = rangeEnd(victim_range) - 1;
+        if (_shares[victim].range.compare_exchange_strong(victim_range, packRange(rangeBegin(victim_range), end),
+                                                          std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            ++_steals[thief];
+            block = end;
+            return true;
+        }
+    }
+}
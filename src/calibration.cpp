@@ -0,0 +1,323 @@
+#include "calibration.hpp"
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <yaml-cpp/yaml.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+
+const char* const CALIBRATION_SUFFIX = "_perseus_arm_calibration.yaml";
+
+// Narrower than this and a linear map would mostly amplify noise
+const uint16_t MIN_MAPPABLE_RANGE = 32;
+
+uint16_t readPosition(const YAML::Node& servo, const char* key, const char* fallback)
+{
+    const YAML::Node value = servo[key] ? servo[key] : servo[fallback];
+    if (!value)
+    {
+        throw std::runtime_error(std::string("Servo entry without ") + fallback);
+    }
+    const int position = value.as<int>();
+    if (position < 0 || position > 4095)
+    {
+        throw std::runtime_error(std::string(fallback) + " out of range: " + std::to_string(position));
+    }
+    return static_cast<uint16_t>(position);
+}
+
+std::vector<JointCalibration> readArm(const YAML::Node& arm, const std::string& name)
+{
+    if (!arm || !arm["servos"] || !arm["servos"].IsSequence())
+    {
+        throw std::runtime_error("Missing " + name + " servos");
+    }
+
+    std::vector<JointCalibration> joints;
+    for (const auto& servo : arm["servos"])
+    {
+        const int id = servo["id"] ? servo["id"].as<int>() : 0;
+        if (id != static_cast<int>(joints.size()) + 1)
+        {
+            throw std::runtime_error(name + " servo IDs are not 1, 2, 3, ...");
+        }
+        JointCalibration joint;
+        joint.min = readPosition(servo, "robust_min", "min");
+        joint.max = readPosition(servo, "robust_max", "max");
+        joint.valid = joint.max >= joint.min + MIN_MAPPABLE_RANGE;
+        joints.push_back(joint);
+    }
+    return joints;
+}
+
+// Calibration entries for one arm: the raw extremes seen, plus the robust
+// bounds that survive glitched readings
+YAML::Node calibrationNode(const std::vector<ServoData>& arm_data, const std::vector<RangeEstimator>* ranges)
+{
+    YAML::Node arm_node;
+    for (size_t i = 0; i < arm_data.size(); ++i)
+    {
+        YAML::Node servo;
+        servo["id"] = i + 1;
+        servo["min"] = arm_data[i].min;
+        servo["max"] = arm_data[i].max;
+        if (ranges && i < ranges->size() && (*ranges)[i].samples() > 0)
+        {
+            servo["robust_min"] = (*ranges)[i].low();
+            servo["robust_max"] = (*ranges)[i].high();
+            servo["samples"] = (*ranges)[i].samples();
+            servo["rejected"] = (*ranges)[i].rejected();
+        }
+        arm_node["servos"].push_back(servo);
+    }
+    return arm_node;
+}
+
+}
+
+JointCalibration CalibrationTable::joint(size_t arm, size_t joint) const
+{
+    if (arm < arms.size() && joint < arms[arm].size())
+    {
+        return arms[arm][joint];
+    }
+    return JointCalibration();
+}
+
+bool isCalibrationFileName(const std::string& name)
+{
+    const std::string suffix = CALIBRATION_SUFFIX;
+    return name.size() > suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+std::string calibrationTimestamp()
+{
+    const auto time = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    std::stringstream ss;
+    ss << std::put_time(std::localtime(&time), "%Y-%m-%d_%H-%M-%S");
+    return ss.str();
+}
+
+std::string calibrationFileName(const std::string& timestamp)
+{
+    return timestamp + CALIBRATION_SUFFIX;
+}
+
+void writeCalibrationFile(const std::string& path, const std::string& timestamp,
+                          const std::vector<std::string>& ports,
+                          const std::vector<const std::vector<ServoData>*>& arms,
+                          const std::vector<const std::vector<RangeEstimator>*>& ranges)
+{
+    YAML::Node config;
+    config["timestamp"] = timestamp;
+    for (size_t arm = 0; arm < arms.size(); ++arm)
+    {
+        const std::string name = "arm" + std::to_string(arm + 1);
+        config[name + "_port"] = arm < ports.size() ? ports[arm] : std::string();
+    }
+    for (size_t arm = 0; arm < arms.size(); ++arm)
+    {
+        config["arm" + std::to_string(arm + 1)] = calibrationNode(*arms[arm], arm < ranges.size() ? ranges[arm] : nullptr);
+    }
+
+    std::ofstream fout(path);
+    fout << config;
+    if (!fout)
+    {
+        throw std::runtime_error("Failed to write " + path);
+    }
+}
+
+std::string newestCalibrationFile(const std::string& directory)
+{
+    // Names start with a sortable timestamp, so the newest sorts last
+    std::string newest;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error))
+    {
+        const std::string name = entry.path().filename().string();
+        if (isCalibrationFileName(name) && entry.path().string() > newest)
+        {
+            newest = entry.path().string();
+        }
+    }
+    return newest;
+}
+
+CalibrationTable loadCalibrationFile(const std::string& path)
+{
+    YAML::Node config;
+    try
+    {
+        config = YAML::LoadFile(path);
+    }
+    catch (const YAML::Exception& e)
+    {
+        throw std::runtime_error("Failed to parse " + path + ": " + e.what());
+    }
+
+    CalibrationTable table;
+    table.path = path;
+    try
+    {
+        table.timestamp = config["timestamp"] ? config["timestamp"].as<std::string>() : std::string();
+        for (const char* arm : {"arm1", "arm2"})
+        {
+            const std::string port_key = std::string(arm) + "_port";
+            table.ports.push_back(config[port_key] ? config[port_key].as<std::string>() : std::string());
+            table.arms.push_back(readArm(config[arm], arm));
+        }
+    }
+    catch (const YAML::Exception& e)
+    {
+        throw std::runtime_error("Invalid calibration " + path + ": " + e.what());
+    }
+    catch (const std::runtime_error& e)
+    {
+        throw std::runtime_error("Invalid calibration " + path + ": " + e.what());
+    }
+    return table;
+}
+
+uint16_t mapJointPosition(uint16_t position, const JointCalibration& from, const JointCalibration& to)
+{
+    if (!from.valid || !to.valid)
+    {
+        return position;
+    }
+    const double fraction = (static_cast<double>(position) - from.min) / (from.max - from.min);
+    const double mapped = to.min + std::clamp(fraction, 0.0, 1.0) * (to.max - to.min);
+    return static_cast<uint16_t>(mapped + 0.5);
+}
+
+CalibrationWatcher::CalibrationWatcher(const std::string& directory)
+    : _directory(directory), _inotify_fd(-1), _wake_fd(-1), _reloads(0), _rejected(0), _running(true)
+{
+    const std::string newest = newestCalibrationFile(_directory);
+    if (!newest.empty())
+    {
+        _load(newest);
+    }
+
+    // Close-write rather than create: the file is only complete once the
+    // writer closes it. Moved-to covers files written elsewhere and renamed in.
+    _inotify_fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (_inotify_fd >= 0 && ::inotify_add_watch(_inotify_fd, _directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        ::close(_inotify_fd);
+        _inotify_fd = -1;
+    }
+    _wake_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (_inotify_fd >= 0 && _wake_fd >= 0)
+    {
+        _thread = std::thread(&CalibrationWatcher::_run, this);
+    }
+}
+
+CalibrationWatcher::~CalibrationWatcher()
+{
+    _running = false;
+    if (_wake_fd >= 0)
+    {
+        uint64_t one = 1;
+        ssize_t ignored = ::write(_wake_fd, &one, sizeof(one));
+        (void)ignored;
+    }
+    if (_thread.joinable())
+    {
+        _thread.join();
+    }
+    if (_inotify_fd >= 0)
+    {
+        ::close(_inotify_fd);
+    }
+    if (_wake_fd >= 0)
+    {
+        ::close(_wake_fd);
+    }
+}
+
+std::shared_ptr<const CalibrationTable> CalibrationWatcher::current() const
+{
+    return std::atomic_load(&_current);
+}
+
+bool CalibrationWatcher::active() const
+{
+    return _inotify_fd >= 0;
+}
+
+uint64_t CalibrationWatcher::reloads() const
+{
+    return _reloads.load();
+}
+
+uint64_t CalibrationWatcher::rejected() const
+{
+    return _rejected.load();
+}
+
+std::string CalibrationWatcher::lastError() const
+{
+    std::lock_guard<std::mutex> lock(_error_mutex);
+    return _last_error;
+}
+
+void CalibrationWatcher::_run()
+{
+    alignas(struct inotify_event) std::array<char, 4096> buffer;
+
+    while (_running)
+    {
+        struct pollfd fds[2] = {{_inotify_fd, POLLIN, 0}, {_wake_fd, POLLIN, 0}};
+        if (::poll(fds, 2, -1) <= 0 || (fds[1].revents & POLLIN))
+        {
+            continue;
+        }
+
+        ssize_t length = ::read(_inotify_fd, buffer.data(), buffer.size());
+        for (ssize_t offset = 0; offset < length;)
+        {
+            const auto* event = reinterpret_cast<const struct inotify_event*>(buffer.data() + offset);
+            offset += static_cast<ssize_t>(sizeof(struct inotify_event) + event->len);
+            if (event->len > 0 && isCalibrationFileName(event->name))
+            {
+                // Names sort by their timestamp; restoring an old file must not
+                // override a newer calibration
+                const auto active = current();
+                if (!active || event->name >= std::filesystem::path(active->path).filename().string())
+                {
+                    _load(_directory + "/" + event->name);
+                }
+            }
+        }
+    }
+}
+
+void CalibrationWatcher::_load(const std::string& path)
+{
+    try
+    {
+        auto table = std::make_shared<const CalibrationTable>(loadCalibrationFile(path));
+        std::atomic_store(&_current, std::shared_ptr<const CalibrationTable>(std::move(table)));
+        ++_reloads;
+    }
+    catch (const std::runtime_error& e)
+    {
+        ++_rejected;
+        std::lock_guard<std::mutex> lock(_error_mutex);
+        _last_error = e.what();
+    }
+}
@@ -0,0 +1,108 @@
+#include "clock.hpp"
+#include <poll.h>
+#include <algorithm>
+#include <cerrno>
+#include <thread>
+
+Clock& Clock::system()
+{
+    static SystemClock clock;
+    return clock;
+}
+
+Clock::time_point SystemClock::now() const
+{
+    return std::chrono::steady_clock::now();
+}
+
+void SystemClock::sleepFor(duration d)
+{
+    std::this_thread::sleep_for(d);
+}
+
+bool SystemClock::sleepFor(duration d, int wake_fd)
+{
+    if (wake_fd < 0)
+    {
+        sleepFor(d);
+        return true;
+    }
+
+    const auto deadline = now() + d;
+    while (true)
+    {
+        auto remaining = std::max(deadline - now(), duration::zero());
+        auto seconds = std::chrono::duration_cast<std::chrono::seconds>(remaining);
+        struct timespec timeout = {
+            static_cast<time_t>(seconds.count()),
+            static_cast<long>(std::chrono::duration_cast<std::chrono::nanoseconds>(remaining - seconds).count())
+        };
+        struct pollfd pfd = {wake_fd, POLLIN, 0};
+        int ready = ::ppoll(&pfd, 1, &timeout, nullptr);
+        if (ready > 0)
+        {
+            return false;
+        }
+        if (ready == 0 || errno != EINTR)
+        {
+            return true;
+        }
+    }
+}
+
+VirtualClock::VirtualClock(time_point start)
+    : _now(start.time_since_epoch().count())
+{
+}
+
+Clock::time_point VirtualClock::now() const
+{
+    return time_point(duration(_now.load()));
+}
+
+void VirtualClock::sleepFor(duration d)
+{
+    _waitIdle();
+    if (d > duration::zero())
+    {
+        _now.fetch_add(d.count());
+    }
+}
+
+bool VirtualClock::sleepFor(duration d, int)
+{
+    sleepFor(d);
+    return true;
+}
+
+size_t VirtualClock::addIdleProbe(std::function<bool()> probe)
+{
+    std::lock_guard<std::mutex> lock(_probe_mutex);
+    _probes.emplace_back(_next_probe, std::move(probe));
+    return _next_probe++;
+}
+
+void VirtualClock::removeIdleProbe(size_t handle)
+{
+    std::lock_guard<std::mutex> lock(_probe_mutex);
+    _probes.erase(std::remove_if(_probes.begin(), _probes.end(),
+                                 [handle](const auto& entry) { return entry.first == handle; }),
+                  _probes.end());
+}
+
+void VirtualClock::_waitIdle()
+{
+    while (true)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_probe_mutex);
+            bool idle = std::all_of(_probes.begin(), _probes.end(),
+                                    [](const auto& entry) { return entry.second(); });
+            if (idle)
+            {
+                return;
+            }
+        }
+        std::this_thread::yield();
+    }
+}
@@ -0,0 +1,143 @@
+#include "emergency-stop.hpp"
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+#include <thread>
+
+namespace
+{
+
+std::array<uint8_t, 8> makeTorqueDisablePacket()
+{
+    std::array<uint8_t, 8> packet = {
+        0xFF, 0xFF,    // Header
+        0xFE,          // Broadcast ID
+        0x04,          // Length
+        0x03,          // WRITE instruction
+        0x28,          // Torque Enable
+        0x00,          // Disable
+        0x00           // Checksum (to be calculated)
+    };
+    uint8_t checksum = 0;
+    for (size_t i = 2; i < packet.size() - 1; i++)
+    {
+        checksum += packet[i];
+    }
+    packet[packet.size() - 1] = ~checksum;
+    return packet;
+}
+
+}
+
+EmergencyStop& EmergencyStop::instance()
+{
+    static EmergencyStop stop;
+    return stop;
+}
+
+EmergencyStop::EmergencyStop()
+    : _broadcasting(0), _triggered(false), _generation(0), _trigger_time(0),
+      _cancel_fd(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+{
+    for (auto& port : _ports)
+    {
+        port = -1;
+    }
+}
+
+int EmergencyStop::registerPort(int fd)
+{
+    for (size_t i = 0; i < _ports.size(); ++i)
+    {
+        int expected = -1;
+        if (_ports[i].compare_exchange_strong(expected, fd))
+        {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+void EmergencyStop::unregisterPort(int slot)
+{
+    if (slot >= 0 && static_cast<size_t>(slot) < _ports.size())
+    {
+        _ports[slot] = -1;
+
+        // Both sides are sequentially consistent: a trigger() this does not
+        // see counted in has not loaded the slot yet and will find it empty
+        while (_broadcasting.load() != 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void EmergencyStop::trigger() noexcept
+{
+    // clock_gettime is async-signal-safe and matches steady_clock on Linux
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    _trigger_time = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec)).count();
+
+    _triggered = true;
+    ++_generation;
+
+    // Bytes of one write() to a tty are never interleaved with another
+    // writer's, so the packet reaches the bus intact even mid-transaction
+    const auto& packet = torqueDisablePacket();
+    ++_broadcasting;
+    for (auto& port : _ports)
+    {
+        int fd = port.load();
+        if (fd >= 0)
+        {
+            ssize_t ignored = ::write(fd, packet.data(), packet.size());
+            (void)ignored;
+        }
+    }
+    --_broadcasting;
+
+    if (_cancel_fd >= 0)
+    {
+        uint64_t one = 1;
+        ssize_t ignored = ::write(_cancel_fd, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+void EmergencyStop::reset()
+{
+    uint64_t value;
+    while (_cancel_fd >= 0 && ::read(_cancel_fd, &value, sizeof(value)) > 0)
+    {
+    }
+    _triggered = false;
+}
+
+bool EmergencyStop::triggered() const
+{
+    return _triggered;
+}
+
+uint64_t EmergencyStop::generation() const
+{
+    return _generation;
+}
+
+int EmergencyStop::cancelFd() const
+{
+    return _cancel_fd;
+}
+
+Clock::time_point EmergencyStop::lastTriggerTime() const
+{
+    return Clock::time_point(Clock::duration(_trigger_time.load()));
+}
+
+const std::array<uint8_t, 8>& EmergencyStop::torqueDisablePacket()
+{
+    static const std::array<uint8_t, 8> packet = makeTorqueDisablePacket();
+    return packet;
+}
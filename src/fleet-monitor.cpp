@@ -0,0 +1,234 @@
+#include "fleet-monitor.hpp"
+#include "acquisition.hpp"
+#include "emergency-stop.hpp"
+#include <algorithm>
+
+namespace
+{
+
+// Weight of the newest cycle in the smoothed error rate and latency
+const double SMOOTHING = 0.1;
+
+std::vector<ST3215ServoReader::ServoReply> readJoints(ArmLink &link, const std::vector<uint8_t> &ids,
+                                                      uint8_t address, uint8_t size)
+{
+    try
+    {
+        return link.syncRead(ids, address, size);
+    }
+    catch (const EmergencyStopError &e)
+    {
+        std::vector<ST3215ServoReader::ServoReply> replies(ids.size());
+        for (size_t i = 0; i < ids.size(); ++i)
+        {
+            replies[i].id = ids[i];
+            replies[i].error = e.what();
+        }
+        return replies;
+    }
+}
+
+}
+
+FleetMonitor::Arm::Arm(const std::string &port, Clock &clock, HotplugMonitor *monitor)
+    : link(port, 1000000, clock, monitor)
+{
+    summary.port = port;
+}
+
+FleetMonitor::FleetMonitor(const std::vector<std::string> &ports, const Config &config, Clock &clock,
+                           HotplugMonitor *monitor)
+    : _config(config), _clock(clock), _running(true)
+{
+    for (size_t joint = 0; joint < _config.joints; ++joint)
+    {
+        _ids.push_back(static_cast<uint8_t>(joint + 1));
+    }
+    for (const auto &port : ports)
+    {
+        _arms.push_back(std::make_unique<Arm>(port, clock, monitor));
+        _arms.back()->joints.resize(_config.joints);
+    }
+
+    const size_t workers = std::max<size_t>(1, std::min(_config.workers, _arms.size()));
+    for (size_t w = 0; w < workers; ++w)
+    {
+        _workers.push_back(std::make_unique<Worker>());
+    }
+    for (size_t arm = 0; arm < _arms.size(); ++arm)
+    {
+        _workers[arm % workers]->arms.push_back(arm);
+    }
+    for (auto &worker : _workers)
+    {
+        worker->thread = std::thread(&FleetMonitor::_work, this, std::ref(*worker));
+    }
+}
+
+FleetMonitor::~FleetMonitor()
+{
+    _running = false;
+    for (auto &worker : _workers)
+    {
+        if (worker->thread.joinable())
+        {
+            worker->thread.join();
+        }
+    }
+}
+
+size_t FleetMonitor::arms() const
+{
+    return _arms.size();
+}
+
+size_t FleetMonitor::workers() const
+{
+    return _workers.size();
+}
+
+FleetMonitor::ArmSummary FleetMonitor::summary(size_t arm) const
+{
+    std::lock_guard<std::mutex> lock(_arms[arm]->mutex);
+    return _arms[arm]->summary;
+}
+
+void FleetMonitor::joints(size_t arm, std::vector<ServoData> &out) const
+{
+    std::lock_guard<std::mutex> lock(_arms[arm]->mutex);
+    out = _arms[arm]->joints;
+}
+
+FleetMonitor::Totals FleetMonitor::totals() const
+{
+    Totals totals;
+    double error_sum = 0.0;
+    for (const auto &worker : _workers)
+    {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        const Totals &part = worker->totals;
+        totals.arms += part.arms;
+        totals.connected += part.connected;
+        totals.failing += part.failing;
+        totals.rate_hz += part.rate_hz;
+        error_sum += part.error_percent * static_cast<double>(part.arms);
+        totals.worst_latency_ms = std::max(totals.worst_latency_ms, part.worst_latency_ms);
+        totals.hottest = std::max(totals.hottest, part.hottest);
+    }
+    totals.error_percent = totals.arms > 0 ? error_sum / static_cast<double>(totals.arms) : 0.0;
+    return totals;
+}
+
+void FleetMonitor::_work(Worker &worker)
+{
+    uint64_t cycle = 0;
+    Clock::time_point next_cycle = _clock.now();
+    while (_running)
+    {
+        ++cycle;
+        for (size_t arm : worker.arms)
+        {
+            _sample(*_arms[arm], cycle);
+        }
+
+        // Fold this worker's arms into its totals while they are still warm
+        Totals totals;
+        double error_sum = 0.0;
+        for (size_t index : worker.arms)
+        {
+            const Arm &arm = *_arms[index];
+            std::lock_guard<std::mutex> lock(arm.mutex);
+            const ArmSummary &summary = arm.summary;
+            ++totals.arms;
+            totals.connected += summary.connected;
+            totals.failing += summary.error_percent >= 1.0;
+            totals.rate_hz += summary.rate_hz;
+            error_sum += summary.error_percent;
+            totals.worst_latency_ms = std::max(totals.worst_latency_ms, summary.latency_ms);
+            totals.hottest = std::max(totals.hottest, summary.temperature);
+        }
+        totals.error_percent = totals.arms > 0 ? error_sum / static_cast<double>(totals.arms) : 0.0;
+        {
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            worker.totals = totals;
+        }
+
+        // Fixed-rate schedule, as in perseus-armd; an overrun starts the next pass at once
+        next_cycle += _config.period;
+        const Clock::time_point now = _clock.now();
+        if (next_cycle < now)
+        {
+            next_cycle = now;
+        }
+        else
+        {
+            _clock.sleepFor(next_cycle - now);
+        }
+    }
+}
+
+void FleetMonitor::_sample(Arm &arm, uint64_t cycle)
+{
+    const Clock::time_point started = _clock.now();
+    const auto positions = readJoints(arm.link, _ids, 0x38, 2);
+    const Clock::time_point now = _clock.now();
+    std::vector<ST3215ServoReader::ServoReply> temperatures;
+    if (_config.temperature_interval > 0 && (cycle - 1) % _config.temperature_interval == 0)
+    {
+        temperatures = readJoints(arm.link, _ids, 0x3F, 1);
+    }
+    const std::string link = arm.link.statusText();
+    const bool connected = arm.link.connected();
+
+    std::lock_guard<std::mutex> lock(arm.mutex);
+    size_t failed = 0;
+    for (const auto &reply : positions)
+    {
+        if (reply.id == 0 || reply.id > arm.joints.size())
+        {
+            continue;
+        }
+        ServoData &servo = arm.joints[reply.id - 1];
+        if (reply.error.empty() && reply.data.size() >= 2)
+        {
+            updatePosition(servo, static_cast<uint16_t>(reply.data[0] | (reply.data[1] << 8)), cycle,
+                           reply.completed != Clock::time_point() ? reply.completed : now);
+        }
+        else
+        {
+            servo.error = reply.error.empty() ? "Short reply" : reply.error;
+            ++failed;
+        }
+    }
+    for (const auto &reply : temperatures)
+    {
+        if (reply.id > 0 && reply.id <= arm.joints.size() && reply.error.empty() && !reply.data.empty())
+        {
+            arm.joints[reply.id - 1].temperature = reply.data[0];
+        }
+    }
+    if (failed < positions.size())
+    {
+        arm.tracker.observe(cycle, now);
+    }
+
+    ArmSummary &summary = arm.summary;
+    const double error_percent = positions.empty() ? 100.0 : 100.0 * failed / positions.size();
+    const double latency_ms = std::chrono::duration<double, std::milli>(now - started).count();
+    summary.error_percent =
+        summary.cycles == 0 ? error_percent : summary.error_percent + SMOOTHING * (error_percent - summary.error_percent);
+    if (failed < positions.size())
+    {
+        summary.latency_ms =
+            summary.latency_ms == 0.0 ? latency_ms : summary.latency_ms + SMOOTHING * (latency_ms - summary.latency_ms);
+    }
+    summary.cycles = cycle;
+    summary.rate_hz = arm.tracker.stale(now) ? 0.0 : arm.tracker.rate();
+    summary.link = link;
+    summary.connected = connected;
+    summary.temperature = -1;
+    for (const auto &servo : arm.joints)
+    {
+        summary.temperature = std::max(summary.temperature, servo.temperature);
+    }
+}
@@ -0,0 +1,104 @@
+#include "hotplug-monitor.hpp"
+#include "serial-ports.hpp"
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+
+HotplugMonitor::HotplugMonitor(const std::string& dev_dir)
+    : _dev_dir(dev_dir), _inotify_fd(-1), _wake_fd(-1), _running(true)
+{
+    _inotify_fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (_inotify_fd >= 0 &&
+        ::inotify_add_watch(_inotify_fd, _dev_dir.c_str(), IN_CREATE | IN_ATTRIB | IN_MOVED_TO) < 0)
+    {
+        ::close(_inotify_fd);
+        _inotify_fd = -1;
+    }
+    _wake_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (_inotify_fd >= 0 && _wake_fd >= 0)
+    {
+        _thread = std::thread(&HotplugMonitor::_run, this);
+    }
+}
+
+HotplugMonitor::~HotplugMonitor()
+{
+    _running = false;
+    if (_wake_fd >= 0)
+    {
+        uint64_t one = 1;
+        ssize_t ignored = ::write(_wake_fd, &one, sizeof(one));
+        (void)ignored;
+    }
+    if (_thread.joinable())
+    {
+        _thread.join();
+    }
+    if (_inotify_fd >= 0)
+    {
+        ::close(_inotify_fd);
+    }
+    if (_wake_fd >= 0)
+    {
+        ::close(_wake_fd);
+    }
+}
+
+bool HotplugMonitor::active() const
+{
+    return _inotify_fd >= 0;
+}
+
+size_t HotplugMonitor::subscribe(Callback callback)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _callbacks.emplace_back(_next_handle, std::move(callback));
+    return _next_handle++;
+}
+
+void HotplugMonitor::unsubscribe(size_t handle)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _callbacks.erase(std::remove_if(_callbacks.begin(), _callbacks.end(),
+                                    [handle](const auto& entry) { return entry.first == handle; }),
+                     _callbacks.end());
+}
+
+void HotplugMonitor::_run()
+{
+    alignas(struct inotify_event) std::array<char, 4096> buffer;
+
+    while (_running)
+    {
+        struct pollfd fds[2] = {{_inotify_fd, POLLIN, 0}, {_wake_fd, POLLIN, 0}};
+        if (::poll(fds, 2, -1) <= 0 || (fds[1].revents & POLLIN))
+        {
+            continue;
+        }
+
+        ssize_t length = ::read(_inotify_fd, buffer.data(), buffer.size());
+        for (ssize_t offset = 0; offset < length;)
+        {
+            const auto* event = reinterpret_cast<const struct inotify_event*>(buffer.data() + offset);
+            offset += static_cast<ssize_t>(sizeof(struct inotify_event) + event->len);
+
+            // udev creates the node first and fixes its permissions later, so
+            // IN_ATTRIB is forwarded too; subscribers retry the open on each
+            if (event->len == 0 || !isSerialPortName(event->name))
+            {
+                continue;
+            }
+            const std::string path = _dev_dir + "/" + event->name;
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (const auto& entry : _callbacks)
+            {
+                entry.second(path);
+            }
+        }
+    }
+}
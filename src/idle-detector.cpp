@@ -0,0 +1,148 @@
+#include "idle-detector.hpp"
+#include <sys/resource.h>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+
+// User plus system time of the whole process, bus threads included
+double processCpuSeconds()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+           static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+double busBusySeconds(const std::vector<const ServoBus *> &buses)
+{
+    double busy = 0.0;
+    for (const auto *bus : buses)
+    {
+        busy += static_cast<double>(bus->stats().busy_ns) / 1e9;
+    }
+    return busy;
+}
+
+}
+
+IdleDetector::IdleDetector(const Config &config) : _config(config), _last_motion(), _started(false)
+{
+}
+
+bool IdleDetector::observe(const std::vector<const std::vector<ServoData> *> &arms,
+                           const std::vector<uint64_t> &cycles, Clock::time_point now)
+{
+    if (!_started)
+    {
+        // Count from the first look rather than from the clock's epoch
+        _last_motion = now;
+        _started = true;
+    }
+    if (_anchors.size() < arms.size())
+    {
+        _anchors.resize(arms.size());
+    }
+
+    bool moved = false;
+    for (size_t arm = 0; arm < arms.size() && arm < cycles.size(); ++arm)
+    {
+        const auto &arm_data = *arms[arm];
+        auto &anchors = _anchors[arm];
+        if (anchors.size() < arm_data.size())
+        {
+            anchors.resize(arm_data.size());
+        }
+        for (size_t joint = 0; joint < arm_data.size(); ++joint)
+        {
+            const ServoData &servo = arm_data[joint];
+            if (servo.staleAt(cycles[arm]) || !servo.error.empty())
+            {
+                continue;
+            }
+            Anchor &anchor = anchors[joint];
+            if (!anchor.set)
+            {
+                anchor.set = true;
+                anchor.position = servo.current;
+            }
+            else if (std::abs(static_cast<int>(servo.current) - static_cast<int>(anchor.position)) >
+                     _config.deadband)
+            {
+                anchor.position = servo.current;
+                moved = true;
+            }
+        }
+    }
+    if (moved)
+    {
+        _last_motion = now;
+    }
+    return moved;
+}
+
+bool IdleDetector::idle(Clock::time_point now) const
+{
+    return _started && now - _last_motion >= _config.idle_after;
+}
+
+UsageMeter::UsageMeter()
+    : _idle(false), _bus_count(0), _last_wall(std::chrono::steady_clock::now()), _last_cpu_s(processCpuSeconds()),
+      _last_bus_s(0.0)
+{
+}
+
+void UsageMeter::sample(bool idle, const std::vector<const ServoBus *> &buses)
+{
+    const auto wall = std::chrono::steady_clock::now();
+    const double cpu = processCpuSeconds();
+    const double bus = busBusySeconds(buses);
+
+    // The first sample only sets the bus baseline, which started at construction of the buses
+    if (_bus_count == buses.size())
+    {
+        Totals &totals = _totals[_idle ? 1 : 0];
+        totals.wall_s += std::chrono::duration<double>(wall - _last_wall).count();
+        totals.cpu_s += cpu - _last_cpu_s;
+        totals.bus_s += bus - _last_bus_s;
+    }
+    _idle = idle;
+    _bus_count = buses.size();
+    _last_wall = wall;
+    _last_cpu_s = cpu;
+    _last_bus_s = bus;
+}
+
+double UsageMeter::cpuPercent(bool idle) const
+{
+    const Totals &totals = _totals[idle ? 1 : 0];
+    return totals.wall_s > 0.0 ? 100.0 * totals.cpu_s / totals.wall_s : 0.0;
+}
+
+double UsageMeter::busPercent(bool idle) const
+{
+    const Totals &totals = _totals[idle ? 1 : 0];
+    return totals.wall_s > 0.0 && _bus_count > 0
+               ? 100.0 * totals.bus_s / (totals.wall_s * static_cast<double>(_bus_count))
+               : 0.0;
+}
+
+double UsageMeter::seconds(bool idle) const
+{
+    return _totals[idle ? 1 : 0].wall_s;
+}
+
+std::string formatPowerLine(bool idle, std::chrono::milliseconds keep_alive, const UsageMeter &meter)
+{
+    std::ostringstream line;
+    line << "Power: " << (idle ? "idle, polling every " + std::to_string(keep_alive.count()) + " ms" : "active")
+         << std::fixed << std::setprecision(1);
+    for (bool state : {false, true})
+    {
+        line << " | " << (state ? "idle " : "active ") << std::setprecision(0) << meter.seconds(state) << " s: CPU "
+             << std::setprecision(1) << meter.cpuPercent(state) << "%, bus " << meter.busPercent(state) << "%";
+    }
+    return line.str();
+}
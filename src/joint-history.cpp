@@ -0,0 +1,84 @@
+#include "joint-history.hpp"
+#include <algorithm>
+
+JointHistory::JointHistory(size_t columns, Clock::duration bucket)
+    : _ring(std::max<size_t>(1, columns)), _bucket(std::max(bucket, Clock::duration(1))), _newest(0), _sequence(0)
+{
+}
+
+void JointHistory::observe(const ServoData &servo)
+{
+    if (servo.sequence == 0 || servo.sequence == _sequence)
+    {
+        return;
+    }
+    _sequence = servo.sequence;
+    add(servo.current, servo.sampled);
+}
+
+void JointHistory::add(uint16_t position, Clock::time_point sampled)
+{
+    const int64_t bucket = _bucketOf(sampled);
+    const int64_t size = static_cast<int64_t>(_ring.size());
+    if (bucket > _newest)
+    {
+        // Clear the buckets skipped over, at most one lap of the ring
+        const int64_t cleared = std::min(bucket - _newest, size);
+        for (int64_t b = bucket - cleared + 1; b <= bucket; ++b)
+        {
+            _ring[static_cast<size_t>(b % size)] = Envelope();
+        }
+        _newest = bucket;
+    }
+    else if (bucket <= _newest - size || bucket < 0)
+    {
+        return;
+    }
+
+    Envelope &envelope = _ring[static_cast<size_t>(bucket % size)];
+    if (!envelope.set)
+    {
+        envelope.set = true;
+        envelope.low = position;
+        envelope.high = position;
+    }
+    else
+    {
+        envelope.low = std::min(envelope.low, position);
+        envelope.high = std::max(envelope.high, position);
+    }
+}
+
+JointHistory::Envelope JointHistory::envelope(size_t age, Clock::time_point now) const
+{
+    const int64_t size = static_cast<int64_t>(_ring.size());
+    const int64_t bucket = _bucketOf(now) - static_cast<int64_t>(age);
+    if (age >= _ring.size() || bucket > _newest || bucket <= _newest - size || bucket < 0)
+    {
+        return Envelope();
+    }
+    return _ring[static_cast<size_t>(bucket % size)];
+}
+
+size_t JointHistory::columns() const
+{
+    return _ring.size();
+}
+
+Clock::duration JointHistory::bucket() const
+{
+    return _bucket;
+}
+
+int64_t JointHistory::_bucketOf(Clock::time_point time) const
+{
+    return static_cast<int64_t>(time.time_since_epoch() / _bucket);
+}
+
+void observeHistories(std::vector<JointHistory> &histories, const std::vector<ServoData> &arm_data)
+{
+    for (size_t i = 0; i < histories.size() && i < arm_data.size(); ++i)
+    {
+        histories[i].observe(arm_data[i]);
+    }
+}
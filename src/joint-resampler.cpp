@@ -0,0 +1,193 @@
+#include "joint-resampler.hpp"
+#include <algorithm>
+#include <cmath>
+
+JointResampler::JointResampler(size_t arm_count, size_t joint_count, Clock::duration grid_period,
+                               Clock::duration stale_after, size_t history)
+    : _joint_count(joint_count), _grid_period(std::max(grid_period, Clock::duration(1))),
+      _stale_after(stale_after), _history(std::max<size_t>(2, history)), _joints(arm_count * joint_count),
+      _grid_started(false), _next_grid(), _skipped(0)
+{
+    for (auto& joint : _joints)
+    {
+        joint.readings.reserve(_history);
+    }
+}
+
+void JointResampler::observe(size_t arm, const std::vector<ServoData>& arm_data)
+{
+    for (size_t j = 0; j < _joint_count && j < arm_data.size(); ++j)
+    {
+        const ServoData& servo = arm_data[j];
+        JointHistory& joint = _joints[arm * _joint_count + j];
+        if (servo.sequence == 0 || servo.sequence == joint.sequence)
+        {
+            continue;
+        }
+        joint.sequence = servo.sequence;
+        joint.latest = servo;
+
+        const Reading reading{servo.sampled, servo.current};
+        if (joint.readings.size() < _history)
+        {
+            joint.readings.push_back(reading);
+        }
+        else
+        {
+            joint.readings[joint.head] = reading;
+            joint.head = (joint.head + 1) % _history;
+        }
+    }
+}
+
+Clock::time_point JointResampler::alignedUntil() const
+{
+    const Clock::time_point newest = _newest();
+    Clock::time_point until{};
+    for (const auto& joint : _joints)
+    {
+        if (_live(joint, newest))
+        {
+            const Clock::time_point time = _reading(joint, 0).time;
+            until = until == Clock::time_point() ? time : std::min(until, time);
+        }
+    }
+    return until;
+}
+
+bool JointResampler::sample(Clock::time_point time, AlignedSnapshot& snapshot) const
+{
+    const Clock::time_point newest = _newest();
+    if (newest == Clock::time_point())
+    {
+        return false;
+    }
+
+    snapshot.time = time;
+    snapshot.arms.resize(_joints.size() / std::max<size_t>(1, _joint_count));
+    for (size_t a = 0; a < snapshot.arms.size(); ++a)
+    {
+        snapshot.arms[a].resize(_joint_count);
+        for (size_t j = 0; j < _joint_count; ++j)
+        {
+            const JointHistory& joint = _joints[a * _joint_count + j];
+            ServoData& servo = snapshot.arms[a][j];
+            servo = joint.latest;
+            servo.sampled = time;
+            if (!_live(joint, newest))
+            {
+                servo.error = _count(joint) == 0 ? "Not read yet" : "No recent reading";
+                continue;
+            }
+
+            // Newest reading at or before time; hold the ends outside the history
+            const size_t count = _count(joint);
+            size_t age = 0;
+            while (age < count && _reading(joint, age).time > time)
+            {
+                ++age;
+            }
+            if (age == 0 || age == count)
+            {
+                servo.current = _reading(joint, age == 0 ? 0 : count - 1).position;
+                continue;
+            }
+            const Reading& before = _reading(joint, age);
+            const Reading& after = _reading(joint, age - 1);
+            const double span = std::chrono::duration<double>(after.time - before.time).count();
+            const double fraction =
+                span > 0.0 ? std::chrono::duration<double>(time - before.time).count() / span : 1.0;
+            servo.current = static_cast<uint16_t>(
+                std::lround(before.position + fraction * (static_cast<double>(after.position) - before.position)));
+        }
+    }
+    return true;
+}
+
+bool JointResampler::next(AlignedSnapshot& snapshot)
+{
+    const Clock::time_point until = alignedUntil();
+    if (until == Clock::time_point())
+    {
+        return false;
+    }
+
+    if (!_grid_started)
+    {
+        // Anchor the grid at the first instant every joint has a reading
+        // before. Grid points then keep a fixed phase to the sweeps instead
+        // of flipping between two cycles' releases.
+        _next_grid = _heldFrom();
+        _grid_started = true;
+    }
+    else if (_next_grid < _heldFrom())
+    {
+        // Interpolating from history that is gone would only hold stale ends
+        const int64_t behind = (until - _next_grid) / _grid_period;
+        _skipped += static_cast<uint64_t>(behind);
+        _next_grid += behind * _grid_period;
+    }
+    if (_next_grid > until)
+    {
+        return false;
+    }
+
+    sample(_next_grid, snapshot);
+    _next_grid += _grid_period;
+    return true;
+}
+
+Clock::duration JointResampler::skew() const
+{
+    const Clock::time_point newest = _newest();
+    const Clock::time_point until = alignedUntil();
+    return until == Clock::time_point() ? Clock::duration::zero() : newest - until;
+}
+
+uint64_t JointResampler::skipped() const
+{
+    return _skipped;
+}
+
+const JointResampler::Reading& JointResampler::_reading(const JointHistory& joint, size_t age) const
+{
+    const size_t count = _count(joint);
+    return joint.readings[(joint.head + count - 1 - age) % count];
+}
+
+size_t JointResampler::_count(const JointHistory& joint) const
+{
+    return joint.readings.size();
+}
+
+bool JointResampler::_live(const JointHistory& joint, Clock::time_point newest) const
+{
+    return _count(joint) > 0 && newest - _reading(joint, 0).time <= _stale_after;
+}
+
+Clock::time_point JointResampler::_newest() const
+{
+    Clock::time_point newest{};
+    for (const auto& joint : _joints)
+    {
+        if (_count(joint) > 0)
+        {
+            newest = std::max(newest, _reading(joint, 0).time);
+        }
+    }
+    return newest;
+}
+
+Clock::time_point JointResampler::_heldFrom() const
+{
+    const Clock::time_point newest = _newest();
+    Clock::time_point held{};
+    for (const auto& joint : _joints)
+    {
+        if (_live(joint, newest))
+        {
+            held = std::max(held, _reading(joint, _count(joint) - 1).time);
+        }
+    }
+    return held;
+}
@@ -0,0 +1,526 @@
+#include "joint-stream.hpp"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+
+namespace
+{
+
+const uint16_t JOINT_STATE_MAGIC = 0x4A50;  // "PJ"
+const uint8_t JOINT_STATE_VERSION = 2;
+const size_t JOINT_STATE_HEADER = 22;
+const uint8_t FLAG_EMERGENCY_STOP = 0x01;
+
+// Frames per window when re-estimating the base transit, so clock drift
+// between hosts is followed instead of pinned to an old minimum
+const uint32_t TRANSIT_WINDOW = 128;
+
+// A jump this far back means the sender restarted its sequence
+const int32_t SEQUENCE_RESET_DISTANCE = 1024;
+
+// This many late frames in a row are a new stream, not stragglers
+const uint32_t LATE_RESET_RUN = 16;
+
+void putU16(uint8_t* p, uint16_t v)
+{
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+void putU32(uint8_t* p, uint32_t v)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        p[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+}
+
+void putU64(uint8_t* p, uint64_t v)
+{
+    for (int i = 0; i < 8; ++i)
+    {
+        p[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+}
+
+uint16_t getU16(const uint8_t* p)
+{
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t getU32(const uint8_t* p)
+{
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; --i)
+    {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+uint64_t getU64(const uint8_t* p)
+{
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; --i)
+    {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+// Signed distance between sequence numbers, correct across wraparound
+int32_t sequenceDistance(uint32_t a, uint32_t b)
+{
+    return static_cast<int32_t>(a - b);
+}
+
+bool isMulticast(const sockaddr_in& address)
+{
+    return IN_MULTICAST(ntohl(address.sin_addr.s_addr));
+}
+
+}
+
+size_t encodeJointState(const JointStateFrame& frame, uint8_t* buffer)
+{
+    const size_t count = static_cast<size_t>(frame.arm_count) * frame.joint_count;
+    putU16(buffer, JOINT_STATE_MAGIC);
+    buffer[2] = JOINT_STATE_VERSION;
+    buffer[3] = frame.emergency_stop ? FLAG_EMERGENCY_STOP : 0;
+    putU32(buffer + 4, frame.sequence);
+    putU32(buffer + 8, frame.session);
+    putU64(buffer + 12, static_cast<uint64_t>(frame.timestamp_ns));
+    buffer[20] = frame.arm_count;
+    buffer[21] = frame.joint_count;
+    for (size_t i = 0; i < count; ++i)
+    {
+        putU16(buffer + JOINT_STATE_HEADER + 2 * i, frame.positions[i]);
+    }
+    return JOINT_STATE_HEADER + 2 * count;
+}
+
+bool decodeJointState(const uint8_t* buffer, size_t length, JointStateFrame& frame)
+{
+    if (length < JOINT_STATE_HEADER || getU16(buffer) != JOINT_STATE_MAGIC || buffer[2] != JOINT_STATE_VERSION)
+    {
+        return false;
+    }
+    const uint8_t arm_count = buffer[20];
+    const uint8_t joint_count = buffer[21];
+    if (arm_count > JointStateFrame::MAX_ARMS || joint_count > JointStateFrame::MAX_JOINTS)
+    {
+        return false;
+    }
+    const size_t count = static_cast<size_t>(arm_count) * joint_count;
+    if (length < JOINT_STATE_HEADER + 2 * count)
+    {
+        return false;
+    }
+
+    frame.emergency_stop = (buffer[3] & FLAG_EMERGENCY_STOP) != 0;
+    frame.sequence = getU32(buffer + 4);
+    frame.session = getU32(buffer + 8);
+    frame.timestamp_ns = static_cast<int64_t>(getU64(buffer + 12));
+    frame.arm_count = arm_count;
+    frame.joint_count = joint_count;
+    for (size_t i = 0; i < count; ++i)
+    {
+        frame.positions[i] = getU16(buffer + JOINT_STATE_HEADER + 2 * i);
+    }
+    return true;
+}
+
+sockaddr_in parseEndpoint(const std::string& endpoint)
+{
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+
+    const size_t colon = endpoint.rfind(':');
+    if (colon == std::string::npos)
+    {
+        throw std::runtime_error("Endpoint must be ADDRESS:PORT: " + endpoint);
+    }
+    const std::string host = endpoint.substr(0, colon);
+    int port = -1;
+    try
+    {
+        port = std::stoi(endpoint.substr(colon + 1));
+    }
+    catch (const std::exception&)
+    {
+    }
+    if (port < 0 || port > 65535 || ::inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1)
+    {
+        throw std::runtime_error("Invalid endpoint: " + endpoint);
+    }
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    return address;
+}
+
+int64_t wallClockNanoseconds()
+{
+    struct timespec now;
+    ::clock_gettime(CLOCK_REALTIME, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+JitterBuffer::JitterBuffer(const Config& config)
+    : _config(config)
+{
+    _frames.reserve(_config.capacity + 1);
+    _reset();
+}
+
+void JitterBuffer::_reset()
+{
+    _frames.clear();
+    _started = false;
+    _next_sequence = 0;
+    _highest_sequence = 0;
+    _session = 0;
+    _highest_timestamp = 0;
+    _late_run = 0;
+    _base_transit = 0;
+    _window_min_transit = 0;
+    _window_count = 0;
+    _last_transit = 0;
+    _jitter_ns = 0.0;
+}
+
+void JitterBuffer::push(const JointStateFrame& frame, int64_t arrival_ns)
+{
+    ++_stats.received;
+    const int64_t transit = arrival_ns - frame.timestamp_ns;
+
+    if (_started)
+    {
+        // Stragglers carry older timestamps; a new stream carries newer ones
+        const bool behind = sequenceDistance(frame.sequence, _next_sequence) < 0;
+        _late_run = behind ? _late_run + 1 : 0;
+        if (frame.session != _session || (behind && frame.timestamp_ns > _highest_timestamp) ||
+            sequenceDistance(frame.sequence, _highest_sequence) < -SEQUENCE_RESET_DISTANCE ||
+            _late_run >= LATE_RESET_RUN)
+        {
+            _reset();
+            ++_stats.restarts;
+        }
+    }
+    if (!_started)
+    {
+        _started = true;
+        _next_sequence = frame.sequence;
+        _highest_sequence = frame.sequence;
+        _session = frame.session;
+        _highest_timestamp = frame.timestamp_ns;
+        _base_transit = transit;
+        _window_min_transit = transit;
+        _last_transit = transit;
+    }
+
+    // RFC 3550 interarrival jitter, kept in nanoseconds
+    _jitter_ns += (std::abs(static_cast<double>(transit - _last_transit)) - _jitter_ns) / 16.0;
+    _last_transit = transit;
+
+    _base_transit = std::min(_base_transit, transit);
+    _window_min_transit = std::min(_window_min_transit, transit);
+    if (++_window_count == TRANSIT_WINDOW)
+    {
+        _base_transit = _window_min_transit;
+        _window_min_transit = transit;
+        _window_count = 0;
+    }
+
+    if (sequenceDistance(frame.sequence, _next_sequence) < 0)
+    {
+        ++_stats.late;
+        return;
+    }
+    if (sequenceDistance(frame.sequence, _highest_sequence) < 0)
+    {
+        ++_stats.reordered;
+    }
+    else
+    {
+        _highest_sequence = frame.sequence;
+    }
+    _highest_timestamp = std::max(_highest_timestamp, frame.timestamp_ns);
+
+    auto position = std::lower_bound(_frames.begin(), _frames.end(), frame.sequence,
+                                     [](const JointStateFrame& f, uint32_t sequence) {
+                                         return sequenceDistance(f.sequence, sequence) < 0;
+                                     });
+    if (position != _frames.end() && position->sequence == frame.sequence)
+    {
+        ++_stats.duplicates;
+        return;
+    }
+    _frames.insert(position, frame);
+
+    // Over capacity the oldest frame is given up rather than delaying the rest
+    if (_frames.size() > _config.capacity)
+    {
+        _stats.lost += static_cast<uint64_t>(sequenceDistance(_frames.front().sequence, _next_sequence)) + 1;
+        _next_sequence = _frames.front().sequence + 1;
+        _frames.erase(_frames.begin());
+    }
+}
+
+bool JitterBuffer::pop(JointStateFrame& frame, int64_t now_ns)
+{
+    if (_frames.empty() || _playoutTime(_frames.front()) > now_ns)
+    {
+        return false;
+    }
+    frame = _frames.front();
+    _frames.erase(_frames.begin());
+    _stats.lost += static_cast<uint64_t>(std::max(0, sequenceDistance(frame.sequence, _next_sequence)));
+    _next_sequence = frame.sequence + 1;
+    ++_stats.played;
+    return true;
+}
+
+int64_t JitterBuffer::nextPlayout() const
+{
+    return _frames.empty() ? -1 : _playoutTime(_frames.front());
+}
+
+JitterBuffer::Stats JitterBuffer::stats() const
+{
+    Stats stats = _stats;
+    stats.jitter_us = _jitter_ns / 1000.0;
+    stats.delay_us = static_cast<double>(_targetDelay()) / 1000.0;
+    return stats;
+}
+
+int64_t JitterBuffer::_targetDelay() const
+{
+    const double target = std::clamp(_jitter_ns * _config.jitter_multiplier,
+                                     static_cast<double>(std::chrono::nanoseconds(_config.min_delay).count()),
+                                     static_cast<double>(std::chrono::nanoseconds(_config.max_delay).count()));
+    return static_cast<int64_t>(target);
+}
+
+int64_t JitterBuffer::_playoutTime(const JointStateFrame& frame) const
+{
+    return frame.timestamp_ns + _base_transit + _targetDelay();
+}
+
+JointStatePublisher::JointStatePublisher(const std::string& endpoint, int multicast_ttl)
+    : _fd(-1), _destination(parseEndpoint(endpoint)), _session(std::random_device()()), _sequence(0), _sent(0), _send_errors(0)
+{
+    _fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (_fd < 0)
+    {
+        throw std::runtime_error(std::string("Failed to create UDP socket: ") + std::strerror(errno));
+    }
+    if (isMulticast(_destination))
+    {
+        const unsigned char ttl = static_cast<unsigned char>(std::clamp(multicast_ttl, 0, 255));
+        const unsigned char loop = 1;  // Followers on the same host must see the stream too
+        ::setsockopt(_fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+        ::setsockopt(_fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+    }
+}
+
+JointStatePublisher::~JointStatePublisher()
+{
+    ::close(_fd);
+}
+
+void JointStatePublisher::publish(const std::vector<const std::vector<ServoData>*>& arms, bool emergency_stop,
+                                  int64_t timestamp_ns)
+{
+    JointStateFrame frame;
+    frame.timestamp_ns = timestamp_ns;
+    frame.emergency_stop = emergency_stop;
+    frame.arm_count = static_cast<uint8_t>(std::min(arms.size(), JointStateFrame::MAX_ARMS));
+    frame.joint_count = 0;
+    for (size_t a = 0; a < frame.arm_count; ++a)
+    {
+        frame.joint_count = std::max(frame.joint_count,
+                                     static_cast<uint8_t>(std::min(arms[a]->size(), JointStateFrame::MAX_JOINTS)));
+    }
+    for (size_t a = 0; a < frame.arm_count; ++a)
+    {
+        for (size_t j = 0; j < frame.joint_count; ++j)
+        {
+            const bool valid = j < arms[a]->size() && (*arms[a])[j].error.empty();
+            frame.positions[a * frame.joint_count + j] =
+                valid ? (*arms[a])[j].current : JointStateFrame::INVALID_POSITION;
+        }
+    }
+    publish(frame);
+}
+
+void JointStatePublisher::publish(JointStateFrame& frame)
+{
+    frame.sequence = _sequence++;
+    frame.session = _session;
+    uint8_t buffer[MAX_JOINT_STATE_DATAGRAM];
+    const size_t length = encodeJointState(frame, buffer);
+    const ssize_t sent = ::sendto(_fd, buffer, length, MSG_DONTWAIT,
+                                  reinterpret_cast<const sockaddr*>(&_destination), sizeof(_destination));
+    if (sent == static_cast<ssize_t>(length))
+    {
+        ++_sent;
+    }
+    else
+    {
+        ++_send_errors;
+    }
+}
+
+uint64_t JointStatePublisher::sent() const
+{
+    return _sent;
+}
+
+uint64_t JointStatePublisher::sendErrors() const
+{
+    return _send_errors;
+}
+
+JointStateSubscriber::JointStateSubscriber(const std::string& endpoint, const JitterBuffer::Config& config)
+    : _fd(-1), _buffer(config), _malformed(0)
+{
+    sockaddr_in address = parseEndpoint(endpoint);
+    _fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (_fd < 0)
+    {
+        throw std::runtime_error(std::string("Failed to create UDP socket: ") + std::strerror(errno));
+    }
+    const int enable = 1;
+    ::setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    ::setsockopt(_fd, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable));
+    if (::bind(_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0)
+    {
+        const int saved_errno = errno;
+        ::close(_fd);
+        throw std::runtime_error("Failed to bind " + endpoint + ": " + std::strerror(saved_errno));
+    }
+    if (isMulticast(address))
+    {
+        ip_mreq membership;
+        membership.imr_multiaddr = address.sin_addr;
+        membership.imr_interface.s_addr = htonl(INADDR_ANY);
+        if (::setsockopt(_fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) < 0)
+        {
+            const int saved_errno = errno;
+            ::close(_fd);
+            throw std::runtime_error("Failed to join " + endpoint + ": " + std::strerror(saved_errno));
+        }
+    }
+}
+
+JointStateSubscriber::~JointStateSubscriber()
+{
+    ::close(_fd);
+}
+
+bool JointStateSubscriber::receive(JointStateFrame& frame, std::chrono::milliseconds timeout)
+{
+    const int64_t deadline = wallClockNanoseconds() + std::chrono::nanoseconds(timeout).count();
+    while (true)
+    {
+        _drainSocket();
+        const int64_t now = wallClockNanoseconds();
+        if (_buffer.pop(frame, now))
+        {
+            return true;
+        }
+        if (now >= deadline)
+        {
+            return false;
+        }
+
+        // Sleep until the next frame is due, new data arrives, or the deadline
+        int64_t wake = deadline;
+        const int64_t next = _buffer.nextPlayout();
+        if (next >= 0)
+        {
+            wake = std::min(wake, next);
+        }
+        struct pollfd pfd = {_fd, POLLIN, 0};
+        const struct timespec wait = {static_cast<time_t>((wake - now) / 1000000000),
+                                      static_cast<long>((wake - now) % 1000000000)};
+        ::ppoll(&pfd, 1, &wait, nullptr);
+    }
+}
+
+uint16_t JointStateSubscriber::port() const
+{
+    sockaddr_in address;
+    socklen_t length = sizeof(address);
+    if (::getsockname(_fd, reinterpret_cast<sockaddr*>(&address), &length) < 0)
+    {
+        return 0;
+    }
+    return ntohs(address.sin_port);
+}
+
+JitterBuffer::Stats JointStateSubscriber::stats() const
+{
+    return _buffer.stats();
+}
+
+uint64_t JointStateSubscriber::malformed() const
+{
+    return _malformed;
+}
+
+void JointStateSubscriber::_drainSocket()
+{
+    uint8_t buffer[512];
+    alignas(struct cmsghdr) uint8_t control[CMSG_SPACE(sizeof(struct timespec))];
+    JointStateFrame frame;
+    while (true)
+    {
+        struct iovec io = {buffer, sizeof(buffer)};
+        struct msghdr message;
+        std::memset(&message, 0, sizeof(message));
+        message.msg_iov = &io;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        const ssize_t length = ::recvmsg(_fd, &message, MSG_DONTWAIT);
+        if (length < 0)
+        {
+            return;  // EAGAIN once drained; other errors are retried on the next call
+        }
+
+        // Prefer the kernel's receive timestamp so a busy consumer does not
+        // show up as network jitter
+        int64_t arrival_ns = -1;
+        for (struct cmsghdr* header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(&message, header))
+        {
+            if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_TIMESTAMPNS)
+            {
+                struct timespec stamp;
+                std::memcpy(&stamp, CMSG_DATA(header), sizeof(stamp));
+                arrival_ns = static_cast<int64_t>(stamp.tv_sec) * 1000000000 + stamp.tv_nsec;
+            }
+        }
+        if (arrival_ns < 0)
+        {
+            arrival_ns = wallClockNanoseconds();
+        }
+
+        if (decodeJointState(buffer, static_cast<size_t>(length), frame))
+        {
+            _buffer.push(frame, arrival_ns);
+        }
+        else
+        {
+            ++_malformed;
+        }
+    }
+}
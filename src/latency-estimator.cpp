@@ -0,0 +1,329 @@
+#include "latency-estimator.hpp"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+
+// Movement smaller than this, in position ticks, is treated as sensor noise
+const double MIN_MOTION_STDDEV = 2.0;
+
+// In-place iterative radix-2 FFT; size must be a power of two
+void fft(std::vector<std::complex<double>>& data, bool inverse)
+{
+    const size_t n = data.size();
+    for (size_t i = 1, j = 0; i < n; ++i)
+    {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+        {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j)
+        {
+            std::swap(data[i], data[j]);
+        }
+    }
+    for (size_t length = 2; length <= n; length <<= 1)
+    {
+        const double angle = 2.0 * M_PI / static_cast<double>(length) * (inverse ? 1.0 : -1.0);
+        const std::complex<double> step(std::cos(angle), std::sin(angle));
+        for (size_t start = 0; start < n; start += length)
+        {
+            std::complex<double> twiddle(1.0, 0.0);
+            for (size_t k = 0; k < length / 2; ++k)
+            {
+                const std::complex<double> even = data[start + k];
+                const std::complex<double> odd = data[start + k + length / 2] * twiddle;
+                data[start + k] = even + odd;
+                data[start + k + length / 2] = even - odd;
+                twiddle *= step;
+            }
+        }
+    }
+    if (inverse)
+    {
+        for (auto& value : data)
+        {
+            value /= static_cast<double>(n);
+        }
+    }
+}
+
+// Linear interpolation of timestamped samples at count points spaced period_ns apart
+template <typename Samples>
+void resample(const Samples& samples, int64_t start_ns, int64_t period_ns, size_t count, std::vector<double>& out)
+{
+    out.resize(count);
+    size_t after = 0;
+    for (size_t g = 0; g < count; ++g)
+    {
+        const int64_t t = start_ns + static_cast<int64_t>(g) * period_ns;
+        while (after < samples.size() && samples[after].time_ns < t)
+        {
+            ++after;
+        }
+        if (after == 0)
+        {
+            out[g] = samples.front().position;
+        }
+        else if (after == samples.size())
+        {
+            out[g] = samples.back().position;
+        }
+        else
+        {
+            const auto& a = samples[after - 1];
+            const auto& b = samples[after];
+            const double fraction = static_cast<double>(t - a.time_ns) / static_cast<double>(b.time_ns - a.time_ns);
+            out[g] = a.position + fraction * (b.position - a.position);
+        }
+    }
+}
+
+double removeMean(std::vector<double>& values)
+{
+    double mean = 0.0;
+    for (double v : values)
+    {
+        mean += v;
+    }
+    mean /= static_cast<double>(values.size());
+    double energy = 0.0;
+    for (double& v : values)
+    {
+        v -= mean;
+        energy += v * v;
+    }
+    return energy;
+}
+
+}
+
+LatencyEstimator::LatencyEstimator(size_t channels, const Config& config)
+    : _config(config),
+      _grid_size(static_cast<size_t>(std::max<int64_t>(4, config.window.count() / std::max<int64_t>(1, config.grid_period.count())))),
+      _fft_size(1), _channels(channels), _running(true)
+{
+    while (_fft_size < 2 * _grid_size)
+    {
+        _fft_size <<= 1;
+    }
+    _thread = std::thread(&LatencyEstimator::_run, this);
+}
+
+LatencyEstimator::~LatencyEstimator()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _running = false;
+    }
+    _wake.notify_all();
+    _thread.join();
+}
+
+void LatencyEstimator::addCommand(size_t channel, int64_t time_ns, double position)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (channel < _channels.size())
+    {
+        _channels[channel].commands.push_back({time_ns, position});
+        _trim(_channels[channel].commands, time_ns);
+    }
+}
+
+void LatencyEstimator::addMeasurement(size_t channel, int64_t time_ns, double position)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (channel < _channels.size())
+    {
+        _channels[channel].measurements.push_back({time_ns, position});
+        _trim(_channels[channel].measurements, time_ns);
+    }
+}
+
+LatencyEstimate LatencyEstimator::estimate() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _estimate;
+}
+
+void LatencyEstimator::_trim(std::deque<Sample>& samples, int64_t newest_ns)
+{
+    // Keep a little more than a window so the newest window is always complete
+    const int64_t keep_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(_config.window + 2 * _config.max_lag).count();
+    while (samples.size() > 2 && samples.front().time_ns < newest_ns - keep_ns)
+    {
+        samples.pop_front();
+    }
+}
+
+void LatencyEstimator::_run()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    uint64_t updates = 0;
+    while (_running)
+    {
+        _wake.wait_for(lock, _config.interval, [this] { return !_running; });
+        if (!_running)
+        {
+            break;
+        }
+
+        // Correlate a copy so the control loop is never held up by the FFTs
+        const std::vector<Channel> channels = _channels;
+        lock.unlock();
+        const LatencyEstimate estimate = _compute(channels, ++updates);
+        lock.lock();
+        _estimate = estimate;
+    }
+}
+
+LatencyEstimate LatencyEstimator::_compute(const std::vector<Channel>& channels, uint64_t updates) const
+{
+    LatencyEstimate estimate;
+    estimate.updates = updates;
+
+    const int64_t period_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(_config.grid_period).count();
+    const size_t max_lag =
+        std::min(_grid_size / 2, static_cast<size_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                         _config.max_lag).count() / std::max<int64_t>(1, period_ns)));
+
+    // The command segment is max_lag shorter than the measured window, so
+    // every lag correlates the same commands against a full-length stretch
+    const size_t segment = _grid_size - max_lag;
+    std::vector<double> correlation(max_lag + 1, 0.0);
+    std::vector<double> measured_energy(max_lag + 1, 0.0);
+    double command_energy = 0.0;
+    std::vector<double> command, measured;
+    std::vector<std::complex<double>> command_spectrum(_fft_size), measured_spectrum(_fft_size);
+    std::vector<std::pair<std::vector<double>, std::vector<double>>> moving;
+
+    for (const auto& channel : channels)
+    {
+        if (channel.commands.size() < 2 || channel.measurements.size() < 2)
+        {
+            continue;
+        }
+
+        // The newest window both streams cover
+        const int64_t end = std::min(channel.commands.back().time_ns, channel.measurements.back().time_ns);
+        const int64_t start = end - static_cast<int64_t>(_grid_size - 1) * period_ns;
+        if (start < std::max(channel.commands.front().time_ns, channel.measurements.front().time_ns))
+        {
+            continue;
+        }
+        resample(channel.commands, start, period_ns, segment, command);
+        resample(channel.measurements, start, period_ns, _grid_size, measured);
+        std::vector<double> raw_command = command, raw_measured = measured;
+        const double ce = removeMean(command);
+        const double me = removeMean(measured);
+        if (ce < MIN_MOTION_STDDEV * MIN_MOTION_STDDEV * static_cast<double>(segment) ||
+            me < MIN_MOTION_STDDEV * MIN_MOTION_STDDEV * static_cast<double>(_grid_size))
+        {
+            continue;
+        }
+
+        // Zero padding to twice the window keeps the circular correlation from wrapping
+        std::fill(command_spectrum.begin(), command_spectrum.end(), 0.0);
+        std::fill(measured_spectrum.begin(), measured_spectrum.end(), 0.0);
+        std::copy(command.begin(), command.end(), command_spectrum.begin());
+        std::copy(measured.begin(), measured.end(), measured_spectrum.begin());
+        fft(command_spectrum, false);
+        fft(measured_spectrum, false);
+        for (size_t k = 0; k < _fft_size; ++k)
+        {
+            measured_spectrum[k] *= std::conj(command_spectrum[k]);
+        }
+        fft(measured_spectrum, true);
+
+        // Index L now holds sum over t of command[t] * measured[t + L]; the
+        // commands have zero mean, so the stretch's own mean drops out of it
+        // and only its variance, kept as running sums, is needed per lag
+        double sum = 0.0, squares = 0.0;
+        for (size_t t = 0; t < segment; ++t)
+        {
+            sum += measured[t];
+            squares += measured[t] * measured[t];
+        }
+        for (size_t lag = 0; lag <= max_lag; ++lag)
+        {
+            correlation[lag] += measured_spectrum[lag].real();
+            measured_energy[lag] += squares - sum * sum / static_cast<double>(segment);
+            if (lag < max_lag)
+            {
+                const double entering = measured[lag + segment];
+                const double leaving = measured[lag];
+                sum += entering - leaving;
+                squares += entering * entering - leaving * leaving;
+            }
+        }
+        command_energy += ce;
+        moving.emplace_back(std::move(raw_command), std::move(raw_measured));
+    }
+    if (moving.empty())
+    {
+        return estimate;
+    }
+
+    // Normalise each lag by the energy of exactly the samples it compared
+    for (size_t lag = 0; lag <= max_lag; ++lag)
+    {
+        correlation[lag] /= std::sqrt(command_energy * std::max(measured_energy[lag], 1e-9));
+    }
+    const size_t peak = static_cast<size_t>(std::max_element(correlation.begin(), correlation.end()) -
+                                            correlation.begin());
+    double offset = 0.0;
+    if (peak > 0 && peak < max_lag)
+    {
+        const double left = correlation[peak - 1];
+        const double centre = correlation[peak];
+        const double right = correlation[peak + 1];
+        const double curvature = left - 2.0 * centre + right;
+        if (curvature < 0.0)
+        {
+            offset = 0.5 * (left - right) / curvature;
+        }
+    }
+
+    double squared = 0.0;
+    size_t count = 0;
+    for (const auto& [raw_command, raw_measured] : moving)
+    {
+        for (size_t t = 0; t < segment; ++t)
+        {
+            const double error = raw_measured[t + peak] - raw_command[t];
+            squared += error * error;
+            ++count;
+        }
+    }
+
+    estimate.correlation = correlation[peak];
+    estimate.valid = estimate.correlation >= _config.min_correlation;
+    estimate.lag_ms = (static_cast<double>(peak) + offset) * static_cast<double>(period_ns) / 1e6;
+    estimate.rms = std::sqrt(squared / static_cast<double>(std::max<size_t>(count, 1)));
+    return estimate;
+}
+
+std::string formatLatencyLine(const LatencyEstimate& estimate)
+{
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(1);
+    if (!estimate.valid)
+    {
+        line << "Latency: move the leader to measure";
+        if (estimate.updates > 0 && estimate.correlation > 0.0)
+        {
+            line << " (correlation " << std::setprecision(2) << estimate.correlation << ")";
+        }
+        return line.str();
+    }
+    line << "Latency: " << estimate.lag_ms << " ms, tracking RMS " << estimate.rms << " ticks, correlation "
+         << std::setprecision(2) << estimate.correlation;
+    return line.str();
+}
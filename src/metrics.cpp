@@ -0,0 +1,28 @@
+#include "metrics.hpp"
+#include <cstdio>
+#include <fstream>
+#include <limits>
+
+bool writeMetricsFile(const std::string& path, const std::vector<Metric>& metrics)
+{
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::trunc);
+        out.precision(std::numeric_limits<double>::max_digits10);
+        for (const auto& metric : metrics)
+        {
+            if (!metric.help.empty())
+            {
+                out << "# HELP " << metric.name << " " << metric.help << "\n";
+            }
+            out << "# TYPE " << metric.name << (metric.type == Metric::COUNTER ? " counter\n" : " gauge\n")
+                << metric.name << " " << metric.value << "\n";
+        }
+        if (!out.flush())
+        {
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
@@ -0,0 +1,112 @@
+#include "perf-counters.hpp"
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+
+namespace
+{
+
+int openCounter(uint32_t type, uint64_t config)
+{
+    struct perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_hv = 1;
+
+    // Try with kernel events first so context switches and syscall work are
+    // visible, then fall back to user-only for perf_event_paranoid >= 2
+    int fd = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    if (fd < 0)
+    {
+        attr.exclude_kernel = 1;
+        fd = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+    return fd;
+}
+
+}
+
+PerfCounters::PerfCounters()
+{
+    _fds[CYCLES] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    _fds[INSTRUCTIONS] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    _fds[CACHE_MISSES] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    _fds[CONTEXT_SWITCHES] = openCounter(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES);
+}
+
+PerfCounters::~PerfCounters()
+{
+    for (int fd : _fds)
+    {
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+    }
+}
+
+bool PerfCounters::available() const
+{
+    for (int fd : _fds)
+    {
+        if (fd >= 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PerfCounters::start()
+{
+    for (int fd : _fds)
+    {
+        if (fd >= 0)
+        {
+            ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+PerfCounters::Sample PerfCounters::stop()
+{
+    Sample sample;
+    for (size_t i = 0; i < EVENT_COUNT; ++i)
+    {
+        if (_fds[i] < 0)
+        {
+            continue;
+        }
+        ::ioctl(_fds[i], PERF_EVENT_IOC_DISABLE, 0);
+        uint64_t value = 0;
+        if (::read(_fds[i], &value, sizeof(value)) == sizeof(value))
+        {
+            sample.values[i] = value;
+            sample.valid[i] = true;
+        }
+    }
+    return sample;
+}
+
+const char* PerfCounters::eventName(Event event)
+{
+    switch (event)
+    {
+    case CYCLES:
+        return "cycles";
+    case INSTRUCTIONS:
+        return "instr";
+    case CACHE_MISSES:
+        return "cache-miss";
+    case CONTEXT_SWITCHES:
+        return "ctx-sw";
+    default:
+        return "?";
+    }
+}
@@ -1,4 +1,9 @@
 #include "perseus-arm-teleop.hpp"
+#include "emergency-stop.hpp"
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
 #include <stdexcept>
 #include <thread>
 #include <chrono>
@@ -8,8 +13,8 @@
 
 using namespace boost::asio;
 
-ST3215ServoReader::ST3215ServoReader(const std::string& port, unsigned int baud_rate)
-    : _io_service(), _serial_port(_io_service)
+ST3215ServoReader::ST3215ServoReader(const std::string& port, unsigned int baud_rate, Clock& clock)
+    : _io_service(), _serial_port(_io_service), _clock(clock), _estop_slot(-1)
 {
     try {
         _serial_port.open(port);
@@ -62,8 +67,11 @@ ST3215ServoReader::ST3215ServoReader(const std::string& port, unsigned int baud_
         _serial_port.set_option(serial_port::parity(serial_port::parity::none));
         _serial_port.set_option(serial_port::flow_control(serial_port::flow_control::none));
         
+        // Make the port reachable by the emergency stop broadcast
+        _estop_slot = EmergencyStop::instance().registerPort(fd);
+        
         // Initial delay to let port settle - ACM devices often need more time
-        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        _clock.sleepFor(std::chrono::milliseconds(200));
     }
     catch (const boost::system::system_error& e) {
         throw std::runtime_error(std::string("Failed to open serial port: ") + e.what());
@@ -72,6 +80,7 @@ ST3215ServoReader::ST3215ServoReader(const std::string& port, unsigned int baud_
 
 ST3215ServoReader::~ST3215ServoReader() 
 {
+    EmergencyStop::instance().unregisterPort(_estop_slot);
     try {
         if (_serial_port.is_open()) 
         {
@@ -85,36 +94,215 @@ ST3215ServoReader::~ST3215ServoReader()
 }
 
 uint16_t ST3215ServoReader::readPosition(uint8_t servo_id) 
+{
+    std::vector<uint8_t> data = readRegisters(servo_id, 0x38, 2);
+    
+    // Position is in little-endian format
+    return static_cast<uint16_t>(data[0]) | (static_cast<uint16_t>(data[1]) << 8);
+}
+
+std::vector<uint8_t> ST3215ServoReader::readRegisters(uint8_t servo_id, uint8_t address, uint8_t size)
 {
     const int MAX_RETRIES = 3;
     const auto timeout = std::chrono::milliseconds(200);  // Increased timeout for ACM
+    // A stop triggered from here on cancels this transaction; none may start
+    // while one is latched. Snapshot before checking the latch so a trigger
+    // in between is still seen as a generation change.
+    const uint64_t generation = EmergencyStop::instance().generation();
+    if (EmergencyStop::instance().triggered()) {
+        throw EmergencyStopError();
+    }
     for (int retry = 0; retry < MAX_RETRIES; ++retry) {
         try {
-            return _readPositionOnce(servo_id, timeout);
+            return _readRegistersOnce(servo_id, address, size, timeout, generation);
+        }
+        catch (const EmergencyStopError&) {
+            throw; // Never retry a cancelled transaction
         }
         catch (const std::runtime_error& e) {
-            if (retry == MAX_RETRIES - 1) {
-                throw; // Re-throw if this was our last retry
+            if (retry == MAX_RETRIES - 1 || !isConnected()) {
+                throw; // Re-throw if this was our last retry or the device is gone
             }
             // Flush the port and wait before retry
             ::tcflush(static_cast<int>(_serial_port.native_handle()), TCIOFLUSH);
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));  // Longer delay between retries
+            _pause(std::chrono::milliseconds(100), generation);  // Longer delay between retries
         }
     }
     throw std::runtime_error("Maximum retries exceeded");
 }
 
+std::vector<ST3215ServoReader::ServoReply> ST3215ServoReader::syncRead(const std::vector<uint8_t>& servo_ids,
+                                                                       uint8_t address, uint8_t size)
+{
+    std::vector<ServoReply> replies;
+    syncRead(servo_ids, address, size, replies);
+    return replies;
+}
+
+void ST3215ServoReader::syncRead(const std::vector<uint8_t>& servo_ids, uint8_t address, uint8_t size,
+                                 std::vector<ServoReply>& replies)
+{
+    const auto timeout = std::chrono::milliseconds(200);
+    const uint64_t generation = EmergencyStop::instance().generation();
+    if (EmergencyStop::instance().triggered()) {
+        throw EmergencyStopError();
+    }
+
+    replies.resize(servo_ids.size());
+    for (size_t i = 0; i < servo_ids.size(); ++i) {
+        replies[i].id = servo_ids[i];
+        replies[i].data.clear();
+        replies[i].error.clear();
+        replies[i].completed = Clock::time_point();
+    }
+    if (servo_ids.empty()) {
+        return;
+    }
+
+    _sendCommand(_createSyncReadCommand(servo_ids, address, size), generation);
+
+    // Servos answer in request order; an absent servo simply leaves a gap, so
+    // each reply is matched to the next requested ID it carries
+    std::array<uint8_t, 256> response_buffer;
+    size_t next = 0;
+    while (next < servo_ids.size()) {
+        size_t length = 0;
+        try {
+            length = _readStatusPacket(response_buffer.data(), timeout, generation);
+        }
+        catch (const EmergencyStopError&) {
+            throw;
+        }
+        catch (const std::runtime_error& e) {
+            for (; next < servo_ids.size(); ++next) {
+                replies[next].error = e.what();
+            }
+            break;
+        }
+
+        // Stamped per servo: the last reply of a sweep lands well after the first
+        const Clock::time_point completed = _clock.now();
+        const uint8_t id = response_buffer[2];
+        size_t match = next;
+        while (match < servo_ids.size() && servo_ids[match] != id) {
+            ++match;
+        }
+        if (match == servo_ids.size()) {
+            continue; // Stray packet, keep waiting for the expected IDs
+        }
+        for (; next < match; ++next) {
+            replies[next].error = "No reply to sync read";
+        }
+
+        try {
+            size_t payload_size = 0;
+            const uint8_t* payload = parseStatusPacket(response_buffer.data(), length, id, payload_size);
+            if (payload_size < size) {
+                throw std::runtime_error("Short sync read reply");
+            }
+            replies[match].data.assign(payload, payload + size);
+            replies[match].completed = completed;
+        }
+        catch (const std::runtime_error& e) {
+            replies[match].error = e.what();
+        }
+        ++next;
+    }
+}
+
+void ST3215ServoReader::syncWrite(const std::vector<uint8_t>& servo_ids, uint8_t address, uint8_t size,
+                                  const std::vector<uint8_t>& data)
+{
+    if (data.size() != servo_ids.size() * size) {
+        throw std::runtime_error("Sync write data does not match servo count");
+    }
+    const uint64_t generation = EmergencyStop::instance().generation();
+    if (EmergencyStop::instance().triggered()) {
+        throw EmergencyStopError();
+    }
+    if (servo_ids.empty()) {
+        return;
+    }
+    _sendCommand(_createSyncWriteCommand(servo_ids, address, size, data), generation, false);
+}
+
+bool ST3215ServoReader::isConnected()
+{
+    if (!_serial_port.is_open()) {
+        return false;
+    }
+    // A hung-up tty (USB adapter unplugged) fails every ioctl with EIO
+    struct termios tio;
+    return tcgetattr(static_cast<int>(_serial_port.native_handle()), &tio) == 0;
+}
+
 #include <fcntl.h>
 #include <termios.h>
 
-uint16_t ST3215ServoReader::_readPositionOnce(uint8_t servo_id, const std::chrono::milliseconds& timeout)
+void ST3215ServoReader::_readExact(uint8_t* dest, size_t count, const std::chrono::milliseconds& timeout,
+                                   uint64_t generation, const char* what)
+{
+    auto& estop = EmergencyStop::instance();
+    const int fd = static_cast<int>(_serial_port.native_handle());
+    const auto start_time = _clock.now();
+    size_t total_read = 0;
+
+    while (total_read < count) {
+        if (estop.generation() != generation) {
+            throw EmergencyStopError();
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(_clock.now() - start_time);
+        if (elapsed > timeout) {
+            throw std::runtime_error(std::string("Timeout waiting for ") + what);
+        }
+
+        // Wait for data or an emergency stop instead of spinning on read_some()
+        struct pollfd fds[2] = {{fd, POLLIN, 0}, {estop.cancelFd(), POLLIN, 0}};
+        int ready = ::poll(fds, 2, static_cast<int>((timeout - elapsed).count()));
+        if (estop.generation() != generation) {
+            throw EmergencyStopError();
+        }
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue; // Retry on interruption
+            }
+            throw std::runtime_error(std::string(what) + " read error: " + std::strerror(errno));
+        }
+        if (ready == 0) {
+            throw std::runtime_error(std::string("Timeout waiting for ") + what);
+        }
+        if (fds[0].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+            throw std::runtime_error(std::string(what) + " read error: port hung up");
+        }
+        if (!(fds[0].revents & POLLIN)) {
+            continue;
+        }
+
+        ssize_t bytes = ::read(fd, dest + total_read, count - total_read);
+        if (bytes < 0) {
+            if (errno == EINTR || errno == EAGAIN) {
+                continue;
+            }
+            throw std::runtime_error(std::string(what) + " read error: " + std::strerror(errno));
+        }
+        total_read += static_cast<size_t>(bytes);
+    }
+}
+
+void ST3215ServoReader::_pause(const std::chrono::milliseconds& duration, uint64_t generation)
+{
+    auto& estop = EmergencyStop::instance();
+    _clock.sleepFor(duration, estop.cancelFd());
+    if (estop.generation() != generation) {
+        throw EmergencyStopError();
+    }
+}
+
+void ST3215ServoReader::_sendCommand(const std::vector<uint8_t>& command, uint64_t generation, bool expect_reply)
 {
-    // Create read position command packet
-    std::vector<uint8_t> command = _createReadCommand(servo_id, 0x38, 2);
-    
     // Clear any existing data and wait for port to clear
     ::tcflush(static_cast<int>(_serial_port.native_handle()), TCIOFLUSH);
-    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    _pause(std::chrono::milliseconds(5), generation);
     
     // Send command with retry
     boost::system::error_code write_ec;
@@ -127,7 +315,7 @@ uint16_t ST3215ServoReader::_readPositionOnce(uint8_t servo_id, const std::chron
         if (write_ec || written != command.size()) {
             write_attempts++;
             if (write_attempts < MAX_WRITE_ATTEMPTS) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                _pause(std::chrono::milliseconds(10), generation);
                 continue;
             }
         }
@@ -141,100 +329,106 @@ uint16_t ST3215ServoReader::_readPositionOnce(uint8_t servo_id, const std::chron
     }
     
     // Ensure minimum response time - ST3215 needs at least 10ms
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
-    
-    // Read response using a fixed buffer
-    std::array<uint8_t, 256> response_buffer;
-    size_t total_read = 0;
+    if (expect_reply) {
+        _pause(std::chrono::milliseconds(10), generation);
+    }
+}
+
+size_t ST3215ServoReader::_readStatusPacket(uint8_t* response_buffer, const std::chrono::milliseconds& timeout,
+                                            uint64_t generation)
+{
     const size_t HEADER_SIZE = 4;
-    auto start_time = std::chrono::steady_clock::now();
     
     // Read header with timeout
-    while (total_read < HEADER_SIZE) {
-        if (std::chrono::steady_clock::now() - start_time > timeout) {
-            throw std::runtime_error("Timeout waiting for header");
-        }
-        
-        boost::system::error_code read_ec;
-        size_t bytes = _serial_port.read_some(
-            buffer(response_buffer.data() + total_read, HEADER_SIZE - total_read), 
-            read_ec
-        );
-        
-        if (read_ec) {
-            if (read_ec == boost::asio::error::operation_aborted ||
-                read_ec == boost::asio::error::interrupted) {
-                continue; // Retry on interruption
-            }
-            throw std::runtime_error(std::string("Header read error: ") + read_ec.message());
-        }
-        
-        if (bytes > 0) {
-            total_read += bytes;
-        } else {
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
-        }
-    }
+    _readExact(response_buffer, HEADER_SIZE, timeout, generation, "header");
     
     // Validate header
     if (response_buffer[0] != 0xFF || response_buffer[1] != 0xFF) {
         throw std::runtime_error("Invalid header markers");
     }
-    if (response_buffer[2] != servo_id) {
-        throw std::runtime_error("Mismatched servo ID");
-    }
-    if (response_buffer[3] < 4) {
+    if (response_buffer[3] < 2) {
         throw std::runtime_error("Invalid length");
     }
     
     // Read remaining data
     const size_t remaining_bytes = response_buffer[3];
-    total_read = 0;
-    start_time = std::chrono::steady_clock::now();
+    _readExact(response_buffer + HEADER_SIZE, remaining_bytes, timeout, generation, "data");
+    return HEADER_SIZE + remaining_bytes;
+}
+
+std::vector<uint8_t> ST3215ServoReader::_readRegistersOnce(uint8_t servo_id, uint8_t address, uint8_t size,
+                                                           const std::chrono::milliseconds& timeout,
+                                                           uint64_t generation)
+{
+    _sendCommand(_createReadCommand(servo_id, address, size), generation);
     
-    while (total_read < remaining_bytes) {
-        if (std::chrono::steady_clock::now() - start_time > timeout) {
-            throw std::runtime_error("Timeout waiting for data");
-        }
-        
-        boost::system::error_code read_ec;
-        size_t bytes = _serial_port.read_some(
-            buffer(response_buffer.data() + HEADER_SIZE + total_read, 
-                  remaining_bytes - total_read),
-            read_ec
-        );
-        
-        if (read_ec) {
-            if (read_ec == boost::asio::error::operation_aborted ||
-                read_ec == boost::asio::error::interrupted) {
-                continue; // Retry on interruption
-            }
-            throw std::runtime_error(std::string("Data read error: ") + read_ec.message());
-        }
-        
-        if (bytes > 0) {
-            total_read += bytes;
-        } else {
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
-        }
+    // Read response using a fixed buffer
+    std::array<uint8_t, 256> response_buffer;
+    size_t length = _readStatusPacket(response_buffer.data(), timeout, generation);
+
+    size_t payload_size = 0;
+    const uint8_t* payload = parseStatusPacket(response_buffer.data(), length, servo_id, payload_size);
+    if (payload_size < size) {
+        throw std::runtime_error("Invalid length");
+    }
+    return std::vector<uint8_t>(payload, payload + size);
+}
+
+uint16_t ST3215ServoReader::parsePositionResponse(const uint8_t* packet, size_t length, uint8_t servo_id)
+{
+    size_t payload_size = 0;
+    const uint8_t* payload = parseStatusPacket(packet, length, servo_id, payload_size);
+    if (payload_size < 2) {
+        throw std::runtime_error("Invalid length");
     }
     
+    // Position is in little-endian format
+    return static_cast<uint16_t>(payload[0]) | (static_cast<uint16_t>(payload[1]) << 8);
+}
+
+const uint8_t* ST3215ServoReader::parseStatusPacket(const uint8_t* packet, size_t length, uint8_t servo_id,
+                                                    size_t& payload_size)
+{
+    const size_t HEADER_SIZE = 4;
+    if (length < HEADER_SIZE + 2) {
+        throw std::runtime_error("Response too short");
+    }
+
+    // Validate header
+    if (packet[0] != 0xFF || packet[1] != 0xFF) {
+        throw std::runtime_error("Invalid header markers");
+    }
+    if (packet[2] != servo_id) {
+        throw std::runtime_error("Mismatched servo ID");
+    }
+    if (packet[3] < 2 || HEADER_SIZE + packet[3] > length) {
+        throw std::runtime_error("Invalid length");
+    }
+
+    // A corrupted reply can still frame correctly; the checksum catches it
+    uint8_t checksum = 0;
+    for (size_t i = 2; i < HEADER_SIZE + packet[3] - 1u; ++i) {
+        checksum += packet[i];
+    }
+    if (static_cast<uint8_t>(~checksum) != packet[HEADER_SIZE + packet[3] - 1u]) {
+        throw std::runtime_error("Checksum mismatch");
+    }
+
     // Check for servo errors
-    if (response_buffer[HEADER_SIZE] != 0x00) {
+    if (packet[HEADER_SIZE] != 0x00) {
         std::string error = "Servo errors:";
-        if (response_buffer[HEADER_SIZE] & 0x01) error += " Input Voltage";
-        if (response_buffer[HEADER_SIZE] & 0x02) error += " Angle Limit";
-        if (response_buffer[HEADER_SIZE] & 0x04) error += " Overheating";
-        if (response_buffer[HEADER_SIZE] & 0x08) error += " Range";
-        if (response_buffer[HEADER_SIZE] & 0x10) error += " Checksum";
-        if (response_buffer[HEADER_SIZE] & 0x20) error += " Overload";
-        if (response_buffer[HEADER_SIZE] & 0x40) error += " Instruction";
+        if (packet[HEADER_SIZE] & 0x01) error += " Input Voltage";
+        if (packet[HEADER_SIZE] & 0x02) error += " Angle Limit";
+        if (packet[HEADER_SIZE] & 0x04) error += " Overheating";
+        if (packet[HEADER_SIZE] & 0x08) error += " Range";
+        if (packet[HEADER_SIZE] & 0x10) error += " Checksum";
+        if (packet[HEADER_SIZE] & 0x20) error += " Overload";
+        if (packet[HEADER_SIZE] & 0x40) error += " Instruction";
         throw std::runtime_error(error);
     }
-    
-    // Position is in little-endian format
-    return static_cast<uint16_t>(response_buffer[HEADER_SIZE + 1]) | 
-           (static_cast<uint16_t>(response_buffer[HEADER_SIZE + 2]) << 8);
+
+    payload_size = packet[3] - 2u;
+    return packet + HEADER_SIZE + 1;
 }
 
 std::vector<uint8_t> ST3215ServoReader::_createReadCommand(uint8_t id, uint8_t address, uint8_t size) 
@@ -258,4 +452,58 @@ std::vector<uint8_t> ST3215ServoReader::_createReadCommand(uint8_t id, uint8_t a
     command[command.size() - 1] = ~checksum;
 
     return command;
-}
\ No newline at end of file
+}
+
+std::vector<uint8_t> ST3215ServoReader::_createSyncReadCommand(const std::vector<uint8_t>& ids,
+                                                               uint8_t address, uint8_t size)
+{
+    std::vector<uint8_t> command = {
+        0xFF, 0xFF,                                 // Header
+        0xFE,                                       // Broadcast ID
+        static_cast<uint8_t>(ids.size() + 4),       // Length
+        0x82,                                       // SYNC_READ instruction
+        address,                                    // Starting address
+        size                                        // Number of bytes per servo
+    };
+    command.insert(command.end(), ids.begin(), ids.end());
+    command.push_back(0x00);                        // Checksum (to be calculated)
+
+    // Calculate checksum
+    uint8_t checksum = 0;
+    for (size_t i = 2; i < command.size() - 1; i++) 
+    {
+        checksum += command[i];
+    }
+    command[command.size() - 1] = ~checksum;
+
+    return command;
+}
+
+std::vector<uint8_t> ST3215ServoReader::_createSyncWriteCommand(const std::vector<uint8_t>& ids, uint8_t address,
+                                                                uint8_t size, const std::vector<uint8_t>& data)
+{
+    std::vector<uint8_t> command = {
+        0xFF, 0xFF,                                         // Header
+        0xFE,                                               // Broadcast ID
+        static_cast<uint8_t>(ids.size() * (size + 1) + 4),  // Length
+        0x83,                                               // SYNC_WRITE instruction
+        address,                                            // Starting address
+        size                                                // Number of bytes per servo
+    };
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+        command.push_back(ids[i]);
+        command.insert(command.end(), data.begin() + i * size, data.begin() + (i + 1) * size);
+    }
+    command.push_back(0x00);                                // Checksum (to be calculated)
+
+    // Calculate checksum
+    uint8_t checksum = 0;
+    for (size_t i = 2; i < command.size() - 1; i++) 
+    {
+        checksum += command[i];
+    }
+    command[command.size() - 1] = ~checksum;
+
+    return command;
+}
@@ -0,0 +1,126 @@
+#include "poll-scheduler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+namespace
+{
+
+// Time constant, in seconds, over which a joint's speed estimate falls away
+const double VELOCITY_DECAY_S = 0.5;
+
+}
+
+PollScheduler::PollScheduler(size_t joints, const Config &config)
+    : _config(config), _joints(joints), _selected(joints, false), _order(joints), _now()
+{
+    _config.budget = std::clamp<size_t>(_config.budget, 1, std::max<size_t>(1, joints));
+    _config.max_skip = std::max<size_t>(1, _config.max_skip);
+    _config.velocity_scale = std::max(1.0, _config.velocity_scale);
+}
+
+const std::vector<bool> &PollScheduler::select()
+{
+    double total_weight = 0.0;
+    for (const auto &joint : _joints)
+    {
+        total_weight += 1.0 + joint.velocity / _config.velocity_scale;
+    }
+
+    // Credit is handed out so that a full cycle's worth adds up to the budget
+    for (auto &joint : _joints)
+    {
+        const double weight = 1.0 + joint.velocity / _config.velocity_scale;
+        joint.credit = std::min(joint.credit + static_cast<double>(_config.budget) * weight / total_weight, 1.0);
+        ++joint.skipped;
+    }
+
+    // Overdue joints first, then the most credit
+    for (size_t i = 0; i < _order.size(); ++i)
+    {
+        _order[i] = i;
+    }
+    std::stable_sort(_order.begin(), _order.end(), [this](size_t a, size_t b) {
+        const bool overdue_a = _joints[a].skipped >= _config.max_skip;
+        const bool overdue_b = _joints[b].skipped >= _config.max_skip;
+        if (overdue_a != overdue_b)
+        {
+            return overdue_a;
+        }
+        return _joints[a].credit > _joints[b].credit;
+    });
+
+    std::fill(_selected.begin(), _selected.end(), false);
+    for (size_t n = 0; n < _config.budget && n < _order.size(); ++n)
+    {
+        Joint &joint = _joints[_order[n]];
+        _selected[_order[n]] = true;
+        joint.credit = std::max(joint.credit - 1.0, -1.0);
+        joint.skipped = 0;
+    }
+    return _selected;
+}
+
+void PollScheduler::observe(const std::vector<ServoData> &arm_data, uint64_t cycle, Clock::time_point now)
+{
+    _now = now;
+    for (size_t i = 0; i < _joints.size() && i < arm_data.size(); ++i)
+    {
+        const ServoData &servo = arm_data[i];
+        Joint &joint = _joints[i];
+        if (servo.staleAt(cycle) || !servo.error.empty() || servo.sampled == joint.sampled)
+        {
+            continue;
+        }
+        if (joint.sampled != Clock::time_point())
+        {
+            const double dt = std::chrono::duration<double>(servo.sampled - joint.sampled).count();
+            if (dt > 0.0)
+            {
+                const double speed = std::abs(static_cast<double>(servo.current) - joint.position) / dt;
+                joint.velocity = std::max(speed, joint.velocity * std::exp(-dt / VELOCITY_DECAY_S));
+                joint.interval_s = joint.interval_s == 0.0 ? dt : joint.interval_s + (dt - joint.interval_s) / 8.0;
+            }
+        }
+        joint.position = servo.current;
+        joint.sampled = servo.sampled;
+    }
+}
+
+std::vector<double> PollScheduler::rates() const
+{
+    std::vector<double> rates;
+    rates.reserve(_joints.size());
+    for (const auto &joint : _joints)
+    {
+        // A joint that has gone quiet should not keep showing its old rate
+        const double since = std::chrono::duration<double>(_now - joint.sampled).count();
+        const double interval = std::max(joint.interval_s, since);
+        rates.push_back(joint.interval_s > 0.0 && interval > 0.0 ? 1.0 / interval : 0.0);
+    }
+    return rates;
+}
+
+double PollScheduler::velocity(size_t joint) const
+{
+    return joint < _joints.size() ? _joints[joint].velocity : 0.0;
+}
+
+size_t PollScheduler::budget() const
+{
+    return _config.budget;
+}
+
+std::string formatPollLine(int arm_number, const PollScheduler &scheduler)
+{
+    std::ostringstream line;
+    line << "Arm " << arm_number << " poll rate (Hz, " << scheduler.budget() << " reads/cycle):" << std::fixed
+         << std::setprecision(0);
+    for (double rate : scheduler.rates())
+    {
+        line << " " << rate;
+    }
+    return line.str();
+}
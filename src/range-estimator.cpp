@@ -0,0 +1,186 @@
+#include "range-estimator.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace
+{
+
+uint16_t distance(uint16_t a, uint16_t b)
+{
+    return static_cast<uint16_t>(std::abs(static_cast<int>(a) - static_cast<int>(b)));
+}
+
+}
+
+RangeEstimator::RangeEstimator(uint16_t glitch_threshold, double tail)
+    : _bins{}, _glitch_threshold(glitch_threshold), _tail(std::clamp(tail, 0.0, 0.5)), _samples(0), _rejected(0),
+      _covered(0), _min(4095), _max(0), _last(0), _pending(0), _has_pending(false)
+{
+}
+
+void RangeEstimator::add(uint16_t position)
+{
+    position = std::min<uint16_t>(position, 4095);
+    if (_samples == 0)
+    {
+        _accept(position);
+        return;
+    }
+
+    if (_has_pending)
+    {
+        _has_pending = false;
+        if (distance(position, _last) <= _glitch_threshold)
+        {
+            ++_rejected;  // Went away for one reading and came straight back
+        }
+        else
+        {
+            _accept(_pending);
+        }
+    }
+
+    if (distance(position, _last) > _glitch_threshold)
+    {
+        _pending = position;
+        _has_pending = true;
+        return;
+    }
+    _accept(position);
+}
+
+void RangeEstimator::merge(const RangeEstimator& other)
+{
+    if (other._samples == 0)
+    {
+        _rejected += other._rejected;
+        return;
+    }
+    _covered = 0;
+    for (size_t bin = 0; bin < BIN_COUNT; ++bin)
+    {
+        _bins[bin] += other._bins[bin];
+        _covered += _bins[bin] > 0 ? 1 : 0;
+    }
+    _samples += other._samples;
+    _rejected += other._rejected;
+    _min = std::min(_min, other._min);
+    _max = std::max(_max, other._max);
+    _last = other._last;
+    _has_pending = false;
+}
+
+uint16_t RangeEstimator::quantile(double q) const
+{
+    if (_samples == 0)
+    {
+        return 0;
+    }
+
+    // Interpolate inside the bin, then keep within what was actually seen
+    const double target = std::clamp(q, 0.0, 1.0) * static_cast<double>(_samples);
+    double below = 0.0;
+    size_t bin = 0;
+    for (; bin + 1 < BIN_COUNT; ++bin)
+    {
+        if (below + _bins[bin] >= target && _bins[bin] > 0)
+        {
+            break;
+        }
+        below += _bins[bin];
+    }
+    const double fraction = _bins[bin] > 0 ? (target - below) / _bins[bin] : 0.0;
+    const double position = (static_cast<double>(bin) + fraction) * BIN_WIDTH;
+    return static_cast<uint16_t>(std::clamp(std::lround(position), static_cast<long>(_min), static_cast<long>(_max)));
+}
+
+uint16_t RangeEstimator::low() const
+{
+    return quantile(_tail);
+}
+
+uint16_t RangeEstimator::high() const
+{
+    return quantile(1.0 - _tail);
+}
+
+uint16_t RangeEstimator::min() const
+{
+    return _samples > 0 ? _min : 0;
+}
+
+uint16_t RangeEstimator::max() const
+{
+    return _max;
+}
+
+uint64_t RangeEstimator::samples() const
+{
+    return _samples;
+}
+
+uint64_t RangeEstimator::rejected() const
+{
+    return _rejected;
+}
+
+uint32_t RangeEstimator::binCount(size_t bin) const
+{
+    return bin < BIN_COUNT ? _bins[bin] : 0;
+}
+
+size_t RangeEstimator::coveredBins() const
+{
+    return _covered;
+}
+
+void RangeEstimator::_accept(uint16_t position)
+{
+    if (_bins[position / BIN_WIDTH]++ == 0)
+    {
+        ++_covered;
+    }
+    ++_samples;
+    _min = std::min(_min, position);
+    _max = std::max(_max, position);
+    _last = position;
+}
+
+ConvergenceDetector::ConvergenceDetector(Clock::duration quiet_period)
+    : _quiet_period(quiet_period), _covered(0), _started(false), _grown(false), _last_growth()
+{
+}
+
+bool ConvergenceDetector::update(size_t covered_bins, Clock::time_point now)
+{
+    // The first readings only establish where each joint starts
+    if (!_started)
+    {
+        _started = true;
+        _covered = covered_bins;
+        _last_growth = now;
+    }
+    else if (covered_bins > _covered)
+    {
+        _grown = true;
+        _covered = covered_bins;
+        _last_growth = now;
+    }
+    return converged(now);
+}
+
+bool ConvergenceDetector::converged(Clock::time_point now) const
+{
+    return _grown && now - _last_growth >= _quiet_period;
+}
+
+Clock::duration ConvergenceDetector::quietFor(Clock::time_point now) const
+{
+    return _grown ? now - _last_growth : Clock::duration::zero();
+}
+
+Clock::duration ConvergenceDetector::quietPeriod() const
+{
+    return _quiet_period;
+}
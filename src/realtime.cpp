@@ -0,0 +1,164 @@
+#include "realtime.hpp"
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+
+struct rusage threadUsage()
+{
+    struct rusage usage;
+    std::memset(&usage, 0, sizeof(usage));
+    getrusage(RUSAGE_THREAD, &usage);
+    return usage;
+}
+
+// One whole token of decimal digits, below limit
+int parseIndex(const std::string &token, int limit, const std::string &list)
+{
+    if (token.empty() || token.size() > 9 || token.find_first_not_of("0123456789") != std::string::npos)
+    {
+        throw std::runtime_error("Invalid entry '" + token + "' in list: " + list);
+    }
+    const int index = std::stoi(token);
+    if (index >= limit)
+    {
+        throw std::runtime_error(token + " is out of range 0-" + std::to_string(limit - 1) + " in list: " + list);
+    }
+    return index;
+}
+
+}
+
+std::vector<int> parseIndexList(const std::string &list, int limit)
+{
+    std::vector<int> indices;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ','))
+    {
+        const size_t dash = item.find('-');
+        const int first = parseIndex(item.substr(0, dash), limit, list);
+        const int last = dash == std::string::npos ? first : parseIndex(item.substr(dash + 1), limit, list);
+        if (last < first)
+        {
+            throw std::runtime_error("Reversed range " + item + " in list: " + list);
+        }
+        for (int index = first; index <= last; ++index)
+        {
+            indices.push_back(index);
+        }
+    }
+    if (indices.empty() || list.back() == ',')
+    {
+        throw std::runtime_error("Invalid list: " + list);
+    }
+    return indices;
+}
+
+std::vector<int> parseCpuList(const std::string &list)
+{
+    const long cpus = sysconf(_SC_NPROCESSORS_CONF);
+    return parseIndexList(list, cpus > 0 ? static_cast<int>(cpus) : 1);
+}
+
+void prefaultStack(size_t bytes)
+{
+    // volatile keeps the compiler from eliding the writes
+    volatile char *stack = static_cast<volatile char *>(alloca(bytes));
+    const long page = sysconf(_SC_PAGESIZE);
+    for (size_t i = 0; i < bytes; i += static_cast<size_t>(page))
+    {
+        stack[i] = 0;
+    }
+}
+
+void lockProcessMemory(const RealtimeConfig &config)
+{
+    // Keep freed heap memory in the process instead of returning it
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+    {
+        throw std::runtime_error(std::string("mlockall failed: ") + std::strerror(errno) +
+                                 " (needs CAP_IPC_LOCK or a higher 'ulimit -l')");
+    }
+
+    prefaultStack(config.stack_prefault_bytes);
+
+    // Fault in a block of heap and hand it back to the allocator; with trimming
+    // disabled it stays resident for later allocations
+    if (config.heap_prefault_bytes > 0)
+    {
+        char *heap = static_cast<char *>(std::malloc(config.heap_prefault_bytes));
+        if (heap)
+        {
+            const long page = sysconf(_SC_PAGESIZE);
+            for (size_t i = 0; i < config.heap_prefault_bytes; i += static_cast<size_t>(page))
+            {
+                heap[i] = 0;
+            }
+            std::free(heap);
+        }
+    }
+}
+
+void configureRealtimeThread(const RealtimeConfig &config, size_t thread_index)
+{
+    if (!config.cpus.empty())
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(config.cpus[thread_index % config.cpus.size()], &set);
+        int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (rc != 0)
+        {
+            throw std::runtime_error(std::string("Failed to pin thread: ") + std::strerror(rc));
+        }
+    }
+
+    struct sched_param param;
+    std::memset(&param, 0, sizeof(param));
+    param.sched_priority = config.priority;
+    int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (rc != 0)
+    {
+        throw std::runtime_error(std::string("Failed to set SCHED_FIFO priority: ") + std::strerror(rc) +
+                                 " (needs CAP_SYS_NICE or an rtprio limit)");
+    }
+
+    prefaultStack(config.stack_prefault_bytes);
+}
+
+void FaultMonitor::markSteadyState()
+{
+    struct rusage usage = threadUsage();
+    _minor_base = usage.ru_minflt;
+    _major_base = usage.ru_majflt;
+    _steady = true;
+}
+
+bool FaultMonitor::steady() const
+{
+    return _steady;
+}
+
+long FaultMonitor::minorFaults() const
+{
+    return _steady ? threadUsage().ru_minflt - _minor_base : 0;
+}
+
+long FaultMonitor::majorFaults() const
+{
+    return _steady ? threadUsage().ru_majflt - _major_base : 0;
+}
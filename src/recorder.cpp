@@ -0,0 +1,367 @@
+#include "recorder.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+constexpr char RecordingHeader::MAGIC[8];
+
+namespace
+{
+
+const size_t PAGE_SIZE = 4096;
+const uint32_t RECORDING_VERSION = 1;
+const std::chrono::seconds MAX_FLUSH_INTERVAL(1);
+
+}
+
+ArmRecord makeArmRecord(size_t arm, uint64_t cycle, const std::vector<ServoData>& arm_data, uint8_t flags,
+                        int64_t wall_ns, Clock::time_point now)
+{
+    ArmRecord record;
+    std::memset(&record, 0, sizeof(record));
+    record.cycle = cycle;
+    record.time_ns = wall_ns;
+    record.arm = static_cast<uint8_t>(arm);
+    record.joint_count = static_cast<uint8_t>(std::min(arm_data.size(), ArmRecord::MAX_JOINTS));
+    record.flags = flags;
+    for (size_t j = 0; j < ArmRecord::MAX_JOINTS; ++j)
+    {
+        record.positions[j] = ArmRecord::INVALID_POSITION;
+    }
+    for (size_t j = 0; j < record.joint_count; ++j)
+    {
+        const ServoData& servo = arm_data[j];
+        if (!servo.error.empty() || servo.sequence == 0 || (!(flags & ArmRecord::FLAG_ALIGNED) && servo.staleAt(cycle)))
+        {
+            continue;
+        }
+        record.positions[j] = servo.current;
+        record.joint_offset_us[j] =
+            static_cast<int32_t>(std::chrono::duration_cast<std::chrono::microseconds>(servo.sampled - now).count());
+    }
+    return record;
+}
+
+RecordPolicy parseRecordPolicy(const std::string& name)
+{
+    for (RecordPolicy policy :
+         {RecordPolicy::BLOCK, RecordPolicy::DROP_OLDEST, RecordPolicy::DROP_NEWEST, RecordPolicy::DECIMATE})
+    {
+        if (name == recordPolicyName(policy))
+        {
+            return policy;
+        }
+    }
+    throw std::runtime_error("Unknown record policy: " + name);
+}
+
+const char* recordPolicyName(RecordPolicy policy)
+{
+    switch (policy)
+    {
+    case RecordPolicy::BLOCK:
+        return "block";
+    case RecordPolicy::DROP_OLDEST:
+        return "drop-oldest";
+    case RecordPolicy::DROP_NEWEST:
+        return "drop-newest";
+    case RecordPolicy::DECIMATE:
+        return "decimate";
+    }
+    return "unknown";
+}
+
+Recorder::Recorder(const std::string& path, RecordPolicy policy, size_t capacity, size_t batch_bytes)
+    : _fd(-1), _policy(policy), _ring(capacity),
+      _batch_bytes(std::max(PAGE_SIZE, (batch_bytes + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE)), _buffer(nullptr),
+      _recorded(0), _written(0), _dropped_oldest(0), _dropped_newest(0), _decimated(0), _blocked(0),
+      _write_errors(0), _bytes(0), _high_watermark(0), _max_write_ns(0), _running(true)
+{
+    _fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (_fd < 0)
+    {
+        throw std::runtime_error("Failed to create recording " + path + ": " + std::strerror(errno));
+    }
+    _buffer = static_cast<uint8_t*>(std::aligned_alloc(PAGE_SIZE, _batch_bytes));
+    if (!_buffer)
+    {
+        ::close(_fd);
+        throw std::runtime_error("Failed to allocate recording buffer");
+    }
+    _thread = std::thread(&Recorder::_run, this);
+}
+
+Recorder::~Recorder()
+{
+    _running = false;
+    _thread.join();
+    ::close(_fd);
+    std::free(_buffer);
+}
+
+void Recorder::record(const ArmRecord& record)
+{
+    const size_t queued = _ring.size();
+    switch (_policy)
+    {
+    case RecordPolicy::BLOCK:
+        if (!_ring.push(record))
+        {
+            ++_blocked;
+            while (!_ring.push(record))
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+        break;
+    case RecordPolicy::DROP_OLDEST:
+        if (_ring.pushOverwrite(record))
+        {
+            ++_dropped_oldest;
+        }
+        break;
+    case RecordPolicy::DECIMATE:
+    {
+        // Decide by cycle so both arms of a kept cycle stay together
+        const size_t capacity = _ring.capacity();
+        const uint64_t keep_every = queued >= capacity * 3 / 4 ? 4 : queued >= capacity / 2 ? 2 : 1;
+        if (record.cycle % keep_every != 0)
+        {
+            ++_decimated;
+            return;
+        }
+    }
+        // fall through
+    case RecordPolicy::DROP_NEWEST:
+        if (!_ring.push(record))
+        {
+            ++_dropped_newest;
+            return;
+        }
+        break;
+    }
+    ++_recorded;
+    if (queued + 1 > _high_watermark.load(std::memory_order_relaxed))
+    {
+        _high_watermark.store(queued + 1, std::memory_order_relaxed);
+    }
+}
+
+Recorder::Stats Recorder::stats() const
+{
+    Stats stats;
+    stats.recorded = _recorded.load();
+    stats.written = _written.load();
+    stats.dropped_oldest = _dropped_oldest.load();
+    stats.dropped_newest = _dropped_newest.load();
+    stats.decimated = _decimated.load();
+    stats.blocked = _blocked.load();
+    stats.write_errors = _write_errors.load();
+    stats.bytes = _bytes.load();
+    stats.queued = _ring.size();
+    stats.high_watermark = std::min(_high_watermark.load(), _ring.capacity());
+    stats.capacity = _ring.capacity();
+    stats.max_write_ms = _max_write_ns.load() / 1e6;
+    return stats;
+}
+
+RecordPolicy Recorder::policy() const
+{
+    return _policy;
+}
+
+void Recorder::_run()
+{
+    RecordingHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, RecordingHeader::MAGIC, sizeof(header.magic));
+    header.version = RECORDING_VERSION;
+    header.record_size = sizeof(ArmRecord);
+    header.started_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::system_clock::now().time_since_epoch())
+                            .count();
+    std::memcpy(_buffer, &header, sizeof(header));
+    size_t used = sizeof(header);
+    size_t flushed = 0;  // Bytes of the current batch already in the file
+
+    ArmRecord record;
+    auto last_flush = std::chrono::steady_clock::now();
+    while (true)
+    {
+        // Read the flag before draining so nothing queued before the stop is lost
+        const bool stopping = !_running.load();
+        bool drained = true;
+        while (_ring.pop(record))
+        {
+            std::memcpy(_buffer + used, &record, sizeof(record));
+            used += sizeof(record);
+            if (used == _batch_bytes)
+            {
+                _flush(flushed, used);
+                used = 0;
+                flushed = 0;
+                last_flush = std::chrono::steady_clock::now();
+            }
+            drained = false;
+        }
+        if (stopping)
+        {
+            break;
+        }
+        if (drained)
+        {
+            // At low rates a batch takes minutes to fill; bound what a crash can lose.
+            // The batch keeps filling in place afterwards, so the next one still
+            // starts on a batch boundary instead of every later batch shifting off it
+            if (used > flushed && std::chrono::steady_clock::now() - last_flush >= MAX_FLUSH_INTERVAL)
+            {
+                flushed = _flush(flushed, used);
+                last_flush = std::chrono::steady_clock::now();
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+    if (used > flushed)
+    {
+        _flush(flushed, used);
+    }
+}
+
+size_t Recorder::_flush(size_t from, size_t to)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const size_t length = to - from;
+    size_t done = 0;
+    while (done < length)
+    {
+        const ssize_t n = ::write(_fd, _buffer + from + done, length - done);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            ++_write_errors;
+            break;
+        }
+        done += static_cast<size_t>(n);
+    }
+    const int64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                std::chrono::steady_clock::now() - start)
+                                .count();
+    if (elapsed > _max_write_ns.load(std::memory_order_relaxed))
+    {
+        _max_write_ns.store(elapsed, std::memory_order_relaxed);
+    }
+
+    // The header is not a record; count only whole records that made it out
+    const size_t header = _bytes.load() == 0 ? sizeof(RecordingHeader) : 0;
+    _bytes += done;
+    if (done > header)
+    {
+        _written += (done - header) / sizeof(ArmRecord);
+    }
+    return from + done;
+}
+
+std::string formatRecorderLine(const Recorder& recorder)
+{
+    const Recorder::Stats stats = recorder.stats();
+    std::ostringstream line;
+    line << "Recording (" << recordPolicyName(recorder.policy()) << "): " << stats.written << " written, "
+         << stats.queued << "/" << stats.capacity << " queued (peak " << stats.high_watermark << ")";
+    const uint64_t dropped = stats.dropped_oldest + stats.dropped_newest;
+    if (dropped > 0 || stats.decimated > 0)
+    {
+        line << ", dropped " << dropped << ", decimated " << stats.decimated;
+    }
+    if (stats.blocked > 0)
+    {
+        line << ", blocked " << stats.blocked;
+    }
+    if (stats.write_errors > 0)
+    {
+        line << ", WRITE ERRORS " << stats.write_errors;
+    }
+    line << std::fixed << std::setprecision(1) << ", slowest write " << stats.max_write_ms << " ms";
+    return line.str();
+}
+
+RecordingFile::RecordingFile(const std::string& path) : _data(nullptr), _bytes(0)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Failed to open recording " + path + ": " + std::strerror(errno));
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(RecordingHeader))
+    {
+        ::close(fd);
+        throw std::runtime_error("Not a recording: " + path);
+    }
+    _bytes = static_cast<size_t>(info.st_size);
+    _data = ::mmap(nullptr, _bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (_data == MAP_FAILED)
+    {
+        throw std::runtime_error("Failed to map recording " + path + ": " + std::strerror(errno));
+    }
+    ::madvise(_data, _bytes, MADV_SEQUENTIAL);
+
+    const RecordingHeader& h = header();
+    if (std::memcmp(h.magic, RecordingHeader::MAGIC, sizeof(h.magic)) != 0 || h.version != RECORDING_VERSION ||
+        h.record_size != sizeof(ArmRecord))
+    {
+        ::munmap(_data, _bytes);
+        throw std::runtime_error("Not a recording, or an unsupported version: " + path);
+    }
+}
+
+RecordingFile::~RecordingFile()
+{
+    ::munmap(_data, _bytes);
+}
+
+const RecordingHeader& RecordingFile::header() const
+{
+    return *static_cast<const RecordingHeader*>(_data);
+}
+
+size_t RecordingFile::size() const
+{
+    return (_bytes - sizeof(RecordingHeader)) / sizeof(ArmRecord);
+}
+
+const ArmRecord* RecordingFile::records() const
+{
+    return reinterpret_cast<const ArmRecord*>(static_cast<const uint8_t*>(_data) + sizeof(RecordingHeader));
+}
+
+size_t RecordingFile::bytes() const
+{
+    return _bytes;
+}
+
+std::vector<RecordBlock> splitRecordings(const std::vector<const RecordingFile*>& files, size_t block_records)
+{
+    block_records = std::max<size_t>(1, block_records);
+    std::vector<RecordBlock> blocks;
+    for (size_t f = 0; f < files.size(); ++f)
+    {
+        const RecordingFile& file = *files[f];
+        for (size_t offset = 0; offset < file.size(); offset += block_records)
+        {
+            blocks.push_back({f, file.records() + offset, file.records() + std::min(file.size(), offset + block_records)});
+        }
+    }
+    return blocks;
+}
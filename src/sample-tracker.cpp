@@ -0,0 +1,73 @@
+#include "sample-tracker.hpp"
+
+SampleTracker::SampleTracker(std::chrono::milliseconds stale_after)
+    : _stale_after(stale_after), _last_sequence(0), _last_sampled(), _interval_s(0.0), _received(0), _missed(0),
+      _restarts(0)
+{
+}
+
+uint64_t SampleTracker::observe(uint64_t sequence, Clock::time_point sampled)
+{
+    if (sequence == 0 || sequence == _last_sequence)
+    {
+        return 0;
+    }
+    if (sequence < _last_sequence)
+    {
+        // Start over rather than report a huge bogus gap
+        ++_restarts;
+        _last_sequence = 0;
+        _interval_s = 0.0;
+    }
+
+    uint64_t skipped = 0;
+    if (_last_sequence != 0)
+    {
+        skipped = sequence - _last_sequence - 1;
+        _missed += skipped;
+
+        // Per-sample interval, so a gap does not read as a slow producer
+        const double interval = std::chrono::duration<double>(sampled - _last_sampled).count() /
+                                static_cast<double>(sequence - _last_sequence);
+        _interval_s = _interval_s == 0.0 ? interval : _interval_s + (interval - _interval_s) / 8.0;
+    }
+    _last_sequence = sequence;
+    _last_sampled = sampled;
+    ++_received;
+    return skipped;
+}
+
+bool SampleTracker::stale(Clock::time_point now) const
+{
+    return _last_sequence == 0 || age(now) > _stale_after;
+}
+
+Clock::duration SampleTracker::age(Clock::time_point now) const
+{
+    return now - _last_sampled;
+}
+
+double SampleTracker::rate() const
+{
+    return _interval_s > 0.0 ? 1.0 / _interval_s : 0.0;
+}
+
+uint64_t SampleTracker::lastSequence() const
+{
+    return _last_sequence;
+}
+
+uint64_t SampleTracker::received() const
+{
+    return _received;
+}
+
+uint64_t SampleTracker::missed() const
+{
+    return _missed;
+}
+
+uint64_t SampleTracker::restarts() const
+{
+    return _restarts;
+}
@@ -0,0 +1,187 @@
+#include "sensor-monitor.hpp"
+#include <cstdlib>
+#include <sstream>
+
+namespace
+{
+
+size_t faultIndex(SensorMonitor::Fault fault)
+{
+    return fault == SensorMonitor::FROZEN ? 0 : fault == SensorMonitor::IMPLAUSIBLE ? 1 : 2;
+}
+
+}
+
+SensorMonitor::SensorMonitor(size_t joints, const Config &config)
+    : _config(config), _joints(joints), _travel(0), _events{0, 0, 0}
+{
+}
+
+void SensorMonitor::observe(const std::vector<ServoData> &arm_data, uint64_t cycle, Clock::time_point now)
+{
+    // Travel first, so a joint's run is judged against what its neighbours did this cycle too
+    for (size_t i = 0; i < _joints.size() && i < arm_data.size(); ++i)
+    {
+        const ServoData &servo = arm_data[i];
+        Joint &joint = _joints[i];
+        if (servo.staleAt(cycle) || !servo.error.empty())
+        {
+            continue;
+        }
+        if (!joint.anchored)
+        {
+            joint.anchored = true;
+            joint.anchor = servo.current;
+        }
+        const uint32_t moved = static_cast<uint32_t>(std::abs(static_cast<int>(servo.current) - joint.anchor));
+        if (moved > _config.deadband)
+        {
+            joint.anchor = servo.current;
+            joint.travel += moved;
+            _travel += moved;
+        }
+    }
+
+    for (size_t i = 0; i < _joints.size() && i < arm_data.size(); ++i)
+    {
+        const ServoData &servo = arm_data[i];
+        Joint &joint = _joints[i];
+        if (servo.staleAt(cycle) || !servo.error.empty())
+        {
+            continue;
+        }
+        const uint64_t others = _travel - joint.travel;
+
+        if (servo.current > 4095)
+        {
+            _raise(joint, IMPLAUSIBLE);
+            joint.implausible_at = now;
+        }
+        if (joint.seen)
+        {
+            const double elapsed_s = std::chrono::duration<double>(servo.sampled - joint.sampled).count();
+            if (elapsed_s <= 0.0)
+            {
+                _raise(joint, TIMING);
+                joint.timing_at = now;
+            }
+            else if (std::abs(static_cast<int>(servo.current) - static_cast<int>(joint.position)) >
+                     _config.max_speed * elapsed_s)
+            {
+                _raise(joint, IMPLAUSIBLE);
+                joint.implausible_at = now;
+            }
+
+            if (servo.current == joint.position)
+            {
+                ++joint.repeats;
+                if (joint.repeats >= _config.frozen_readings &&
+                    others - joint.others_at_run >= _config.activity_travel)
+                {
+                    _raise(joint, FROZEN);
+                }
+            }
+            else
+            {
+                joint.repeats = 0;
+                joint.others_at_run = others;
+                joint.faults &= ~FROZEN;
+            }
+        }
+        else
+        {
+            joint.others_at_run = others;
+        }
+        joint.seen = true;
+        joint.position = servo.current;
+        joint.sampled = servo.sampled;
+    }
+
+    for (Joint &joint : _joints)
+    {
+        if ((joint.faults & IMPLAUSIBLE) && now - joint.implausible_at >= _config.hold)
+        {
+            joint.faults &= ~IMPLAUSIBLE;
+        }
+        if ((joint.faults & TIMING) && now - joint.timing_at >= _config.hold)
+        {
+            joint.faults &= ~TIMING;
+        }
+    }
+}
+
+void SensorMonitor::_raise(Joint &joint, Fault fault)
+{
+    if (!(joint.faults & fault))
+    {
+        joint.faults |= fault;
+        ++_events[faultIndex(fault)];
+    }
+}
+
+uint8_t SensorMonitor::faults(size_t joint) const
+{
+    return joint < _joints.size() ? _joints[joint].faults : 0;
+}
+
+size_t SensorMonitor::flagged() const
+{
+    size_t count = 0;
+    for (const Joint &joint : _joints)
+    {
+        count += joint.faults != 0;
+    }
+    return count;
+}
+
+uint64_t SensorMonitor::events(Fault fault) const
+{
+    return _events[faultIndex(fault)];
+}
+
+size_t SensorMonitor::joints() const
+{
+    return _joints.size();
+}
+
+std::string formatSensorLine(const std::vector<const SensorMonitor *> &monitors)
+{
+    std::ostringstream line;
+    line << "Sensors:";
+    uint64_t frozen = 0, implausible = 0, timing = 0;
+    for (size_t arm = 0; arm < monitors.size(); ++arm)
+    {
+        const SensorMonitor &monitor = *monitors[arm];
+        line << (arm == 0 ? " arm " : ", arm ") << arm + 1;
+        if (monitor.flagged() == 0)
+        {
+            line << " ok";
+        }
+        for (size_t joint = 0; joint < monitor.joints(); ++joint)
+        {
+            const uint8_t faults = monitor.faults(joint);
+            if (faults == 0)
+            {
+                continue;
+            }
+            line << " joint " << joint + 1;
+            if (faults & SensorMonitor::FROZEN)
+            {
+                line << " FROZEN";
+            }
+            if (faults & SensorMonitor::IMPLAUSIBLE)
+            {
+                line << " IMPLAUSIBLE";
+            }
+            if (faults & SensorMonitor::TIMING)
+            {
+                line << " TIMING";
+            }
+        }
+        frozen += monitor.events(SensorMonitor::FROZEN);
+        implausible += monitor.events(SensorMonitor::IMPLAUSIBLE);
+        timing += monitor.events(SensorMonitor::TIMING);
+    }
+    line << " | events: frozen " << frozen << ", implausible " << implausible << ", timing " << timing;
+    return line.str();
+}
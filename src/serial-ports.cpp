@@ -0,0 +1,76 @@
+#include "serial-ports.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+// Find available serial ports
+std::vector<std::string> findSerialPorts()
+{
+    std::vector<std::string> ports;
+    const std::filesystem::path dev_path("/dev");
+
+    for (const auto &entry : std::filesystem::directory_iterator(dev_path))
+    {
+        std::string filename = entry.path().filename().string();
+        if (isSerialPortName(filename))
+        {
+            ports.push_back(entry.path().string());
+        }
+    }
+
+    std::sort(ports.begin(), ports.end());
+    return ports;
+}
+
+bool isSerialPortName(const std::string &filename)
+{
+    return filename.find("ttyUSB") != std::string::npos ||
+           filename.find("ttyACM") != std::string::npos;
+}
+
+std::string usbSerialForPort(const std::string &port)
+{
+    std::error_code ec;
+    const std::filesystem::path device = std::filesystem::canonical(port, ec);
+    if (ec)
+    {
+        return "";
+    }
+
+    // /sys/class/tty/<name>/device points at the USB interface; the serial
+    // attribute lives on the parent USB device a level or two above it
+    std::filesystem::path sys_path = std::filesystem::path("/sys/class/tty") / device.filename() / "device";
+    sys_path = std::filesystem::canonical(sys_path, ec);
+    if (ec)
+    {
+        return "";
+    }
+
+    for (int depth = 0; depth < 4 && sys_path.has_parent_path(); ++depth)
+    {
+        std::ifstream serial_file(sys_path / "serial");
+        std::string serial;
+        if (serial_file && std::getline(serial_file, serial) && !serial.empty())
+        {
+            return serial;
+        }
+        sys_path = sys_path.parent_path();
+    }
+    return "";
+}
+
+std::string findPortByUsbSerial(const std::string &serial)
+{
+    if (serial.empty())
+    {
+        return "";
+    }
+    for (const auto &port : findSerialPorts())
+    {
+        if (usbSerialForPort(port) == serial)
+        {
+            return port;
+        }
+    }
+    return "";
+}
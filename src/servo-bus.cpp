@@ -0,0 +1,378 @@
+#include "servo-bus.hpp"
+#include "emergency-stop.hpp"
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+
+// Cycles before the bus thread counts page faults as steady-state faults
+const uint64_t STEADY_STATE_CYCLES = 50;
+
+// Storage set aside up front so ordinary cycles never grow it
+const size_t RESERVED_GROUPS = 8;
+const size_t RESERVED_IDS = 32;
+
+}
+
+ServoBus::ServoBus(ArmLink& link, const RealtimeConfig& rt, size_t thread_index, size_t max_sync_reads_per_cycle)
+    : _link(link), _rt(rt), _thread_index(thread_index),
+      _max_sync_reads(std::max<size_t>(max_sync_reads_per_cycle, 1)), _queue(QUEUE_CAPACITY),
+      _wake_fd(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)), _sleeping(false), _running(true),
+      _cycles(0), _requests(0), _sync_reads(0), _sync_writes(0), _deferred(0), _busy_ns(0), _steady(false),
+      _minor_faults(0), _major_faults(0)
+{
+    _groups.resize(RESERVED_GROUPS);
+    for (auto& group : _groups)
+    {
+        group.ids.reserve(RESERVED_IDS);
+        group.data.reserve(RESERVED_IDS * MAX_WRITE_SIZE);
+        group.replies.reserve(RESERVED_IDS);
+    }
+    _order.reserve(RESERVED_GROUPS);
+
+    // Real-time setup happens on the bus thread itself; surface its failure here
+    std::promise<void> started;
+    auto started_future = started.get_future();
+    _thread = std::thread(&ServoBus::_run, this, std::move(started));
+    try
+    {
+        started_future.get();
+    }
+    catch (...)
+    {
+        _thread.join();
+        ::close(_wake_fd);
+        throw;
+    }
+}
+
+ServoBus::~ServoBus()
+{
+    _running = false;
+    uint64_t one = 1;
+    ssize_t ignored = ::write(_wake_fd, &one, sizeof(one));
+    (void)ignored;
+    if (_thread.joinable())
+    {
+        _thread.join();
+    }
+    ::close(_wake_fd);
+}
+
+std::future<ST3215ServoReader::ServoReply> ServoBus::read(uint8_t servo_id, uint8_t address, uint8_t size,
+                                                          BusPriority priority)
+{
+    Request request;
+    request.servo_id = servo_id;
+    request.address = address;
+    request.size = size;
+    request.priority = priority;
+    return _submit(std::move(request));
+}
+
+std::future<ST3215ServoReader::ServoReply> ServoBus::write(uint8_t servo_id, uint8_t address, const uint8_t* data,
+                                                           uint8_t size, BusPriority priority)
+{
+    if (size > MAX_WRITE_SIZE)
+    {
+        throw std::runtime_error("Bus write of " + std::to_string(size) + " bytes exceeds the maximum of " +
+                                 std::to_string(MAX_WRITE_SIZE));
+    }
+    Request request;
+    request.servo_id = servo_id;
+    request.address = address;
+    request.size = size;
+    request.priority = priority;
+    request.write = true;
+    std::copy(data, data + size, request.data.begin());
+    return _submit(std::move(request));
+}
+
+std::future<ST3215ServoReader::ServoReply> ServoBus::_submit(Request request)
+{
+    auto future = request.reply.get_future();
+    if (!_queue.push(std::move(request)))
+    {
+        ST3215ServoReader::ServoReply reply;
+        reply.id = request.servo_id;
+        reply.error = "Bus queue full";
+        request.reply.set_value(reply);
+        return future;
+    }
+
+    // Only pay for the syscall when the bus thread is actually parked
+    if (_sleeping.load())
+    {
+        uint64_t one = 1;
+        ssize_t ignored = ::write(_wake_fd, &one, sizeof(one));
+        (void)ignored;
+    }
+    return future;
+}
+
+ServoBus::Stats ServoBus::stats() const
+{
+    Stats stats;
+    stats.cycles = _cycles;
+    stats.requests = _requests;
+    stats.sync_reads = _sync_reads;
+    stats.sync_writes = _sync_writes;
+    stats.deferred = _deferred;
+    stats.busy_ns = _busy_ns;
+    stats.steady = _steady;
+    stats.minor_faults = _minor_faults;
+    stats.major_faults = _major_faults;
+    return stats;
+}
+
+void ServoBus::_run(std::promise<void> started)
+{
+    if (_rt.enabled)
+    {
+        try
+        {
+            configureRealtimeThread(_rt, _thread_index);
+        }
+        catch (...)
+        {
+            started.set_exception(std::current_exception());
+            return;
+        }
+    }
+    started.set_value();
+
+    FaultMonitor faults;
+    std::vector<Request> pending;
+    pending.reserve(64);
+
+    while (_running)
+    {
+        // Groups deferred by the last cycle do not start one of their own:
+        // they ride along with the next requests a client queues, or go out
+        // once the wait times out with none
+        const size_t carried = pending.size();
+        _drainQueue(pending);
+        if (pending.size() == carried)
+        {
+            // Announce the intent to sleep before the final emptiness check so
+            // a concurrent read() either lands in the queue we drain or sees
+            // the flag and wakes us
+            _sleeping = true;
+            _drainQueue(pending);
+            if (pending.size() == carried)
+            {
+                _waitForWork();
+            }
+            _sleeping = false;
+            _drainQueue(pending);
+            if (pending.empty() || !_running)
+            {
+                continue;
+            }
+        }
+
+        const auto started_cycle = std::chrono::steady_clock::now();
+        _serveCycle(pending);
+        _busy_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                                         started_cycle).count();
+
+        const uint64_t cycles = ++_cycles;
+        if (_rt.enabled && cycles == STEADY_STATE_CYCLES)
+        {
+            faults.markSteadyState();
+            _steady = true;
+        }
+        if (faults.steady())
+        {
+            _minor_faults = faults.minorFaults();
+            _major_faults = faults.majorFaults();
+        }
+    }
+
+    // Fail whatever is left so no client waits forever
+    _drainQueue(pending);
+    for (auto& left : pending)
+    {
+        ST3215ServoReader::ServoReply reply;
+        reply.id = left.servo_id;
+        reply.error = "Bus stopped";
+        left.reply.set_value(reply);
+    }
+}
+
+void ServoBus::_drainQueue(std::vector<Request>& pending)
+{
+    Request request;
+    while (_queue.pop(request))
+    {
+        pending.push_back(std::move(request));
+        ++_requests;
+    }
+}
+
+void ServoBus::_waitForWork()
+{
+    // The timeout bounds how long a stop request can go unnoticed, and how
+    // long deferred groups wait when no client queues anything
+    struct pollfd pfd = {_wake_fd, POLLIN, 0};
+    ::poll(&pfd, 1, 100);
+    uint64_t value;
+    while (::read(_wake_fd, &value, sizeof(value)) > 0)
+    {
+    }
+}
+
+void ServoBus::_serveCycle(std::vector<Request>& pending)
+{
+    // One group per direction and register block, carrying the union of
+    // requested IDs (and, for writes, the latest data per ID). Groups and
+    // their buffers are reused from cycle to cycle.
+    size_t group_count = 0;
+    for (const auto& request : pending)
+    {
+        auto group = std::find_if(_groups.begin(), _groups.begin() + group_count, [&](const Group& g) {
+            return g.write == request.write && g.address == request.address && g.size == request.size;
+        });
+        if (group == _groups.begin() + group_count)
+        {
+            if (group_count == _groups.size())
+            {
+                _groups.emplace_back();
+            }
+            group = _groups.begin() + group_count++;
+            group->write = request.write;
+            group->address = request.address;
+            group->size = request.size;
+            group->priority = request.priority;
+            group->ids.clear();
+            group->data.clear();
+        }
+        group->priority = std::min(group->priority, request.priority);
+        auto id = std::find(group->ids.begin(), group->ids.end(), request.servo_id);
+        if (id == group->ids.end())
+        {
+            group->ids.push_back(request.servo_id);
+            if (request.write)
+            {
+                group->data.insert(group->data.end(), request.data.begin(), request.data.begin() + request.size);
+            }
+        }
+        else if (request.write)
+        {
+            std::copy(request.data.begin(), request.data.begin() + request.size,
+                      group->data.begin() + (id - group->ids.begin()) * request.size);
+        }
+    }
+
+    // Control before diagnostics, writes before reads, otherwise first come
+    // first served: a stable insertion sort of group indices, which unlike
+    // std::stable_sort needs no scratch buffer
+    _order.clear();
+    for (size_t i = 0; i < group_count; ++i)
+    {
+        const Group& group = _groups[i];
+        size_t at = _order.size();
+        _order.push_back(i);
+        while (at > 0)
+        {
+            const Group& before = _groups[_order[at - 1]];
+            const bool earlier = group.priority != before.priority ? group.priority < before.priority
+                                                                   : group.write > before.write;
+            if (!earlier)
+            {
+                break;
+            }
+            _order[at] = _order[at - 1];
+            --at;
+        }
+        _order[at] = i;
+    }
+
+    size_t budget = _max_sync_reads;
+    for (size_t index : _order)
+    {
+        Group& group = _groups[index];
+        if (group.priority != BusPriority::CONTROL && budget == 0)
+        {
+            ++_deferred;
+            continue;  // Left in pending for the next cycle a client schedules
+        }
+        budget = budget > 0 ? budget - 1 : 0;
+
+        auto answerAll = [&](const std::string& why) {
+            group.replies.resize(group.ids.size());
+            for (size_t i = 0; i < group.ids.size(); ++i)
+            {
+                group.replies[i].id = group.ids[i];
+                group.replies[i].data.clear();
+                group.replies[i].error = why;
+                group.replies[i].completed = Clock::time_point();
+            }
+        };
+        if (group.write)
+        {
+            std::string failure;
+            try
+            {
+                failure = _link.syncWrite(group.ids, group.address, group.size, group.data);
+            }
+            catch (const EmergencyStopError& e)
+            {
+                failure = e.what();
+            }
+            answerAll(failure);
+            ++_sync_writes;
+        }
+        else
+        {
+            std::sort(group.ids.begin(), group.ids.end());
+            try
+            {
+                _link.syncRead(group.ids, group.address, group.size, group.replies);
+            }
+            catch (const EmergencyStopError& e)
+            {
+                answerAll(e.what());
+            }
+            ++_sync_reads;
+        }
+
+        // Answer every request for this block, duplicates included
+        size_t kept = 0;
+        for (size_t i = 0; i < pending.size(); ++i)
+        {
+            Request& request = pending[i];
+            if (request.write == group.write && request.address == group.address && request.size == group.size)
+            {
+                auto reply = std::find_if(group.replies.begin(), group.replies.end(),
+                                          [&](const ST3215ServoReader::ServoReply& r) {
+                                              return r.id == request.servo_id;
+                                          });
+                if (reply != group.replies.end())
+                {
+                    request.reply.set_value(*reply);
+                }
+                else
+                {
+                    ST3215ServoReader::ServoReply missing;
+                    missing.id = request.servo_id;
+                    missing.error = "No reply to sync read";
+                    request.reply.set_value(missing);
+                }
+            }
+            else
+            {
+                if (kept != i)
+                {
+                    pending[kept] = std::move(request);
+                }
+                ++kept;
+            }
+        }
+        pending.resize(kept);
+    }
+}
@@ -0,0 +1,381 @@
+#include "servo-simulator.hpp"
+#include <pty.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+
+const uint8_t INST_PING = 0x01;
+const uint8_t INST_READ = 0x02;
+const uint8_t INST_WRITE = 0x03;
+const uint8_t INST_SYNC_READ = 0x82;
+const uint8_t INST_SYNC_WRITE = 0x83;
+const uint8_t BROADCAST_ID = 0xFE;
+const uint8_t ADDR_TORQUE_ENABLE = 0x28;
+const uint8_t ADDR_GOAL_POSITION = 0x2A;
+const uint8_t ADDR_PRESENT_POSITION = 0x38;
+const uint8_t ADDR_PRESENT_TEMPERATURE = 0x3F;
+
+}
+
+ST3215Simulator::ST3215Simulator(const std::vector<uint8_t>& servo_ids, Clock& clock)
+    : _master_fd(-1), _slave_fd(-1), _clock(clock), _virtual_clock(dynamic_cast<VirtualClock*>(&clock)),
+      _idle_probe(0), _requests(0), _torque_disabled_at(0), _busy(false), _running(true)
+{
+    _openPty();
+
+    for (size_t i = 0; i < servo_ids.size(); ++i)
+    {
+        Servo& servo = _servos[servo_ids[i]];
+        servo.present = true;
+        servo.center = static_cast<uint16_t>(1024 + 256 * (i % 8));
+        servo.amplitude = 400;
+        servo.period = std::chrono::milliseconds(1500 + 250 * static_cast<int>(i));
+        servo.memory[0x05] = servo_ids[i];  // ID register
+        servo.memory[ADDR_TORQUE_ENABLE] = 1;
+        servo.memory[ADDR_PRESENT_TEMPERATURE] = static_cast<uint8_t>(30 + i);
+    }
+
+    _start_time = _clock.now();
+    if (_virtual_clock)
+    {
+        _idle_probe = _virtual_clock->addIdleProbe([this]() { return _idle(); });
+    }
+    _thread = std::thread(&ST3215Simulator::_run, this);
+}
+
+ST3215Simulator::~ST3215Simulator()
+{
+    if (_virtual_clock)
+    {
+        _virtual_clock->removeIdleProbe(_idle_probe);
+    }
+    unplug();
+}
+
+void ST3215Simulator::unplug()
+{
+    _running = false;
+    if (_thread.joinable())
+    {
+        _thread.join();
+    }
+    // Closing both ends hangs up the reader's fd like a USB disconnect
+    if (_master_fd >= 0)
+    {
+        ::close(_master_fd);
+        ::close(_slave_fd);
+        _master_fd = -1;
+        _slave_fd = -1;
+    }
+}
+
+void ST3215Simulator::replug()
+{
+    if (_master_fd >= 0)
+    {
+        return;
+    }
+    _openPty();
+    _running = true;
+    _thread = std::thread(&ST3215Simulator::_run, this);
+}
+
+void ST3215Simulator::_openPty()
+{
+    char name[128];
+    if (::openpty(&_master_fd, &_slave_fd, name, nullptr, nullptr) != 0)
+    {
+        throw std::runtime_error("Failed to create simulator pty");
+    }
+    _slave_name = name;
+
+    // Raw mode on both ends so no byte is echoed or translated before the
+    // reader applies its own settings
+    struct termios tio;
+    if (tcgetattr(_slave_fd, &tio) == 0)
+    {
+        cfmakeraw(&tio);
+        tcsetattr(_slave_fd, TCSANOW, &tio);
+    }
+}
+
+const std::string& ST3215Simulator::portName() const
+{
+    return _slave_name;
+}
+
+void ST3215Simulator::setMotion(uint8_t servo_id, uint16_t center, uint16_t amplitude,
+                                std::chrono::milliseconds period)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    Servo& servo = _servos[servo_id];
+    servo.center = center;
+    servo.amplitude = amplitude;
+    servo.period = period;
+}
+
+uint64_t ST3215Simulator::requestCount() const
+{
+    return _requests.load();
+}
+
+void ST3215Simulator::_run()
+{
+    std::vector<uint8_t> rx;
+    std::array<uint8_t, 256> chunk;
+
+    while (_running)
+    {
+        struct pollfd pfd = {_master_fd, POLLIN, 0};
+        int ready = ::poll(&pfd, 1, 20);
+        if (ready <= 0 || !(pfd.revents & POLLIN))
+        {
+            continue;
+        }
+
+        // Marked busy before consuming input so _idle() never sees the gap
+        // between the bytes leaving the pty and the reply being written
+        _busy = true;
+        ssize_t bytes = ::read(_master_fd, chunk.data(), chunk.size());
+        if (bytes > 0)
+        {
+            rx.insert(rx.end(), chunk.begin(), chunk.begin() + bytes);
+            rx.erase(rx.begin(), rx.begin() + _handleFrames(rx));
+        }
+        _busy = false;
+    }
+}
+
+bool ST3215Simulator::_idle() const
+{
+    // Pending input is checked before the busy flag; see _run() for ordering
+    struct pollfd pfd = {_master_fd, POLLIN, 0};
+    if (::poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN))
+    {
+        return false;
+    }
+    return !_busy;
+}
+
+size_t ST3215Simulator::_handleFrames(std::vector<uint8_t>& rx)
+{
+    size_t pos = 0;
+    while (rx.size() - pos >= 6)
+    {
+        // Resynchronise on the 0xFF 0xFF header
+        if (rx[pos] != 0xFF || rx[pos + 1] != 0xFF)
+        {
+            ++pos;
+            continue;
+        }
+
+        const uint8_t id = rx[pos + 2];
+        const uint8_t length = rx[pos + 3];
+        if (length < 2)
+        {
+            pos += 2;
+            continue;
+        }
+        if (rx.size() - pos < 4u + length)
+        {
+            break;  // Wait for the rest of the packet
+        }
+
+        uint8_t checksum = 0;
+        for (size_t i = 2; i < 3u + length; ++i)
+        {
+            checksum += rx[pos + i];
+        }
+        if (static_cast<uint8_t>(~checksum) == rx[pos + 3 + length])
+        {
+            _handlePacket(id, rx[pos + 4], &rx[pos + 5], length - 2);
+        }
+        pos += 4u + length;
+    }
+    return pos;
+}
+
+void ST3215Simulator::_handlePacket(uint8_t id, uint8_t instruction, const uint8_t* params, size_t param_count)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_requests;
+
+    // Broadcast writes apply to every servo and are never answered; sync
+    // reads are answered by each listed servo in turn
+    if (id == BROADCAST_ID)
+    {
+        if (instruction == INST_SYNC_READ && param_count >= 2)
+        {
+            const uint8_t address = params[0];
+            const uint8_t size = params[1];
+            for (size_t i = 2; i < param_count; ++i)
+            {
+                Servo& target = _servos[params[i]];
+                if (target.present && address + size <= target.memory.size())
+                {
+                    _updatePosition(target);
+                    _reply(params[i], 0, target.memory.data() + address, size);
+                }
+            }
+            return;
+        }
+        if (instruction == INST_SYNC_WRITE && param_count >= 2)
+        {
+            // address, size, then an ID followed by size bytes per servo
+            const uint8_t address = params[0];
+            const uint8_t size = params[1];
+            for (size_t i = 2; i + 1 + size <= param_count; i += 1 + size)
+            {
+                Servo& target = _servos[params[i]];
+                if (target.present)
+                {
+                    _write(target, address, params + i + 1, size);
+                }
+            }
+            return;
+        }
+        if (instruction == INST_WRITE && param_count >= 2)
+        {
+            for (auto& servo : _servos)
+            {
+                if (servo.present)
+                {
+                    _write(servo, params[0], params + 1, param_count - 1);
+                }
+            }
+        }
+        return;
+    }
+
+    Servo& servo = _servos[id];
+    if (!servo.present)
+    {
+        return;  // Absent servos stay silent, as on a real bus
+    }
+
+    switch (instruction)
+    {
+    case INST_PING:
+        _reply(id, 0, nullptr, 0);
+        break;
+    case INST_READ:
+    {
+        if (param_count < 2)
+        {
+            _reply(id, 0x40, nullptr, 0);
+            break;
+        }
+        const uint8_t address = params[0];
+        const uint8_t size = params[1];
+        if (address + size > servo.memory.size())
+        {
+            _reply(id, 0x08, nullptr, 0);
+            break;
+        }
+        _updatePosition(servo);
+        _reply(id, 0, servo.memory.data() + address, size);
+        break;
+    }
+    case INST_WRITE:
+        if (param_count < 2 || params[0] + param_count - 1 > servo.memory.size())
+        {
+            _reply(id, 0x08, nullptr, 0);
+            break;
+        }
+        _write(servo, params[0], params + 1, param_count - 1);
+        _reply(id, 0, nullptr, 0);
+        break;
+    default:
+        _reply(id, 0x40, nullptr, 0);
+        break;
+    }
+}
+
+void ST3215Simulator::_write(Servo& servo, uint8_t address, const uint8_t* data, size_t size)
+{
+    for (size_t i = 0; i < size && address + i < servo.memory.size(); ++i)
+    {
+        servo.memory[address + i] = data[i];
+    }
+    if (address <= ADDR_TORQUE_ENABLE && ADDR_TORQUE_ENABLE < address + size &&
+        servo.memory[ADDR_TORQUE_ENABLE] == 0)
+    {
+        _torque_disabled_at = _clock.now().time_since_epoch().count();
+    }
+    if (address <= ADDR_GOAL_POSITION + 1 && ADDR_GOAL_POSITION < address + size)
+    {
+        servo.following = true;
+    }
+}
+
+uint16_t ST3215Simulator::goalPosition(uint8_t servo_id)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    const Servo& servo = _servos[servo_id];
+    return static_cast<uint16_t>(servo.memory[ADDR_GOAL_POSITION] | (servo.memory[ADDR_GOAL_POSITION + 1] << 8));
+}
+
+bool ST3215Simulator::torqueEnabled(uint8_t servo_id)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _servos[servo_id].memory[ADDR_TORQUE_ENABLE] != 0;
+}
+
+Clock::time_point ST3215Simulator::lastTorqueDisableTime() const
+{
+    return Clock::time_point(Clock::duration(_torque_disabled_at.load()));
+}
+
+void ST3215Simulator::_updatePosition(Servo& servo)
+{
+    // Once commanded, a servo holds its goal instead of sweeping; with torque
+    // off it stays wherever it was
+    if (servo.following)
+    {
+        if (servo.memory[ADDR_TORQUE_ENABLE] != 0)
+        {
+            servo.memory[ADDR_PRESENT_POSITION] = servo.memory[ADDR_GOAL_POSITION];
+            servo.memory[ADDR_PRESENT_POSITION + 1] = servo.memory[ADDR_GOAL_POSITION + 1];
+        }
+        return;
+    }
+
+    const double t = std::chrono::duration<double>(_clock.now() - _start_time).count();
+    const double period = std::chrono::duration<double>(servo.period).count();
+    const double phase = 2.0 * M_PI * t / period;
+    const double value = servo.center + servo.amplitude * std::sin(phase);
+    const uint16_t position = static_cast<uint16_t>(std::clamp(value, 0.0, 4095.0));
+
+    servo.memory[ADDR_PRESENT_POSITION] = static_cast<uint8_t>(position & 0xFF);
+    servo.memory[ADDR_PRESENT_POSITION + 1] = static_cast<uint8_t>(position >> 8);
+}
+
+void ST3215Simulator::_reply(uint8_t id, uint8_t error, const uint8_t* data, size_t size)
+{
+    std::vector<uint8_t> packet = {0xFF, 0xFF, id, static_cast<uint8_t>(size + 2), error};
+    packet.insert(packet.end(), data, data + size);
+
+    uint8_t checksum = 0;
+    for (size_t i = 2; i < packet.size(); ++i)
+    {
+        checksum += packet[i];
+    }
+    packet.push_back(~checksum);
+
+    size_t written = 0;
+    while (written < packet.size())
+    {
+        ssize_t bytes = ::write(_master_fd, packet.data() + written, packet.size() - written);
+        if (bytes <= 0)
+        {
+            return;
+        }
+        written += static_cast<size_t>(bytes);
+    }
+}
@@ -0,0 +1,328 @@
+#include "shared-state.hpp"
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+const char* const DEFAULT_SHARED_STATE_NAME = "/perseus-armd";
+
+namespace
+{
+
+const uint32_t SHARED_STATE_MAGIC = 0x50415253;  // "PARS"
+const uint32_t SHARED_STATE_VERSION = 3;
+
+struct SharedJoint
+{
+    uint16_t current;
+    uint16_t min;
+    uint16_t max;
+    int16_t temperature;
+    uint64_t sequence;
+    int64_t sampled_ns;
+    char error[64];
+};
+
+struct SharedArm
+{
+    char port[128];
+    char link_status[96];
+    uint64_t cycle;
+    uint32_t joint_count;
+    SharedJoint joints[SharedStatePublisher::MAX_JOINTS];
+};
+
+// Everything covered by the seqlock; plain data so it can be copied with memcpy
+struct SharedPayload
+{
+    int64_t published_ns;
+    uint32_t arm_count;
+    uint32_t status_line_count;
+    uint8_t emergency_stop;
+    SharedArm arms[SharedStatePublisher::MAX_ARMS];
+    char status_lines[SharedStatePublisher::MAX_STATUS_LINES][160];
+};
+
+template <size_t N>
+void copyString(char (&dest)[N], const std::string& src)
+{
+    const size_t length = std::min(src.size(), N - 1);
+    std::memcpy(dest, src.data(), length);
+    dest[length] = '\0';
+}
+
+template <size_t N>
+std::string readString(const char (&src)[N])
+{
+    return std::string(src, strnlen(src, N));
+}
+
+bool processAlive(pid_t pid)
+{
+    return pid > 0 && (::kill(pid, 0) == 0 || errno == EPERM);
+}
+
+}
+
+struct SharedStateLayout
+{
+    std::atomic<uint32_t> magic;
+    uint32_t version;
+    std::atomic<int32_t> daemon_pid;
+    std::atomic<uint32_t> closed;
+    std::atomic<uint32_t> commands;
+    std::atomic<uint64_t> sequence;  // Odd while a publish is in progress
+    SharedPayload payload;
+};
+
+SharedStatePublisher::SharedStatePublisher(const std::string& name)
+    : _name(name), _state(nullptr)
+{
+    int fd = ::shm_open(_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0666);
+    if (fd < 0 && errno == EEXIST)
+    {
+        // Only take over a segment whose owner is gone
+        SharedStateClient existing(_name);
+        if (existing.daemonPid() > 0)
+        {
+            throw std::runtime_error("perseus-armd already running as pid " +
+                                     std::to_string(existing.daemonPid()));
+        }
+        ::shm_unlink(_name.c_str());
+        fd = ::shm_open(_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0666);
+    }
+    if (fd < 0)
+    {
+        throw std::runtime_error("Failed to create shared memory " + _name + ": " + std::strerror(errno));
+    }
+    // Clients need write access for commands, whatever the daemon's umask
+    ::fchmod(fd, 0666);
+
+    void* memory = MAP_FAILED;
+    if (::ftruncate(fd, sizeof(SharedStateLayout)) == 0)
+    {
+        memory = ::mmap(nullptr, sizeof(SharedStateLayout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    const int saved_errno = errno;
+    ::close(fd);
+    if (memory == MAP_FAILED)
+    {
+        ::shm_unlink(_name.c_str());
+        throw std::runtime_error("Failed to map shared memory " + _name + ": " + std::strerror(saved_errno));
+    }
+
+    _state = new (memory) SharedStateLayout();
+    _state->version = SHARED_STATE_VERSION;
+    _state->daemon_pid.store(::getpid());
+    _state->closed.store(0);
+    _state->commands.store(0);
+    _state->sequence.store(0);
+    std::memset(&_state->payload, 0, sizeof(_state->payload));
+    _state->magic.store(SHARED_STATE_MAGIC, std::memory_order_release);
+}
+
+SharedStatePublisher::~SharedStatePublisher()
+{
+    _state->closed.store(1, std::memory_order_release);
+    ::munmap(_state, sizeof(SharedStateLayout));
+    ::shm_unlink(_name.c_str());
+}
+
+void SharedStatePublisher::publish(const std::vector<std::string>& ports,
+                                   const std::vector<std::string>& link_status,
+                                   const std::vector<const std::vector<ServoData>*>& arms,
+                                   const std::vector<uint64_t>& arm_cycles,
+                                   bool emergency_stop,
+                                   const std::vector<std::string>& status_lines,
+                                   Clock::time_point now)
+{
+    SharedPayload& payload = _state->payload;
+    const uint64_t sequence = _state->sequence.load(std::memory_order_relaxed);
+    _state->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    payload.published_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+    payload.emergency_stop = emergency_stop ? 1 : 0;
+    payload.arm_count = static_cast<uint32_t>(std::min(arms.size(), MAX_ARMS));
+    for (size_t a = 0; a < payload.arm_count; ++a)
+    {
+        SharedArm& arm = payload.arms[a];
+        copyString(arm.port, a < ports.size() ? ports[a] : std::string());
+        copyString(arm.link_status, a < link_status.size() ? link_status[a] : std::string());
+        arm.cycle = a < arm_cycles.size() ? arm_cycles[a] : 0;
+        arm.joint_count = static_cast<uint32_t>(std::min(arms[a]->size(), MAX_JOINTS));
+        for (size_t j = 0; j < arm.joint_count; ++j)
+        {
+            const ServoData& servo = (*arms[a])[j];
+            arm.joints[j].current = servo.current;
+            arm.joints[j].min = servo.min;
+            arm.joints[j].max = servo.max;
+            arm.joints[j].temperature = static_cast<int16_t>(servo.temperature);
+            arm.joints[j].sequence = servo.sequence;
+            arm.joints[j].sampled_ns =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(servo.sampled.time_since_epoch()).count();
+            copyString(arm.joints[j].error, servo.error);
+        }
+    }
+    payload.status_line_count = static_cast<uint32_t>(std::min(status_lines.size(), MAX_STATUS_LINES));
+    for (size_t i = 0; i < payload.status_line_count; ++i)
+    {
+        copyString(payload.status_lines[i], status_lines[i]);
+    }
+
+    _state->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+uint32_t SharedStatePublisher::takeCommands()
+{
+    return _state->commands.exchange(0);
+}
+
+SharedStateClient::SharedStateClient(const std::string& name)
+    : _name(name), _state(nullptr)
+{
+    _attach();
+}
+
+SharedStateClient::~SharedStateClient()
+{
+    _detach();
+}
+
+bool SharedStateClient::read(StateSnapshot& snapshot)
+{
+    // A daemon that exited or died leaves the old mapping behind; look for a new one
+    if (_state && (_state->closed.load(std::memory_order_acquire) || !processAlive(_state->daemon_pid.load())))
+    {
+        _detach();
+    }
+    if (!_state && !_attach())
+    {
+        return false;
+    }
+
+    // A publish takes microseconds; bound the retries in case the writer died mid-publish
+    SharedPayload payload;
+    uint64_t before = 0;
+    bool consistent = false;
+    for (int attempt = 0; attempt < 100000 && !consistent; ++attempt)
+    {
+        before = _state->sequence.load(std::memory_order_acquire);
+        if (before & 1)
+        {
+            continue;
+        }
+        std::memcpy(&payload, &_state->payload, sizeof(payload));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        consistent = _state->sequence.load(std::memory_order_relaxed) == before;
+    }
+    if (!consistent)
+    {
+        return false;
+    }
+
+    snapshot.sequence = before / 2;
+    snapshot.published = Clock::time_point(std::chrono::nanoseconds(payload.published_ns));
+    snapshot.emergency_stop = payload.emergency_stop != 0;
+    const size_t arm_count = std::min<size_t>(payload.arm_count, SharedStatePublisher::MAX_ARMS);
+    snapshot.ports.resize(arm_count);
+    snapshot.link_status.resize(arm_count);
+    snapshot.arms.resize(arm_count);
+    snapshot.arm_cycles.resize(arm_count);
+    for (size_t a = 0; a < arm_count; ++a)
+    {
+        const SharedArm& arm = payload.arms[a];
+        snapshot.ports[a] = readString(arm.port);
+        snapshot.link_status[a] = readString(arm.link_status);
+        snapshot.arm_cycles[a] = arm.cycle;
+        snapshot.arms[a].resize(std::min<size_t>(arm.joint_count, SharedStatePublisher::MAX_JOINTS));
+        for (size_t j = 0; j < snapshot.arms[a].size(); ++j)
+        {
+            ServoData& servo = snapshot.arms[a][j];
+            servo.current = arm.joints[j].current;
+            servo.min = arm.joints[j].min;
+            servo.max = arm.joints[j].max;
+            servo.temperature = arm.joints[j].temperature;
+            servo.sequence = arm.joints[j].sequence;
+            servo.sampled = Clock::time_point(std::chrono::nanoseconds(arm.joints[j].sampled_ns));
+            servo.error = readString(arm.joints[j].error);
+        }
+    }
+    snapshot.status_lines.clear();
+    for (size_t i = 0; i < std::min<size_t>(payload.status_line_count, SharedStatePublisher::MAX_STATUS_LINES); ++i)
+    {
+        snapshot.status_lines.push_back(readString(payload.status_lines[i]));
+    }
+    return true;
+}
+
+pid_t SharedStateClient::daemonPid() const
+{
+    if (!_state || _state->closed.load(std::memory_order_acquire))
+    {
+        return -1;
+    }
+    const pid_t pid = _state->daemon_pid.load();
+    return processAlive(pid) ? pid : -1;
+}
+
+bool SharedStateClient::requestEmergencyStop()
+{
+    const pid_t pid = daemonPid();
+    return pid > 0 && ::kill(pid, SIGUSR1) == 0;
+}
+
+bool SharedStateClient::sendCommand(uint32_t command)
+{
+    if (daemonPid() < 0)
+    {
+        return false;
+    }
+    _state->commands.fetch_or(command);
+    return true;
+}
+
+bool SharedStateClient::_attach()
+{
+    const int fd = ::shm_open(_name.c_str(), O_RDWR, 0);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat info;
+    void* memory = MAP_FAILED;
+    if (::fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(SharedStateLayout))
+    {
+        memory = ::mmap(nullptr, sizeof(SharedStateLayout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (memory == MAP_FAILED)
+    {
+        return false;
+    }
+
+    auto* state = static_cast<SharedStateLayout*>(memory);
+    if (state->magic.load(std::memory_order_acquire) != SHARED_STATE_MAGIC ||
+        state->version != SHARED_STATE_VERSION)
+    {
+        ::munmap(memory, sizeof(SharedStateLayout));
+        return false;
+    }
+    _state = state;
+    return true;
+}
+
+void SharedStateClient::_detach()
+{
+    if (_state)
+    {
+        ::munmap(_state, sizeof(SharedStateLayout));
+        _state = nullptr;
+    }
+}
@@ -0,0 +1,402 @@
+#include "teleop-ui.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+
+// Create a colored progress bar string
+void displayProgressBar(Display &display, int y, int x, uint16_t current, uint16_t min, uint16_t max)
+{
+    // Clamp values to 0-4095
+    current = std::min(current, static_cast<uint16_t>(4095));
+    min = std::min(min, static_cast<uint16_t>(4095));
+    max = std::min(max, static_cast<uint16_t>(4095));
+
+    const size_t barLength = 40;
+
+    // Calculate positions
+    size_t currentPos = static_cast<size_t>((static_cast<double>(current) / 4095.0) * barLength);
+    size_t minPos = static_cast<size_t>((static_cast<double>(min) / 4095.0) * barLength);
+    size_t maxPos = static_cast<size_t>((static_cast<double>(max) / 4095.0) * barLength);
+
+    // Print opening bracket
+    display.print(y, x, "[");
+    x++;
+
+    // Print bar with colors
+    for (size_t i = 0; i < barLength; i++)
+    {
+        const int column = x + static_cast<int>(i);
+        if (display.hasColors())
+        {
+            if (i == minPos)
+            {
+                display.print(y, column, "#", {Display::LOW, 0}); // Blue for min
+            }
+            else if (i == maxPos)
+            {
+                display.print(y, column, "#", {Display::HIGH, 0}); // Green for max
+            }
+            else if (i < currentPos)
+            {
+                if (i < minPos)
+                {
+                    display.print(y, column, "#", {Display::CURRENT, Display::DIM}); // Dimmed white for positions before min
+                }
+                else
+                {
+                    display.print(y, column, "#", {Display::CURRENT, 0}); // Bright white for current valid position
+                }
+            }
+        }
+        else
+        {
+            // For non-color displays, still show all positions but with different characters
+            if (i < currentPos)
+            {
+                display.print(y, column, (i < minPos) ? "." : "#");
+            }
+        }
+    }
+
+    // Print closing bracket
+    display.print(y, x + static_cast<int>(barLength), "]");
+}
+
+void displayHeatStrip(Display &display, int y, int x, const RangeEstimator &range, uint16_t current)
+{
+    const size_t barLength = 40;
+    static const char shades[] = " .:-=+*#";
+    const size_t levels = sizeof(shades) - 2;
+
+    // Readings per column, each column spanning a few histogram bins
+    uint32_t counts[barLength] = {};
+    uint32_t peak = 0;
+    for (size_t bin = 0; bin < RangeEstimator::BIN_COUNT; ++bin)
+    {
+        const size_t column = bin * barLength / RangeEstimator::BIN_COUNT;
+        counts[column] += range.binCount(bin);
+        peak = std::max(peak, counts[column]);
+    }
+
+    const size_t currentPos = std::min<size_t>(current, 4095) * barLength / 4096;
+    const size_t lowPos = range.low() * barLength / 4096;
+    const size_t highPos = range.high() * barLength / 4096;
+
+    display.print(y, x, "[");
+    for (size_t i = 0; i < barLength; i++)
+    {
+        // Log scale, so rarely visited ends still show against the dwell spots
+        size_t level = 0;
+        if (counts[i] > 0)
+        {
+            level = 1 + static_cast<size_t>((levels - 1) * std::log1p(counts[i]) / std::log1p(peak));
+        }
+        const char shade = shades[std::min(level, levels)];
+
+        Display::Style style{Display::CURRENT, 0};
+        if (range.samples() > 0 && i == lowPos)
+        {
+            style.color = Display::LOW; // Blue for the robust min
+        }
+        else if (range.samples() > 0 && i == highPos)
+        {
+            style.color = Display::HIGH; // Green for the robust max
+        }
+        if (i == currentPos)
+        {
+            style.attributes |= Display::REVERSE;
+        }
+        display.print(y, x + 1 + static_cast<int>(i), std::string(1, shade), style);
+    }
+    display.print(y, x + 1 + static_cast<int>(barLength), "]");
+}
+
+void displaySparkline(Display &display, int y, int x, const JointHistory &history, Clock::time_point now)
+{
+    static const char levels[] = "_.-~^";
+    const int top = sizeof(levels) - 2;
+    const int min_span = 64;   // Ticks; keeps sensor noise on a still joint flat
+
+    const size_t columns = history.columns();
+    std::vector<JointHistory::Envelope> envelopes(columns);
+    int low = 4095;
+    int high = 0;
+    for (size_t i = 0; i < columns; ++i)
+    {
+        envelopes[i] = history.envelope(columns - 1 - i, now);
+        if (envelopes[i].set)
+        {
+            low = std::min<int>(low, envelopes[i].low);
+            high = std::max<int>(high, envelopes[i].high);
+        }
+    }
+    if (high < low)
+    {
+        return;
+    }
+    if (high - low < min_span)
+    {
+        const int middle = (low + high) / 2;
+        low = middle - min_span / 2;
+        high = low + min_span;
+    }
+
+    for (size_t i = 0; i < columns; ++i)
+    {
+        const JointHistory::Envelope &envelope = envelopes[i];
+        if (!envelope.set)
+        {
+            continue;
+        }
+        // Judged on the envelope's height, so noise straddling a level boundary stays flat
+        const int height = (envelope.high - envelope.low) * top / (high - low);
+        const int level = ((envelope.low + envelope.high) / 2 - low) * top / (high - low);
+        const int column = x + static_cast<int>(i);
+        if (height == 0)
+        {
+            display.print(y, column, std::string(1, levels[level]), {Display::CURRENT, 0});
+        }
+        else
+        {
+            // Moved through a level or more within one bucket
+            const bool wide = height >= top - 1;
+            display.print(y, column, "|", {Display::CURRENT, wide ? Display::REVERSE : uint8_t(0)});
+        }
+    }
+}
+
+std::string getWorkingDirectory()
+{
+    return std::filesystem::current_path().string();
+}
+
+namespace
+{
+
+// printf-style formatting for Display::print()
+std::string format(const char *pattern, ...)
+{
+    char buffer[256];
+    va_list args;
+    va_start(args, pattern);
+    std::vsnprintf(buffer, sizeof(buffer), pattern, args);
+    va_end(args);
+    return buffer;
+}
+
+// Show how old a joint's reading is, right of its progress bar
+void displaySampleAge(Display &display, int row, const ServoData &servo, Clock::time_point now)
+{
+    if (now == Clock::time_point() || servo.sequence == 0)
+    {
+        return;
+    }
+    const auto age = std::chrono::duration_cast<std::chrono::milliseconds>(now - servo.sampled).count();
+    display.print(row, 85, format("%6lld ms", static_cast<long long>(age)));
+}
+
+}
+
+// Display servo values for both arms
+void displayServoValues(Display &display,
+    const std::vector<ServoData> &arm1_data,
+    const std::vector<ServoData> &arm2_data,
+    const std::string &arm1_status,
+    const std::string &arm2_status,
+    const std::vector<std::string> &extra_lines,
+    Clock::time_point now,
+    const std::vector<const std::vector<RangeEstimator> *> &ranges,
+    const std::vector<const std::vector<JointHistory> *> &histories)
+{
+    display.beginFrame();
+
+    // Display header
+    display.print(0, 0, "Perseus Arms Servo Positions (0-4095)");
+    display.print(1, 0, "--------------------------------------------------------");
+
+    // Column headers
+    display.print(2, 2, "Servo    Current    Min      Max      Range");
+    if (now != Clock::time_point())
+    {
+        display.print(2, 89, "Age");
+    }
+    if (!histories.empty())
+    {
+        display.print(2, 96, "History");
+    }
+    display.print(3, 0, "--------------------------------------------------------");
+
+    // Display first arm's servos
+    display.print(4, 0, "Arm 1: " + arm1_status);
+    for (size_t i = 0; i < 6; ++i)
+    {
+        int row = i + 5;
+        const auto &servo = arm1_data[i];
+
+        if (servo.error.empty())
+        {
+            display.print(row, 2, format("%-8d %8u  %8u  %8u  ",
+                static_cast<int>(i + 1),
+                servo.current,
+                servo.min,
+                servo.max));
+            if (ranges.size() > 0 && ranges[0] && i < ranges[0]->size())
+            {
+                displayHeatStrip(display, row, 42, (*ranges[0])[i], servo.current);
+            }
+            else
+            {
+                displayProgressBar(display, row, 42, servo.current, servo.min, servo.max);
+            }
+            displaySampleAge(display, row, servo, now);
+            if (histories.size() > 0 && histories[0] && i < histories[0]->size())
+            {
+                displaySparkline(display, row, 96, (*histories[0])[i], now);
+            }
+        }
+        else
+        {
+            display.print(row, 2, format("%d: Error: %s",
+                static_cast<int>(i + 1),
+                servo.error.c_str()));
+        }
+    }
+
+    display.print(11, 0, "--------------------------------------------------------");
+
+    // Display second arm's servos
+    display.print(12, 0, "Arm 2: " + arm2_status);
+    for (size_t i = 0; i < 6; ++i)
+    {
+        int row = i + 13;
+        const auto &servo = arm2_data[i];
+
+        if (servo.error.empty())
+        {
+            display.print(row, 2, format("%-8d %8u  %8u  %8u  ",
+                static_cast<int>(i + 1),
+                servo.current,
+                servo.min,
+                servo.max));
+            if (ranges.size() > 1 && ranges[1] && i < ranges[1]->size())
+            {
+                displayHeatStrip(display, row, 42, (*ranges[1])[i], servo.current);
+            }
+            else
+            {
+                displayProgressBar(display, row, 42, servo.current, servo.min, servo.max);
+            }
+            displaySampleAge(display, row, servo, now);
+            if (histories.size() > 1 && histories[1] && i < histories[1]->size())
+            {
+                displaySparkline(display, row, 96, (*histories[1])[i], now);
+            }
+        }
+        else
+        {
+            display.print(row, 2, format("%-8d Error: %s",
+                static_cast<int>(i + 1),
+                servo.error.c_str()));
+        }
+    }
+
+    display.print(19, 0, "--------------------------------------------------------");
+
+    // Add instructions and working directory
+    display.print(20, 0, "Instructions:");
+    display.print(21, 0, "1. Move both arms through their full range of motion");
+    display.print(22, 0, "2. Press 's' to save calibration when done");
+    display.print(23, 0, "3. Press Ctrl+C to exit, Space for emergency stop ('r' re-arms)");
+    display.print(24, 0, "Save directory: " + getWorkingDirectory());
+
+    // Row 25 is reserved for save status messages
+    for (size_t i = 0; i < extra_lines.size(); ++i)
+    {
+        display.print(26 + static_cast<int>(i), 0, extra_lines[i]);
+    }
+
+    display.present();
+}
+
+size_t fleetPageSize(const Display &display, size_t extra_lines)
+{
+    // Title, rule and column headers above; rule, key help and status lines below
+    const int rows = display.rows() - 3 - 2 - static_cast<int>(extra_lines);
+    return static_cast<size_t>(std::max(1, rows));
+}
+
+void displayFleetSummary(Display &display, const FleetMonitor &fleet, size_t selected, size_t &first,
+                         const std::vector<std::string> &extra_lines)
+{
+    const size_t page = fleetPageSize(display, extra_lines.size());
+    if (selected < first)
+    {
+        first = selected;
+    }
+    else if (selected >= first + page)
+    {
+        first = selected + 1 - page;
+    }
+
+    display.beginFrame();
+    const FleetMonitor::Totals totals = fleet.totals();
+    display.print(0, 0, format("Perseus fleet: %zu arms on %zu workers | connected %zu | %.0f Hz total | "
+                               "errors %.1f%% | failing %zu | worst latency %.1f ms | hottest %s",
+                               totals.arms, fleet.workers(), totals.connected, totals.rate_hz, totals.error_percent,
+                               totals.failing, totals.worst_latency_ms,
+                               totals.hottest < 0 ? "--" : (std::to_string(totals.hottest) + " C").c_str()));
+    display.print(1, 0, "--------------------------------------------------------");
+    display.print(2, 0, format("  %4s  %-28s  %7s  %8s  %10s  %6s  %s", "Arm", "Port", "Rate Hz", "Errors %",
+                               "Latency ms", "Temp C", "Link"));
+
+    const size_t last = std::min(fleet.arms(), first + page);
+    for (size_t arm = first; arm < last; ++arm)
+    {
+        const FleetMonitor::ArmSummary summary = fleet.summary(arm);
+        const int row = 3 + static_cast<int>(arm - first);
+        Display::Style style{Display::DEFAULT, arm == selected ? Display::REVERSE : uint8_t(0)};
+        if (!summary.connected || summary.error_percent >= 1.0)
+        {
+            style.color = Display::LOW;
+        }
+        const std::string port =
+            summary.port.size() > 28 ? "..." + summary.port.substr(summary.port.size() - 25) : summary.port;
+        display.print(row, 0, format("%c %4zu  %-28s  %7.1f  %8.1f  %10.2f  %6s  %s", arm == selected ? '>' : ' ',
+                                     arm + 1, port.c_str(), summary.rate_hz, summary.error_percent,
+                                     summary.latency_ms,
+                                     summary.temperature < 0 ? "--" : std::to_string(summary.temperature).c_str(),
+                                     summary.link.c_str()),
+                      style);
+    }
+
+    const int footer = 3 + static_cast<int>(page);
+    display.print(footer, 0, "--------------------------------------------------------");
+    display.print(footer + 1, 0, format("Arms %zu-%zu of %zu | j/k or arrows move, PgUp/PgDn page, Enter shows the "
+                                        "arm's pair, Space emergency stop ('r' re-arms), Ctrl+C exits",
+                                        fleet.arms() == 0 ? 0 : first + 1, last, fleet.arms()));
+    for (size_t i = 0; i < extra_lines.size(); ++i)
+    {
+        display.print(footer + 2 + static_cast<int>(i), 0, extra_lines[i]);
+    }
+    display.present();
+}
+
+std::string formatDisplayLine(const Display &display)
+{
+    std::ostringstream line;
+    line << "Display: " << display.name();
+    if (display.countsBytes())
+    {
+        line << ", " << display.lastFrameBytes() << " bytes last frame, " << std::fixed << std::setprecision(0)
+             << display.averageFrameBytes() << " average";
+    }
+    else
+    {
+        line << ", frame bytes not measured on a terminal";
+    }
+    return line.str();
+}
@@ -0,0 +1,433 @@
+#include "terminal-display.hpp"
+#include <ncurses.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace
+{
+
+// Used when the output is not a terminal that can report its size
+const int DEFAULT_ROWS = 40;
+const int DEFAULT_COLS = 120;
+
+// A gap this short is cheaper to rewrite than to jump over with a cursor move
+const int MAX_REWRITE_GAP = 4;
+
+int cursesKey(int ch)
+{
+    switch (ch)
+    {
+    case ERR:
+        return Display::NO_KEY;
+    case KEY_UP:
+        return Display::ARROW_UP;
+    case KEY_DOWN:
+        return Display::ARROW_DOWN;
+    case KEY_PPAGE:
+        return Display::PAGE_UP;
+    case KEY_NPAGE:
+        return Display::PAGE_DOWN;
+    default:
+        return ch;
+    }
+}
+
+}
+
+size_t Display::lastFrameBytes() const
+{
+    return _last_frame_bytes;
+}
+
+double Display::averageFrameBytes() const
+{
+    return _average_frame_bytes;
+}
+
+uint64_t Display::frames() const
+{
+    return _frames;
+}
+
+void Display::_countFrame(size_t bytes)
+{
+    _last_frame_bytes = bytes;
+    const double value = static_cast<double>(bytes);
+    _average_frame_bytes = _frames == 0 ? value : _average_frame_bytes + (value - _average_frame_bytes) / 16.0;
+    ++_frames;
+}
+
+CursesDisplay::CursesDisplay() : CursesDisplay(nullptr, stdout, stdin)
+{
+}
+
+CursesDisplay::CursesDisplay(const char *terminal, FILE *out, FILE *in)
+    : _out(out), _screen(nullptr), _window(nullptr), _presented(-1)
+{
+    // curses writes straight to the descriptor, so the stream can't see its
+    // output; a file's offset can, while a terminal's bytes go uncounted
+    _presented = ::lseek(fileno(_out), 0, SEEK_CUR);
+
+    _screen = newterm(terminal, _out, in);
+    if (!_screen)
+    {
+        throw std::runtime_error(std::string("Unknown terminal type ") + (terminal ? terminal : "in TERM"));
+    }
+    set_term(_screen);
+    _window = stdscr;
+    cbreak();
+    noecho();
+    curs_set(0);
+    nodelay(_window, TRUE);
+    keypad(_window, TRUE);
+
+    // Initialize colors if terminal supports them
+    if (has_colors())
+    {
+        start_color();
+        init_pair(LOW, COLOR_BLUE, COLOR_BLACK);
+        init_pair(HIGH, COLOR_GREEN, COLOR_BLACK);
+        init_pair(CURRENT, COLOR_WHITE, COLOR_BLACK);
+    }
+    if (_presented >= 0)
+    {
+        _presented = ::lseek(fileno(_out), 0, SEEK_CUR);
+    }
+}
+
+CursesDisplay::~CursesDisplay()
+{
+    endwin();
+    delscreen(_screen);
+}
+
+void CursesDisplay::beginFrame()
+{
+    werase(_window);
+}
+
+void CursesDisplay::print(int y, int x, const std::string &text, Style style)
+{
+    attr_t attributes = A_NORMAL;
+    if (style.color != DEFAULT && has_colors())
+    {
+        attributes |= COLOR_PAIR(style.color);
+    }
+    if (style.attributes & DIM)
+    {
+        attributes |= A_DIM;
+    }
+    if (style.attributes & REVERSE)
+    {
+        attributes |= A_REVERSE;
+    }
+    wattron(_window, attributes);
+    mvwaddnstr(_window, y, x, text.c_str(), static_cast<int>(text.size()));
+    wattroff(_window, attributes);
+}
+
+void CursesDisplay::present()
+{
+    wrefresh(_window);
+    if (_presented >= 0)
+    {
+        const off_t offset = ::lseek(fileno(_out), 0, SEEK_CUR);
+        _countFrame(static_cast<size_t>(offset - _presented));
+        _presented = offset;
+    }
+}
+
+int CursesDisplay::readKey()
+{
+    return cursesKey(wgetch(_window));
+}
+
+int CursesDisplay::waitKey()
+{
+    nodelay(_window, FALSE);
+    const int ch = wgetch(_window);
+    nodelay(_window, TRUE);
+    return cursesKey(ch);
+}
+
+int CursesDisplay::rows() const
+{
+    return getmaxy(_window);
+}
+
+bool CursesDisplay::hasColors() const
+{
+    return has_colors();
+}
+
+bool CursesDisplay::countsBytes() const
+{
+    return _presented >= 0;
+}
+
+const char *CursesDisplay::name() const
+{
+    return "curses";
+}
+
+AnsiDisplay::AnsiDisplay(int out_fd, int in_fd)
+    : _out_fd(out_fd), _in_fd(in_fd), _restore_termios(false), _saved_termios(), _rows(0), _cols(0),
+      _repaint(true)
+{
+    // Keys arrive unbuffered and unechoed; signals still work, as with cbreak()
+    if (isatty(_in_fd) && tcgetattr(_in_fd, &_saved_termios) == 0)
+    {
+        struct termios raw = _saved_termios;
+        raw.c_lflag &= ~(ICANON | ECHO);
+        raw.c_cc[VMIN] = 0;
+        raw.c_cc[VTIME] = 0;
+        _restore_termios = tcsetattr(_in_fd, TCSANOW, &raw) == 0;
+    }
+
+    // Alternate screen, hidden cursor
+    _writeAll("\x1b[?1049h\x1b[?25l");
+    _output.reserve(1 << 14);
+    _resize();
+}
+
+AnsiDisplay::~AnsiDisplay()
+{
+    _writeAll("\x1b[0m\x1b[?25h\x1b[?1049l");
+    if (_restore_termios)
+    {
+        tcsetattr(_in_fd, TCSANOW, &_saved_termios);
+    }
+}
+
+void AnsiDisplay::_resize()
+{
+    int rows = DEFAULT_ROWS;
+    int cols = DEFAULT_COLS;
+    struct winsize size;
+    if (ioctl(_out_fd, TIOCGWINSZ, &size) == 0 && size.ws_row > 0 && size.ws_col > 0)
+    {
+        rows = size.ws_row;
+        cols = size.ws_col;
+    }
+    if (rows != _rows || cols != _cols)
+    {
+        _rows = rows;
+        _cols = cols;
+        _frame.assign(static_cast<size_t>(_rows) * _cols, Cell());
+        _shown.assign(_frame.size(), Cell());
+        _repaint = true;
+    }
+}
+
+void AnsiDisplay::beginFrame()
+{
+    _resize();
+    std::fill(_frame.begin(), _frame.end(), Cell());
+}
+
+void AnsiDisplay::print(int y, int x, const std::string &text, Style style)
+{
+    if (y < 0 || y >= _rows)
+    {
+        return;
+    }
+    Cell *row = &_frame[static_cast<size_t>(y) * _cols];
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        const int column = x + static_cast<int>(i);
+        if (column >= _cols)
+        {
+            break;
+        }
+        if (column >= 0)
+        {
+            row[column] = {text[i], style.color, style.attributes};
+        }
+    }
+}
+
+void AnsiDisplay::_appendStyle(const Cell &cell)
+{
+    if (cell.color == _pen.color && cell.attributes == _pen.attributes)
+    {
+        return;
+    }
+    _output += "\x1b[0";
+    if (cell.attributes & DIM)
+    {
+        _output += ";2";
+    }
+    if (cell.attributes & REVERSE)
+    {
+        _output += ";7";
+    }
+    switch (cell.color)
+    {
+    case LOW:
+        _output += ";34;40";
+        break;
+    case HIGH:
+        _output += ";32;40";
+        break;
+    case CURRENT:
+        _output += ";37;40";
+        break;
+    default:
+        break;
+    }
+    _output += 'm';
+    _pen.color = cell.color;
+    _pen.attributes = cell.attributes;
+}
+
+void AnsiDisplay::present()
+{
+    _output.clear();
+    if (_repaint)
+    {
+        // A cleared screen is all default blanks, so only the rest needs drawing
+        _output += "\x1b[0m\x1b[2J";
+        _pen = Cell();
+        std::fill(_shown.begin(), _shown.end(), Cell());
+        _repaint = false;
+    }
+
+    int cursor_y = -1;
+    int cursor_x = -1;
+    for (int y = 0; y < _rows; ++y)
+    {
+        const size_t base = static_cast<size_t>(y) * _cols;
+        for (int x = 0; x < _cols; ++x)
+        {
+            const Cell &cell = _frame[base + x];
+            if (cell == _shown[base + x])
+            {
+                continue;
+            }
+            if (cursor_y == y && x > cursor_x && x - cursor_x <= MAX_REWRITE_GAP)
+            {
+                // Cheaper to repeat the few unchanged cells than to move past them
+                for (int gap = cursor_x; gap < x; ++gap)
+                {
+                    _appendStyle(_frame[base + gap]);
+                    _output += _frame[base + gap].ch;
+                }
+            }
+            else if (cursor_y != y || cursor_x != x)
+            {
+                _output += "\x1b[" + std::to_string(y + 1) + ";" + std::to_string(x + 1) + "H";
+            }
+            _appendStyle(cell);
+            _output += cell.ch;
+            cursor_y = y;
+            cursor_x = x + 1;
+            if (cursor_x >= _cols)
+            {
+                cursor_y = -1;  // Terminals differ on where the cursor sits after the last column
+            }
+        }
+    }
+    _shown = _frame;
+
+    if (!_output.empty())
+    {
+        _writeAll(_output);
+    }
+    _countFrame(_output.size());
+}
+
+void AnsiDisplay::_writeAll(const std::string &bytes)
+{
+    size_t written = 0;
+    while (written < bytes.size())
+    {
+        const ssize_t n = ::write(_out_fd, bytes.data() + written, bytes.size() - written);
+        if (n > 0)
+        {
+            written += static_cast<size_t>(n);
+        }
+        else if (n < 0 && errno == EAGAIN)
+        {
+            struct pollfd pfd = {_out_fd, POLLOUT, 0};
+            ::poll(&pfd, 1, 100);
+        }
+        else if (!(n < 0 && errno == EINTR))
+        {
+            return;  // Terminal gone; nothing useful left to do with the frame
+        }
+    }
+}
+
+int AnsiDisplay::readKey()
+{
+    unsigned char ch;
+    if (::read(_in_fd, &ch, 1) != 1)
+    {
+        return NO_KEY;
+    }
+    if (ch != 0x1b)
+    {
+        return ch;
+    }
+
+    // The rest of an escape sequence arrives with its first byte; a lone Escape has nothing after it
+    char sequence[4] = {};
+    const ssize_t n = ::read(_in_fd, sequence, sizeof(sequence) - 1);
+    const std::string rest(sequence, n > 0 ? static_cast<size_t>(n) : 0);
+    if (rest == "[A" || rest == "OA")
+    {
+        return ARROW_UP;
+    }
+    if (rest == "[B" || rest == "OB")
+    {
+        return ARROW_DOWN;
+    }
+    if (rest == "[5~")
+    {
+        return PAGE_UP;
+    }
+    if (rest == "[6~")
+    {
+        return PAGE_DOWN;
+    }
+    return ch;
+}
+
+int AnsiDisplay::waitKey()
+{
+    struct pollfd pfd = {_in_fd, POLLIN, 0};
+    if (::poll(&pfd, 1, -1) <= 0)
+    {
+        return NO_KEY;  // Interrupted, e.g. by Ctrl+C
+    }
+    return readKey();
+}
+
+int AnsiDisplay::rows() const
+{
+    return _rows;
+}
+
+bool AnsiDisplay::hasColors() const
+{
+    return true;
+}
+
+const char *AnsiDisplay::name() const
+{
+    return "ansi";
+}
+
+std::unique_ptr<Display> makeDisplay(bool ansi)
+{
+    if (ansi)
+    {
+        return std::make_unique<AnsiDisplay>();
+    }
+    return std::make_unique<CursesDisplay>();
+}
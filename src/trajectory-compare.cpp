@@ -0,0 +1,240 @@
+#include "trajectory-compare.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+
+// Four floats: one SSE or NEON register, so no target flags are needed
+typedef float Lanes __attribute__((vector_size(16)));
+const size_t LANE_COUNT = sizeof(Lanes) / sizeof(float);
+
+const float INF = std::numeric_limits<float>::infinity();
+
+enum Step : uint8_t
+{
+    DIAGONAL,  // From (i - 1, j - 1)
+    UP,        // From (i - 1, j)
+    LEFT       // From (i, j - 1)
+};
+
+Lanes load(const float* p)
+{
+    Lanes v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+void store(float* p, Lanes v)
+{
+    std::memcpy(p, &v, sizeof(v));
+}
+
+Lanes absolute(Lanes v)
+{
+    return v < 0 ? -v : v;
+}
+
+size_t roundUp(size_t value, size_t multiple)
+{
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+}
+
+std::vector<JointTrack> extractJointTracks(const RecordingFile& file, size_t arm)
+{
+    std::vector<JointTrack> tracks;
+    const ArmRecord* records = file.records();
+    for (size_t r = 0; r < file.size(); ++r)
+    {
+        const ArmRecord& record = records[r];
+        if (record.arm != arm)
+        {
+            continue;
+        }
+        const size_t joints = std::min<size_t>(record.joint_count, ArmRecord::MAX_JOINTS);
+        if (tracks.size() < joints)
+        {
+            tracks.resize(joints);
+        }
+        for (size_t j = 0; j < joints; ++j)
+        {
+            if (record.positions[j] != ArmRecord::INVALID_POSITION)
+            {
+                tracks[j].time_ns.push_back(record.time_ns + int64_t{record.joint_offset_us[j]} * 1000);
+                tracks[j].position.push_back(record.positions[j]);
+            }
+        }
+    }
+    return tracks;
+}
+
+int64_t typicalRecordPeriod(const RecordingFile& file, size_t arm)
+{
+    std::vector<int64_t> intervals;
+    int64_t last = 0;
+    bool first = true;
+    for (size_t r = 0; r < file.size(); ++r)
+    {
+        const ArmRecord& record = file.records()[r];
+        if (record.arm != arm)
+        {
+            continue;
+        }
+        if (!first && record.time_ns > last)
+        {
+            intervals.push_back(record.time_ns - last);
+        }
+        last = record.time_ns;
+        first = false;
+    }
+    if (intervals.empty())
+    {
+        return 0;
+    }
+    std::nth_element(intervals.begin(), intervals.begin() + intervals.size() / 2, intervals.end());
+    return intervals[intervals.size() / 2];
+}
+
+bool resampleTrack(const JointTrack& track, int64_t start_ns, int64_t period_ns, size_t count, float* out)
+{
+    const size_t size = track.time_ns.size();
+    if (size == 0)
+    {
+        return false;
+    }
+    size_t after = 0;  // First reading at or after the grid point
+    for (size_t g = 0; g < count; ++g)
+    {
+        const int64_t t = start_ns + static_cast<int64_t>(g) * period_ns;
+        while (after < size && track.time_ns[after] < t)
+        {
+            ++after;
+        }
+        if (after == 0)
+        {
+            out[g] = track.position.front();
+        }
+        else if (after == size)
+        {
+            out[g] = track.position.back();
+        }
+        else
+        {
+            const int64_t t0 = track.time_ns[after - 1];
+            const int64_t t1 = track.time_ns[after];
+            const float fraction = t1 > t0 ? static_cast<float>(t - t0) / static_cast<float>(t1 - t0) : 1.0f;
+            out[g] = track.position[after - 1] + fraction * (track.position[after] - track.position[after - 1]);
+        }
+    }
+    return true;
+}
+
+DtwResult bandedDtw(const float* a, const float* b, size_t n, size_t band, ScratchArena& scratch)
+{
+    DtwResult result;
+    if (n == 0)
+    {
+        return result;
+    }
+    band = std::min(band, n - 1);
+
+    // Rows are stored by offset k = j - i + band, so row i covers columns
+    // i - band .. i + band and cell (i - 1, j) sits at k + 1 of the row above.
+    // Padding to whole vectors plus one lane lets every load stay in bounds.
+    const size_t width = 2 * band + 1;
+    const size_t padded = roundUp(width, LANE_COUNT) + LANE_COUNT;
+    float* previous = scratch.allocateArray<float>(padded);
+    float* current = scratch.allocateArray<float>(padded);
+    float* cost = scratch.allocateArray<float>(padded);
+    float* partial = scratch.allocateArray<float>(padded);
+    uint8_t* steps = scratch.allocateArray<uint8_t>(n * width);
+
+    // b with band infinite samples either side, so out-of-matrix cells cost infinity
+    float* b_padded = scratch.allocateArray<float>(n + 2 * band + padded);
+    std::fill(b_padded, b_padded + n + 2 * band + padded, INF);
+    std::copy(b, b + n, b_padded + band);
+
+    // A virtual cell before (0, 0) starts the path on the diagonal
+    std::fill(previous, previous + padded, INF);
+    std::fill(current, current + padded, INF);
+    previous[band] = 0.0f;
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        // Everything that depends only on row i - 1, a vector at a time
+        const Lanes row_a = Lanes{} + a[i];
+        for (size_t k = 0; k < width; k += LANE_COUNT)
+        {
+            const Lanes c = absolute(row_a - load(b_padded + i + k));
+            const Lanes diagonal = load(previous + k);
+            const Lanes up = load(previous + k + 1);
+            store(cost + k, c);
+            store(partial + k, c + (up < diagonal ? up : diagonal));
+        }
+
+        // The dependency along the row is inherently sequential
+        uint8_t* row_steps = steps + i * width;
+        float left = INF;
+        for (size_t k = 0; k < width; ++k)
+        {
+            const float from_left = cost[k] + left;
+            if (from_left < partial[k])
+            {
+                current[k] = from_left;
+                row_steps[k] = LEFT;
+            }
+            else
+            {
+                current[k] = partial[k];
+                row_steps[k] = previous[k + 1] < previous[k] ? UP : DIAGONAL;
+            }
+            left = current[k];
+        }
+        std::swap(previous, current);
+    }
+
+    // Walk back from (n - 1, n - 1) to (0, 0)
+    const float total = previous[band];
+    size_t i = n - 1;
+    size_t k = band;
+    double lag = 0.0;
+    size_t length = 0;
+    while (true)
+    {
+        lag += static_cast<double>(k) - static_cast<double>(band);
+        ++length;
+        if (i == 0 && k == band)
+        {
+            break;
+        }
+        switch (steps[i * width + k])
+        {
+        case DIAGONAL:
+            --i;
+            break;
+        case UP:
+            --i;
+            ++k;
+            break;
+        case LEFT:
+            --k;
+            break;
+        }
+    }
+
+    double direct = 0.0;
+    for (size_t s = 0; s < n; ++s)
+    {
+        direct += std::fabs(a[s] - b[s]);
+    }
+
+    result.cost = total / length;
+    result.direct_cost = direct / n;
+    result.mean_lag = lag / length;
+    result.path_length = length;
+    return result;
+}
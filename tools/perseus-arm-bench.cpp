@@ -0,0 +1,920 @@
+#include "acquisition.hpp"
+#include "arm-link.hpp"
+#include "clock.hpp"
+#include "emergency-stop.hpp"
+#include "idle-detector.hpp"
+#include "joint-stream.hpp"
+#include "perseus-arm-teleop.hpp"
+#include "perf-counters.hpp"
+#include "recorder.hpp"
+#include "servo-bus.hpp"
+#include "servo-simulator.hpp"
+#include "teleop-ui.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Latency and counter statistics for one measured region
+struct RegionResult
+{
+    std::string name;
+    size_t ops = 0;
+    std::vector<double> latencies_us;
+    PerfCounters::Sample counters;
+};
+
+struct BenchOptions
+{
+    bool perf = false;
+    size_t iterations = 200;
+    double soak_seconds = 0.0;
+    size_t reconnects = 0;
+    size_t estops = 0;
+    size_t bus_cycles = 0;
+    size_t stream_frames = 0;
+    size_t records = 0;
+    double idle_seconds = 0.0;
+};
+
+void printUsage(const char *argv0)
+{
+    std::cout << "Usage: " << argv0 << " [--perf] [--iterations N]\n"
+              << "  --perf          Read cycles, instructions, cache misses and context\n"
+              << "                  switches around each measured region\n"
+              << "  --iterations N  Measured repetitions per region (default 200)\n"
+              << "  --soak SECONDS  Instead of the regions, run a two arm simulated session\n"
+              << "                  for SECONDS of virtual time and report the speedup\n"
+              << "  --reconnect N   Instead of the regions, unplug and replug a simulated arm\n"
+              << "                  N times and report hot-plug recovery time\n"
+              << "  --estop N       Instead of the regions, trigger the emergency stop N times\n"
+              << "                  during reads on two simulated arms and report latency,\n"
+              << "                  then check that a re-armed arm holds still and tracks again\n"
+              << "  --bus N         Instead of the regions, run three clients sharing one\n"
+              << "                  simulated bus for N cycles and report coalescing\n"
+              << "  --stream N      Instead of the regions, stream N joint-state frames over\n"
+              << "                  localhost UDP into a simulated follower, restarting the\n"
+              << "                  leader halfway, and report latency and loss\n"
+              << "  --record N      Instead of the regions, record N cycles per policy into a\n"
+              << "                  FIFO whose reader stalls periodically and report what\n"
+              << "                  each policy costs the sampling loop\n"
+              << "  --idle SECONDS  Instead of the regions, run the daemon's 5 ms acquisition\n"
+              << "                  loop on two simulated arms, SECONDS moving and SECONDS\n"
+              << "                  still, and report CPU and bus use in each state and how\n"
+              << "                  long motion takes to restore the full rate\n";
+}
+
+// Summarises a latency sample set as min / p50 / p99 / max
+void printLatency(const char *name, std::vector<double> values)
+{
+    if (values.empty())
+    {
+        std::printf("%-22s n/a\n", name);
+        return;
+    }
+    std::sort(values.begin(), values.end());
+    std::printf("%-22s min %9.1f p50 %9.1f p99 %9.1f max %9.1f us\n", name, values.front(),
+                values[values.size() / 2], values[std::min(values.size() - 1, values.size() * 99 / 100)],
+                values.back());
+}
+
+// Stops an arm that is following goals, re-arms it the way the follower does
+// and checks that it holds still, then tracks new goals again
+bool checkRearm()
+{
+    auto &estop = EmergencyStop::instance();
+    ST3215Simulator sim;
+    ArmLink link(sim.portName(), 1000000, Clock::system(), nullptr);
+    ServoBus bus(link);
+    const size_t joints = 6;
+
+    auto writeGoals = [&](uint16_t base) {
+        PendingReplies writes;
+        for (size_t j = 0; j < joints; ++j)
+        {
+            const uint16_t goal = static_cast<uint16_t>(base + 100 * j);
+            const uint8_t data[2] = {static_cast<uint8_t>(goal & 0xFF), static_cast<uint8_t>(goal >> 8)};
+            writes.push_back(bus.write(static_cast<uint8_t>(j + 1), 0x2A, data, 2));
+        }
+        for (auto &write : writes)
+        {
+            write.get();
+        }
+    };
+    auto tracking = [&](uint16_t base) {
+        PendingReplies positions = requestJoints(bus, joints, 0x38, 2);
+        bool all = true;
+        for (size_t j = 0; j < joints; ++j)
+        {
+            const auto reply = positions[j].get();
+            all = all && reply.error.empty() && reply.data.size() == 2 &&
+                  (reply.data[0] | (reply.data[1] << 8)) == base + 100 * j;
+        }
+        return all;
+    };
+
+    estop.reset();
+    writeGoals(1000);
+    const bool before = tracking(1000);
+    const auto disabled_before = sim.lastTorqueDisableTime();
+    estop.trigger();
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (sim.lastTorqueDisableTime() == disabled_before && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    bool limp = true;
+    for (uint8_t id = 1; id <= joints; ++id)
+    {
+        limp = limp && !sim.torqueEnabled(id);
+    }
+
+    // A goal that arrived while limp must not be where the arm jumps to
+    estop.reset();
+    writeGoals(3000);
+    const size_t enabled = enableTorque(bus, joints);
+    bool torque = true;
+    for (uint8_t id = 1; id <= joints; ++id)
+    {
+        torque = torque && sim.torqueEnabled(id);
+    }
+    const bool held = tracking(1000);
+    writeGoals(2000);
+    const bool after = tracking(2000);
+
+    const bool ok = before && limp && enabled == joints && torque && held && after;
+    std::printf("re-arm torque on %zu/%zu, held %s, tracking %s: %s\n", enabled, joints, held ? "yes" : "no",
+                after ? "yes" : "no", ok ? "ok" : "FAILED");
+    return ok;
+}
+
+// Triggers the emergency stop while both arms are mid-transaction
+int runEmergencyStop(size_t count)
+{
+    auto &estop = EmergencyStop::instance();
+    ST3215Simulator sim1;
+    ST3215Simulator sim2;
+    ST3215ServoReader reader1(sim1.portName(), 1000000);
+    ST3215ServoReader reader2(sim2.portName(), 1000000);
+
+    std::vector<double> trigger_us, bus_us, cancel_us;
+    for (size_t i = 0; i < count; ++i)
+    {
+        estop.reset();
+        const auto disabled_before1 = sim1.lastTorqueDisableTime();
+        const auto disabled_before2 = sim2.lastTorqueDisableTime();
+
+        // Keep both buses busy so the stop always lands on an in-flight read
+        std::atomic<int64_t> cancelled_at[2] = {{0}, {0}};
+        auto reader_loop = [&](ST3215ServoReader &reader, std::atomic<int64_t> &cancelled) {
+            try
+            {
+                while (true)
+                {
+                    reader.readPosition(1 + static_cast<uint8_t>(i % 6));
+                }
+            }
+            catch (const EmergencyStopError &)
+            {
+                cancelled = std::chrono::steady_clock::now().time_since_epoch().count();
+            }
+        };
+        std::thread t1(reader_loop, std::ref(reader1), std::ref(cancelled_at[0]));
+        std::thread t2(reader_loop, std::ref(reader2), std::ref(cancelled_at[1]));
+
+        // Vary the phase relative to the 5 ms / 10 ms transaction delays
+        std::this_thread::sleep_for(std::chrono::microseconds(2000 + 1700 * (i % 13)));
+        const auto start = std::chrono::steady_clock::now();
+        estop.trigger();
+        const auto triggered = std::chrono::steady_clock::now();
+        t1.join();
+        t2.join();
+
+        // Give the simulators a moment to process the broadcast
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while ((sim1.lastTorqueDisableTime() == disabled_before1 ||
+                sim2.lastTorqueDisableTime() == disabled_before2) &&
+               std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        const auto trigger_time = estop.lastTriggerTime();
+        trigger_us.push_back(std::chrono::duration<double, std::micro>(triggered - start).count());
+        for (const auto *sim : {&sim1, &sim2})
+        {
+            bus_us.push_back(std::chrono::duration<double, std::micro>(
+                                 sim->lastTorqueDisableTime() - trigger_time).count());
+        }
+        for (const auto &cancelled : cancelled_at)
+        {
+            const auto when = Clock::time_point(Clock::duration(cancelled.load()));
+            cancel_us.push_back(std::chrono::duration<double, std::micro>(when - trigger_time).count());
+        }
+    }
+    estop.reset();
+
+    std::printf("estop triggers %zu ports 2\n", count);
+    printLatency("trigger() call", trigger_us);
+    printLatency("torque-off on bus", bus_us);
+    printLatency("in-flight cancel", cancel_us);
+    return checkRearm() ? 0 : 1;
+}
+
+// Replugs a simulated adapter behind a stable symlink and times ArmLink recovery
+int runReconnect(size_t count)
+{
+    namespace fs = std::filesystem;
+    const fs::path dev_dir = fs::temp_directory_path() / ("perseus-bench-" + std::to_string(::getpid()));
+    fs::create_directories(dev_dir);
+    const fs::path link_path = dev_dir / "ttyACM-sim";
+
+    ST3215Simulator simulator;
+    auto point_link = [&]() {
+        const fs::path tmp = dev_dir / "link.tmp";
+        fs::remove(tmp);
+        fs::create_symlink(simulator.portName(), tmp);
+        fs::rename(tmp, link_path);  // Atomic replace, seen as IN_MOVED_TO
+    };
+    point_link();
+
+    HotplugMonitor monitor(dev_dir.string());
+    std::vector<ServoData> arm_data(6);
+    std::vector<double> recovery_ms;
+    bool ok = true;
+    {
+        ArmLink link(link_path.string(), 1000000, Clock::system(), &monitor);
+        for (size_t i = 0; i < count && ok; ++i)
+        {
+            link.sample(arm_data);
+            simulator.unplug();
+            link.sample(arm_data);
+            if (link.connected())
+            {
+                std::cerr << "Disconnect was not detected" << std::endl;
+                ok = false;
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+            simulator.replug();
+            point_link();
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (std::chrono::steady_clock::now() < deadline)
+            {
+                link.sample(arm_data);
+                if (link.connected() && arm_data[0].error.empty())
+                {
+                    break;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+            if (!link.connected())
+            {
+                std::cerr << "Link did not recover within 5 s" << std::endl;
+                ok = false;
+                break;
+            }
+            recovery_ms.push_back(std::chrono::duration<double, std::milli>(link.lastRecoveryTime()).count());
+        }
+    }
+    fs::remove_all(dev_dir);
+
+    if (!recovery_ms.empty())
+    {
+        std::sort(recovery_ms.begin(), recovery_ms.end());
+        std::printf("reconnects %zu inotify %s recovery_ms min %.1f p50 %.1f max %.1f\n",
+                    recovery_ms.size(), monitor.active() ? "yes" : "no", recovery_ms.front(),
+                    recovery_ms[recovery_ms.size() / 2], recovery_ms.back());
+    }
+    return ok && !recovery_ms.empty() && recovery_ms.back() < 1000.0 ? 0 : 1;
+}
+
+// Shares one bus between a UI, a recorder and a health monitor, like main() plus its future clients
+int runBus(size_t cycles)
+{
+    ST3215Simulator simulator;
+    ArmLink link(simulator.portName(), 1000000, Clock::system(), nullptr);
+    ServoBus bus(link);
+
+    std::vector<double> control_us;
+    std::atomic<size_t> errors(0);
+    auto client = [&](uint8_t address, uint8_t size, BusPriority priority, std::vector<double> *latencies) {
+        for (size_t cycle = 0; cycle < cycles; ++cycle)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            auto replies = requestJoints(bus, 6, address, size, priority);
+            for (auto &reply : replies)
+            {
+                if (!reply.get().error.empty())
+                {
+                    ++errors;
+                }
+            }
+            if (latencies)
+            {
+                latencies->push_back(
+                    std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+            }
+        }
+    };
+
+    std::thread ui(client, 0x38, 2, BusPriority::CONTROL, &control_us);
+    std::thread recorder(client, 0x38, 2, BusPriority::CONTROL, nullptr);
+    std::thread health(client, 0x3F, 1, BusPriority::DIAGNOSTIC, nullptr);
+    ui.join();
+    recorder.join();
+    health.join();
+
+    const auto stats = bus.stats();
+    std::printf("requests %llu sync_reads %llu (%.1f requests each) cycles %llu deferred %llu errors %zu\n",
+                static_cast<unsigned long long>(stats.requests), static_cast<unsigned long long>(stats.sync_reads),
+                stats.sync_reads ? static_cast<double>(stats.requests) / stats.sync_reads : 0.0,
+                static_cast<unsigned long long>(stats.cycles), static_cast<unsigned long long>(stats.deferred),
+                errors.load());
+    printLatency("control cycle", control_us);
+    return errors == 0 ? 0 : 1;
+}
+
+// Leader stream -> UDP on localhost -> jitter buffer -> follower bus write
+int runStream(size_t frames)
+{
+    ST3215Simulator follower;
+    ArmLink link(follower.portName(), 1000000, Clock::system(), nullptr);
+    ServoBus bus(link);
+    JointStateSubscriber subscriber("127.0.0.1:0");
+    const std::string endpoint = "127.0.0.1:" + std::to_string(subscriber.port());
+    auto publisher = std::make_unique<JointStatePublisher>(endpoint);
+
+    // Sender paced at 100 Hz, like a fast leader loop. Halfway through the
+    // leader restarts, so its sequence starts over under a new session
+    const auto period = std::chrono::milliseconds(10);
+    std::thread sender([&]() {
+        auto next = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < frames; ++i)
+        {
+            if (i > 0 && i == frames / 2)
+            {
+                publisher = std::make_unique<JointStatePublisher>(endpoint);
+            }
+            JointStateFrame frame;
+            frame.arm_count = 1;
+            frame.joint_count = 6;
+            for (size_t j = 0; j < 6; ++j)
+            {
+                frame.positions[j] = static_cast<uint16_t>((1024 + 37 * i + 211 * j) % 4096);
+            }
+            frame.timestamp_ns = wallClockNanoseconds();
+            publisher->publish(frame);
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+    });
+
+    std::vector<double> network_us, end_to_end_us;
+    size_t write_errors = 0;
+    JointStateFrame frame;
+    while (subscriber.receive(frame, std::chrono::milliseconds(500)))
+    {
+        network_us.push_back((wallClockNanoseconds() - frame.timestamp_ns) / 1000.0);
+        std::vector<std::future<ST3215ServoReader::ServoReply>> writes;
+        for (size_t j = 0; j < frame.joint_count; ++j)
+        {
+            const uint8_t goal[2] = {static_cast<uint8_t>(frame.positions[j] & 0xFF),
+                                     static_cast<uint8_t>(frame.positions[j] >> 8)};
+            writes.push_back(bus.write(static_cast<uint8_t>(j + 1), 0x2A, goal, 2));
+        }
+        for (auto &write : writes)
+        {
+            write_errors += write.get().error.empty() ? 0 : 1;
+        }
+        end_to_end_us.push_back((wallClockNanoseconds() - frame.timestamp_ns) / 1000.0);
+    }
+    sender.join();
+
+    // The simulator only reports a goal once the SYNC_WRITE has been parsed
+    const uint16_t expected = static_cast<uint16_t>((1024 + 37 * (frames - 1) + 211 * 5) % 4096);
+    const bool applied = follower.goalPosition(6) == expected;
+
+    const auto stats = subscriber.stats();
+    const uint64_t expected_restarts = frames >= 2 ? 1 : 0;
+    std::printf("frames %zu received %llu played %llu lost %llu late %llu reordered %llu restarts %llu "
+                "write_errors %zu last_goal %s\n",
+                frames, static_cast<unsigned long long>(stats.received),
+                static_cast<unsigned long long>(stats.played), static_cast<unsigned long long>(stats.lost),
+                static_cast<unsigned long long>(stats.late), static_cast<unsigned long long>(stats.reordered),
+                static_cast<unsigned long long>(stats.restarts), write_errors, applied ? "applied" : "MISSING");
+    std::printf("jitter %.1f us playout delay %.1f us sync_writes %llu\n", stats.jitter_us, stats.delay_us,
+                static_cast<unsigned long long>(bus.stats().sync_writes));
+    printLatency("network + buffer", network_us);
+    printLatency("to follower bus", end_to_end_us);
+    const bool restarted_cleanly = stats.late == 0 && stats.restarts == expected_restarts;
+    return stats.played == frames && restarted_cleanly && write_errors == 0 && applied ? 0 : 1;
+}
+
+// Records through every policy into a FIFO drained by a reader that stalls
+// like a congested disk, timing each record() call as the sampling loop sees it
+int runRecord(size_t cycles)
+{
+    const std::string fifo = (std::filesystem::temp_directory_path() /
+                              ("perseus-arm-bench-" + std::to_string(::getpid()) + ".fifo"))
+                                 .string();
+    if (::mkfifo(fifo.c_str(), 0600) != 0)
+    {
+        throw std::runtime_error("Failed to create " + fifo);
+    }
+
+    std::vector<ServoData> arm_data(6);
+    bool ok = true;
+    for (RecordPolicy policy :
+         {RecordPolicy::BLOCK, RecordPolicy::DROP_OLDEST, RecordPolicy::DROP_NEWEST, RecordPolicy::DECIMATE})
+    {
+        // 500 ms stalls every 500 ms against a 1 kHz loop and a 256 record
+        // ring, with the pipe shrunk to a page so it cannot absorb them:
+        // the writer falls behind by far more than the ring holds
+        std::atomic<bool> done(false);
+        std::atomic<uint64_t> received(0);
+        std::thread reader([&]() {
+            const int fd = ::open(fifo.c_str(), O_RDONLY);
+            ::fcntl(fd, F_SETPIPE_SZ, 4096);
+            std::vector<uint8_t> buffer(64 * 1024);
+            auto stall_at = std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+            while (true)
+            {
+                if (std::chrono::steady_clock::now() >= stall_at && !done)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+                    stall_at = std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+                }
+                const ssize_t n = ::read(fd, buffer.data(), buffer.size());
+                if (n <= 0)
+                {
+                    break;
+                }
+                received += static_cast<uint64_t>(n);
+            }
+            ::close(fd);
+        });
+
+        std::vector<double> record_us;
+        record_us.reserve(cycles);
+        Recorder::Stats stats;
+        {
+            Recorder recorder(fifo, policy, 256, 4096);
+            const auto period = std::chrono::milliseconds(1);
+            auto next = std::chrono::steady_clock::now();
+            for (uint64_t cycle = 1; cycle <= cycles; ++cycle)
+            {
+                for (size_t j = 0; j < arm_data.size(); ++j)
+                {
+                    arm_data[j].current = static_cast<uint16_t>((37 * cycle + 211 * j) % 4096);
+                    arm_data[j].sequence = cycle;
+                }
+                const ArmRecord record = makeArmRecord(0, cycle, arm_data, 0, wallClockNanoseconds(),
+                                                       Clock::system().now());
+                const auto start = std::chrono::steady_clock::now();
+                recorder.record(record);
+                record_us.push_back(
+                    std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+                next += period;
+                std::this_thread::sleep_until(next);
+            }
+            done = true;
+            stats = recorder.stats();
+        }
+        reader.join();
+        stats.written = (received.load() - sizeof(RecordingHeader)) / sizeof(ArmRecord);
+
+        const uint64_t accounted =
+            stats.written + stats.dropped_oldest + stats.dropped_newest + stats.decimated;
+        ok = ok && accounted == cycles;
+        std::printf("%-12s written %6llu dropped %6llu decimated %6llu blocked %4llu peak %zu/%zu%s\n",
+                    recordPolicyName(policy), static_cast<unsigned long long>(stats.written),
+                    static_cast<unsigned long long>(stats.dropped_oldest + stats.dropped_newest),
+                    static_cast<unsigned long long>(stats.decimated),
+                    static_cast<unsigned long long>(stats.blocked), stats.high_watermark, stats.capacity,
+                    accounted == cycles ? "" : " UNACCOUNTED");
+        printLatency("  record()", record_us);
+    }
+    ::unlink(fifo.c_str());
+    return ok ? 0 : 1;
+}
+
+// Runs the main acquisition loop against two simulated arms on a virtual clock
+int runSoak(double seconds)
+{
+    VirtualClock clock;
+    ST3215Simulator sim1({1, 2, 3, 4, 5, 6}, clock);
+    ST3215Simulator sim2({1, 2, 3, 4, 5, 6}, clock);
+    ST3215ServoReader reader1(sim1.portName(), 1000000, clock);
+    ST3215ServoReader reader2(sim2.portName(), 1000000, clock);
+    std::vector<ServoData> arm1_data(6);
+    std::vector<ServoData> arm2_data(6);
+
+    const auto virtual_start = clock.now();
+    const auto virtual_end = virtual_start + std::chrono::duration_cast<Clock::duration>(
+                                                 std::chrono::duration<double>(seconds));
+    const auto wall_start = std::chrono::steady_clock::now();
+
+    // FNV-1a over every reading; identical across runs when the session is deterministic
+    uint64_t digest = 1469598103934665603ull;
+    size_t cycles = 0;
+    size_t errors = 0;
+    while (clock.now() < virtual_end)
+    {
+        sampleArm(reader1, arm1_data);
+        sampleArm(reader2, arm2_data);
+        for (const auto *arm : {&arm1_data, &arm2_data})
+        {
+            for (const auto &servo : *arm)
+            {
+                errors += servo.error.empty() ? 0 : 1;
+                digest = (digest ^ servo.current) * 1099511628211ull;
+            }
+        }
+        ++cycles;
+        clock.sleepFor(std::chrono::milliseconds(100));
+    }
+
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+    const double simulated = std::chrono::duration<double>(clock.now() - virtual_start).count();
+    std::printf("simulated_s %.1f wall_s %.3f speedup %.1fx cycles %zu errors %zu digest %016llx\n",
+                simulated, wall, simulated / std::max(wall, 1e-9), cycles, errors,
+                static_cast<unsigned long long>(digest));
+    return errors == 0 ? 0 : 1;
+}
+
+// perseus-armd's pacing with low-power idle, on arms that move, stop and move again
+int runIdle(double seconds)
+{
+    const std::chrono::milliseconds period(5);
+    const std::chrono::milliseconds idle_period(250);
+    Clock &clock = Clock::system();
+    ST3215Simulator sim1;
+    ST3215Simulator sim2;
+    ArmLink link1(sim1.portName(), 1000000, clock, nullptr);
+    ArmLink link2(sim2.portName(), 1000000, clock, nullptr);
+    std::vector<ServoData> arm1_data(6), arm2_data(6);
+    ServoBus bus1(link1);
+    ServoBus bus2(link2);
+    ArmPoller poller1(bus1, arm1_data, 10, clock);
+    ArmPoller poller2(bus2, arm2_data, 10, clock);
+
+    IdleDetector::Config idle_config;
+    idle_config.idle_after = std::chrono::seconds(1);
+    IdleDetector detector(idle_config);
+    UsageMeter usage;
+    std::vector<uint64_t> cycles(2);
+
+    auto setMoving = [&](bool moving) {
+        for (uint8_t id = 1; id <= 6; ++id)
+        {
+            sim1.setMotion(id, 2048, moving ? 400 : 0, std::chrono::milliseconds(2000 + 300 * id));
+            sim2.setMotion(id, 2048, moving ? 400 : 0, std::chrono::milliseconds(2300 + 300 * id));
+        }
+    };
+
+    // Moving, still until well past the idle timeout, then moving again. The
+    // changes come from their own thread so motion starts at an arbitrary
+    // point of a keep-alive sleep, as a hand on the arm would.
+    const auto run_for = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    const auto start = clock.now();
+    const auto resume_at = start + run_for + idle_config.idle_after + run_for + std::chrono::milliseconds(137);
+    const auto end = resume_at + std::chrono::seconds(1);
+    setMoving(true);
+    std::atomic<int64_t> resumed_ns(0);
+    std::thread mover([&]() {
+        clock.sleepFor(start + run_for - clock.now());
+        setMoving(false);
+        clock.sleepFor(resume_at - clock.now());
+        setMoving(true);
+        resumed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(clock.now().time_since_epoch()).count();
+    });
+    bool idle = false;
+    Clock::duration wake_latency{};
+    size_t active_cycles = 0, idle_cycles = 0;
+
+    Clock::time_point next_cycle = clock.now();
+    while (clock.now() < end)
+    {
+        poller1.request();
+        poller2.request();
+        poller1.collect();
+        poller2.collect();
+        cycles[0] = poller1.cycle();
+        cycles[1] = poller2.cycle();
+        const Clock::time_point now = clock.now();
+        detector.observe({&arm1_data, &arm2_data}, cycles, now);
+        const bool was_idle = idle;
+        idle = detector.idle(now);
+        if (was_idle && !idle && resumed_ns != 0 && wake_latency == Clock::duration())
+        {
+            wake_latency = now - Clock::time_point(std::chrono::nanoseconds(resumed_ns.load()));
+        }
+        usage.sample(idle, {&bus1, &bus2});
+        ++(idle ? idle_cycles : active_cycles);
+
+        next_cycle += idle ? std::chrono::duration_cast<Clock::duration>(idle_period) : period;
+        const Clock::time_point after = clock.now();
+        if (next_cycle < after)
+        {
+            next_cycle = after;
+        }
+        clock.sleepFor(next_cycle - after);
+    }
+    mover.join();
+
+    for (bool state : {false, true})
+    {
+        std::printf("%-6s %6.1f s cycles %6zu CPU %5.2f%% bus %5.2f%%\n", state ? "idle" : "active",
+                    usage.seconds(state), state ? idle_cycles : active_cycles, usage.cpuPercent(state),
+                    usage.busPercent(state));
+    }
+    std::printf("motion to full rate %.1f ms (keep-alive period %lld ms)\n",
+                std::chrono::duration<double, std::milli>(wake_latency).count(),
+                static_cast<long long>(idle_period.count()));
+    return usage.seconds(true) > 0.0 && wake_latency != Clock::duration() ? 0 : 1;
+}
+
+// Runs op `iterations` times, each call performing `ops_per_call` operations
+RegionResult measureRegion(const std::string &name, const BenchOptions &options,
+                           size_t ops_per_call, const std::function<void()> &op)
+{
+    RegionResult result;
+    result.name = name;
+    result.latencies_us.reserve(options.iterations);
+
+    std::unique_ptr<PerfCounters> counters;
+    if (options.perf)
+    {
+        counters = std::make_unique<PerfCounters>();
+    }
+
+    // Warm up caches and the simulator before measuring
+    op();
+
+    for (size_t i = 0; i < options.iterations; ++i)
+    {
+        if (counters)
+        {
+            counters->start();
+        }
+        auto start = std::chrono::steady_clock::now();
+        op();
+        auto end = std::chrono::steady_clock::now();
+        if (counters)
+        {
+            auto sample = counters->stop();
+            for (size_t e = 0; e < PerfCounters::EVENT_COUNT; ++e)
+            {
+                result.counters.values[e] += sample.values[e];
+                result.counters.valid[e] = sample.valid[e];
+            }
+        }
+        result.latencies_us.push_back(
+            std::chrono::duration<double, std::micro>(end - start).count() / ops_per_call);
+        result.ops += ops_per_call;
+    }
+    return result;
+}
+
+void printResults(const std::vector<RegionResult> &results, bool perf)
+{
+    std::printf("%-10s %10s %12s %12s %12s", "region", "ops", "mean_us", "p50_us", "p99_us");
+    if (perf)
+    {
+        for (size_t e = 0; e < PerfCounters::EVENT_COUNT; ++e)
+        {
+            std::printf(" %12s", PerfCounters::eventName(static_cast<PerfCounters::Event>(e)));
+        }
+        std::printf(" %6s", "ipc");
+    }
+    std::printf("\n");
+
+    for (const auto &result : results)
+    {
+        auto sorted = result.latencies_us;
+        std::sort(sorted.begin(), sorted.end());
+        double mean = 0.0;
+        for (double v : sorted)
+        {
+            mean += v;
+        }
+        mean /= std::max<size_t>(sorted.size(), 1);
+        double p50 = sorted.empty() ? 0.0 : sorted[sorted.size() / 2];
+        double p99 = sorted.empty() ? 0.0 : sorted[std::min(sorted.size() - 1, sorted.size() * 99 / 100)];
+
+        std::printf("%-10s %10zu %12.3f %12.3f %12.3f", result.name.c_str(), result.ops, mean, p50, p99);
+        if (perf)
+        {
+            // Counters are reported per operation, next to latency
+            for (size_t e = 0; e < PerfCounters::EVENT_COUNT; ++e)
+            {
+                if (result.counters.valid[e])
+                {
+                    std::printf(" %12.1f", static_cast<double>(result.counters.values[e]) / result.ops);
+                }
+                else
+                {
+                    std::printf(" %12s", "n/a");
+                }
+            }
+            const auto &c = result.counters;
+            if (c.valid[PerfCounters::CYCLES] && c.valid[PerfCounters::INSTRUCTIONS] &&
+                c.values[PerfCounters::CYCLES] > 0)
+            {
+                std::printf(" %6.2f", static_cast<double>(c.values[PerfCounters::INSTRUCTIONS]) /
+                                          c.values[PerfCounters::CYCLES]);
+            }
+            else
+            {
+                std::printf(" %6s", "n/a");
+            }
+        }
+        std::printf("\n");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--perf")
+        {
+            options.perf = true;
+        }
+        else if (arg == "--iterations" && i + 1 < argc)
+        {
+            options.iterations = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "--reconnect" && i + 1 < argc)
+        {
+            options.reconnects = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        }
+        else if (arg == "--estop" && i + 1 < argc)
+        {
+            options.estops = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        }
+        else if (arg == "--bus" && i + 1 < argc)
+        {
+            options.bus_cycles = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        }
+        else if (arg == "--stream" && i + 1 < argc)
+        {
+            options.stream_frames = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        }
+        else if (arg == "--record" && i + 1 < argc)
+        {
+            options.records = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        }
+        else if (arg == "--idle" && i + 1 < argc)
+        {
+            options.idle_seconds = std::atof(argv[++i]);
+        }
+        else if (arg == "--soak" && i + 1 < argc)
+        {
+            options.soak_seconds = std::atof(argv[++i]);
+        }
+        else
+        {
+            printUsage(argv[0]);
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    try
+    {
+        if (options.soak_seconds > 0.0)
+        {
+            return runSoak(options.soak_seconds);
+        }
+        if (options.idle_seconds > 0.0)
+        {
+            return runIdle(options.idle_seconds);
+        }
+        if (options.reconnects > 0)
+        {
+            return runReconnect(options.reconnects);
+        }
+        if (options.estops > 0)
+        {
+            return runEmergencyStop(options.estops);
+        }
+        if (options.bus_cycles > 0)
+        {
+            return runBus(options.bus_cycles);
+        }
+        if (options.stream_frames > 0)
+        {
+            return runStream(options.stream_frames);
+        }
+        if (options.records > 0)
+        {
+            return runRecord(options.records);
+        }
+
+        if (options.perf && !PerfCounters().available())
+        {
+            std::cerr << "Warning: perf_event_open unavailable, counters will read n/a "
+                      << "(check /proc/sys/kernel/perf_event_paranoid)" << std::endl;
+        }
+
+        std::vector<RegionResult> results;
+
+        // Full 6 joint sweep through the real serial path against the simulator
+        {
+            ST3215Simulator simulator;
+            ST3215ServoReader reader(simulator.portName(), 1000000);
+            results.push_back(measureRegion("sweep", options, 6, [&]() {
+                for (uint8_t id = 1; id <= 6; ++id)
+                {
+                    reader.readPosition(id);
+                }
+            }));
+        }
+
+        // Reply decoding alone, batched so timer overhead does not dominate
+        {
+            const size_t batch = 1000;
+            const uint8_t reply[] = {0xFF, 0xFF, 0x03, 0x04, 0x00, 0x2A, 0x08, 0xC6};
+            volatile uint16_t sink = 0;
+            results.push_back(measureRegion("parse", options, batch, [&]() {
+                for (size_t i = 0; i < batch; ++i)
+                {
+                    sink = ST3215ServoReader::parsePositionResponse(reply, sizeof(reply), 0x03);
+                }
+            }));
+        }
+
+        // One displayServoValues frame per renderer, drawn to a temporary file so the bytes can be counted
+        std::vector<std::pair<std::string, double>> frame_bytes;
+        {
+            FILE *out = std::tmpfile();
+            FILE *in = std::fopen("/dev/null", "r");
+            auto measureFrames = [&](const std::string &name, Display &display) {
+                std::vector<ServoData> arm1_data(6), arm2_data(6);
+                uint16_t tick = 0;
+                results.push_back(measureRegion(name, options, 1, [&]() {
+                    for (size_t i = 0; i < 6; ++i)
+                    {
+                        arm1_data[i].current = static_cast<uint16_t>((tick + 97 * i) % 4096);
+                        arm2_data[i].current = static_cast<uint16_t>((tick + 211 * i) % 4096);
+                        arm1_data[i].min = std::min(arm1_data[i].min, arm1_data[i].current);
+                        arm1_data[i].max = std::max(arm1_data[i].max, arm1_data[i].current);
+                        arm2_data[i].min = std::min(arm2_data[i].min, arm2_data[i].current);
+                        arm2_data[i].max = std::max(arm2_data[i].max, arm2_data[i].current);
+                    }
+                    tick += 37;
+                    displayServoValues(display, arm1_data, arm2_data);
+                }));
+                frame_bytes.emplace_back(name, display.averageFrameBytes());
+            };
+            if (out && in)
+            {
+                try
+                {
+                    CursesDisplay display("xterm", out, in);
+                    measureFrames("frame", display);
+                }
+                catch (const std::exception &e)
+                {
+                    std::cerr << "Skipping frame region: " << e.what() << std::endl;
+                }
+                AnsiDisplay display(fileno(out), fileno(in));
+                measureFrames("ansi", display);
+            }
+            if (out)
+            {
+                std::fclose(out);
+            }
+            if (in)
+            {
+                std::fclose(in);
+            }
+        }
+
+        printResults(results, options.perf);
+        for (const auto &[name, bytes] : frame_bytes)
+        {
+            std::printf("%s: %.0f bytes per frame\n", name.c_str(), bytes);
+        }
+        return 0;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
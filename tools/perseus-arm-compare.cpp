@@ -0,0 +1,218 @@
+#include "block-runner.hpp"
+#include "recorder.hpp"
+#include "trajectory-compare.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Compares the joint trajectories of two recordings, e.g. a leader and the
+// follower replaying it, with timing differences warped out by DTW
+
+struct CompareOptions
+{
+    double band_ms = 500.0;
+    double rate_hz = 0.0;
+    size_t threads = 0;
+    std::vector<std::string> recordings;
+};
+
+// One side of a comparison: an arm of a recording
+struct Trajectory
+{
+    std::string name;
+    std::unique_ptr<RecordingFile> file;
+    size_t arm = 0;
+    std::vector<JointTrack> tracks;
+};
+
+// Two trajectories resampled onto the same grid over the time both cover
+struct Episode
+{
+    const Trajectory* a;
+    const Trajectory* b;
+    int64_t start_ns = 0;
+    int64_t period_ns = 0;
+    size_t samples = 0;
+    size_t band = 0;
+    size_t joints = 0;
+};
+
+void printUsage(const char *argv0)
+{
+    std::cout << "Usage: " << argv0 << " [options] A[:ARM] B[:ARM] [A2[:ARM] B2[:ARM] ...]\n"
+              << "Compares arm ARM (default 1) of recording A with that of B, per joint.\n"
+              << "  --band-ms N      Largest timing difference a match may have (default 500)\n"
+              << "  --rate-hz R      Resampling rate (default: the record rate of A)\n"
+              << "  --threads N      Worker threads (default: one per core)\n";
+}
+
+// "file.rec:2" -> file.rec, arm index 1; "file.rec" -> arm index 0
+std::unique_ptr<Trajectory> openTrajectory(const std::string& spec)
+{
+    auto trajectory = std::make_unique<Trajectory>();
+    trajectory->name = spec;
+    std::string path = spec;
+    const size_t colon = spec.rfind(':');
+    if (colon != std::string::npos && colon + 1 < spec.size() &&
+        spec.find_first_not_of("0123456789", colon + 1) == std::string::npos)
+    {
+        path = spec.substr(0, colon);
+        trajectory->arm = static_cast<size_t>(std::max(1, std::atoi(spec.c_str() + colon + 1)) - 1);
+    }
+    trajectory->file = std::make_unique<RecordingFile>(path);
+    trajectory->tracks = extractJointTracks(*trajectory->file, trajectory->arm);
+    if (trajectory->tracks.empty())
+    {
+        throw std::runtime_error("No records for arm " + std::to_string(trajectory->arm + 1) + " in " + path);
+    }
+    return trajectory;
+}
+
+Episode makeEpisode(const Trajectory& a, const Trajectory& b, const CompareOptions& options)
+{
+    Episode episode;
+    episode.a = &a;
+    episode.b = &b;
+    episode.joints = std::min(a.tracks.size(), b.tracks.size());
+
+    // Only the stretch both recordings cover can be compared
+    int64_t start = INT64_MIN;
+    int64_t end = INT64_MAX;
+    for (const auto* trajectory : {&a, &b})
+    {
+        for (size_t j = 0; j < episode.joints; ++j)
+        {
+            const auto& times = trajectory->tracks[j].time_ns;
+            if (times.empty())
+            {
+                throw std::runtime_error("Joint " + std::to_string(j + 1) + " never read in " + trajectory->name);
+            }
+            start = std::max(start, times.front());
+            end = std::min(end, times.back());
+        }
+    }
+    if (end <= start)
+    {
+        throw std::runtime_error(a.name + " and " + b.name + " do not overlap in time");
+    }
+
+    episode.period_ns = options.rate_hz > 0.0 ? static_cast<int64_t>(1e9 / options.rate_hz)
+                                              : typicalRecordPeriod(*a.file, a.arm);
+    if (episode.period_ns <= 0)
+    {
+        throw std::runtime_error("Cannot tell the record rate of " + a.name + "; pass --rate-hz");
+    }
+    episode.start_ns = start;
+    episode.samples = static_cast<size_t>((end - start) / episode.period_ns) + 1;
+    episode.band = static_cast<size_t>(options.band_ms * 1e6 / episode.period_ns);
+    return episode;
+}
+
+int main(int argc, char *argv[])
+{
+    CompareOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--band-ms" && i + 1 < argc)
+        {
+            options.band_ms = std::max(0.0, std::atof(argv[++i]));
+        }
+        else if (arg == "--rate-hz" && i + 1 < argc)
+        {
+            options.rate_hz = std::atof(argv[++i]);
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            options.threads = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        }
+        else if (arg.rfind("--", 0) == 0)
+        {
+            printUsage(argv[0]);
+            return arg == "--help" ? 0 : 1;
+        }
+        else
+        {
+            options.recordings.push_back(arg);
+        }
+    }
+    if (options.recordings.empty() || options.recordings.size() % 2 != 0)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        std::vector<std::unique_ptr<Trajectory>> trajectories;
+        std::vector<Episode> episodes;
+        for (const auto& spec : options.recordings)
+        {
+            trajectories.push_back(openTrajectory(spec));
+        }
+        for (size_t t = 0; t < trajectories.size(); t += 2)
+        {
+            episodes.push_back(makeEpisode(*trajectories[t], *trajectories[t + 1], options));
+        }
+
+        // One block per joint of each episode
+        std::vector<std::pair<size_t, size_t>> blocks;
+        for (size_t e = 0; e < episodes.size(); ++e)
+        {
+            for (size_t j = 0; j < episodes[e].joints; ++j)
+            {
+                blocks.emplace_back(e, j);
+            }
+        }
+
+        BlockRunner runner(options.threads);
+        const std::vector<DtwResult> results = runner.run(
+            blocks.size(), std::vector<DtwResult>(),
+            [&](size_t block, ScratchArena& scratch) {
+                const Episode& episode = episodes[blocks[block].first];
+                const size_t joint = blocks[block].second;
+                float* a = scratch.allocateArray<float>(episode.samples);
+                float* b = scratch.allocateArray<float>(episode.samples);
+                resampleTrack(episode.a->tracks[joint], episode.start_ns, episode.period_ns, episode.samples, a);
+                resampleTrack(episode.b->tracks[joint], episode.start_ns, episode.period_ns, episode.samples, b);
+                return bandedDtw(a, b, episode.samples, episode.band, scratch);
+            },
+            [](std::vector<DtwResult>& all, DtwResult&& result) { all.push_back(result); });
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        size_t cells = 0;
+        for (size_t block = 0; block < blocks.size(); ++block)
+        {
+            const Episode& episode = episodes[blocks[block].first];
+            const size_t joint = blocks[block].second;
+            if (joint == 0)
+            {
+                std::printf("%s vs %s: %zu samples at %.1f Hz, band +/-%.0f ms\n", episode.a->name.c_str(),
+                            episode.b->name.c_str(), episode.samples, 1e9 / episode.period_ns,
+                            episode.band * episode.period_ns / 1e6);
+                std::printf("  %-5s %12s %12s %10s %8s\n", "joint", "direct_diff", "dtw_cost", "lag_ms", "path");
+            }
+            const DtwResult& result = results[block];
+            std::printf("  %-5zu %12.1f %12.1f %10.1f %8zu\n", joint + 1, result.direct_cost, result.cost,
+                        result.mean_lag * episode.period_ns / 1e6, result.path_length);
+            cells += episode.samples * (2 * episode.band + 1);
+        }
+        std::printf("%zu joint(s) in %.3f s on %zu thread(s), %.0f M cells/s\n", blocks.size(), seconds,
+                    runner.threads(), cells / 1e6 / std::max(seconds, 1e-9));
+        return 0;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
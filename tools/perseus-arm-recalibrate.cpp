@@ -0,0 +1,212 @@
+#include "block-runner.hpp"
+#include "calibration.hpp"
+#include "range-estimator.hpp"
+#include "recorder.hpp"
+#include "servo-data.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Recomputes calibration ranges offline from recordings made with --record,
+// so different outlier rules can be tried without sweeping the arms again
+
+const size_t ARM_COUNT = 2;
+const size_t JOINT_COUNT = ArmRecord::MAX_JOINTS;
+
+// Large enough that per-block setup and the merge vanish next to the scan,
+// small enough that every core gets several blocks to balance on
+const size_t BLOCK_RECORDS = 256 * 1024;
+
+struct RecalibrateOptions
+{
+    uint16_t glitch_threshold = 256;
+    double tail = 0.005;
+    size_t threads = 0;
+    std::string output;
+    std::vector<std::string> ports;
+    std::vector<std::string> recordings;
+};
+
+// Everything accumulated over one block; merged into a single one at the end
+struct Accumulator
+{
+    std::vector<std::vector<ServoData>> raw;
+    std::vector<std::vector<RangeEstimator>> ranges;
+    uint64_t records = 0;
+    uint64_t invalid = 0;
+
+    explicit Accumulator(const RecalibrateOptions& options)
+        : raw(ARM_COUNT, std::vector<ServoData>(JOINT_COUNT)),
+          ranges(ARM_COUNT,
+                 std::vector<RangeEstimator>(JOINT_COUNT, RangeEstimator(options.glitch_threshold, options.tail)))
+    {
+    }
+};
+
+void printUsage(const char *argv0)
+{
+    std::cout << "Usage: " << argv0 << " [options] RECORDING...\n"
+              << "  --glitch N       Jump between consecutive readings that must be confirmed\n"
+              << "                   by the next one (default 256)\n"
+              << "  --tail F         Fraction of readings ignored at each end of a range\n"
+              << "                   (default 0.005)\n"
+              << "  --threads N      Worker threads (default: one per core)\n"
+              << "  --ports P1 P2    Ports to record in the calibration file\n"
+              << "  --output FILE    Calibration file to write (default: a new timestamped\n"
+              << "                   file in the current directory)\n";
+}
+
+void scan(const RecordBlock& block, Accumulator& accumulator)
+{
+    for (const ArmRecord* record = block.begin; record != block.end; ++record)
+    {
+        ++accumulator.records;
+        if (record->arm >= ARM_COUNT)
+        {
+            continue;
+        }
+        auto& raw = accumulator.raw[record->arm];
+        auto& ranges = accumulator.ranges[record->arm];
+        const size_t joints = std::min<size_t>(record->joint_count, JOINT_COUNT);
+        for (size_t j = 0; j < joints; ++j)
+        {
+            const uint16_t position = record->positions[j];
+            if (position == ArmRecord::INVALID_POSITION)
+            {
+                ++accumulator.invalid;
+                continue;
+            }
+            raw[j].min = std::min(raw[j].min, position);
+            raw[j].max = std::max(raw[j].max, position);
+            ranges[j].add(position);
+        }
+    }
+}
+
+void merge(Accumulator& into, const Accumulator& from)
+{
+    for (size_t arm = 0; arm < ARM_COUNT; ++arm)
+    {
+        for (size_t j = 0; j < JOINT_COUNT; ++j)
+        {
+            into.raw[arm][j].min = std::min(into.raw[arm][j].min, from.raw[arm][j].min);
+            into.raw[arm][j].max = std::max(into.raw[arm][j].max, from.raw[arm][j].max);
+            into.ranges[arm][j].merge(from.ranges[arm][j]);
+        }
+    }
+    into.records += from.records;
+    into.invalid += from.invalid;
+}
+
+void printSummary(const Accumulator& total)
+{
+    std::printf("%-5s %-5s %10s %8s %6s %6s %6s %6s %6s %6s %6s %8s\n", "arm", "joint", "samples", "rejected",
+                "min", "p1", "low", "p50", "high", "p99", "max", "coverage");
+    for (size_t arm = 0; arm < ARM_COUNT; ++arm)
+    {
+        for (size_t j = 0; j < JOINT_COUNT; ++j)
+        {
+            const RangeEstimator& range = total.ranges[arm][j];
+            std::printf("%-5zu %-5zu %10llu %8llu %6u %6u %6u %6u %6u %6u %6u %7.1f%%\n", arm + 1, j + 1,
+                        static_cast<unsigned long long>(range.samples()),
+                        static_cast<unsigned long long>(range.rejected()), range.min(), range.quantile(0.01),
+                        range.low(), range.quantile(0.5), range.high(), range.quantile(0.99), range.max(),
+                        100.0 * range.coveredBins() / RangeEstimator::BIN_COUNT);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    RecalibrateOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--glitch" && i + 1 < argc)
+        {
+            options.glitch_threshold = static_cast<uint16_t>(std::clamp(std::atoi(argv[++i]), 1, 4095));
+        }
+        else if (arg == "--tail" && i + 1 < argc)
+        {
+            options.tail = std::atof(argv[++i]);
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            options.threads = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        }
+        else if (arg == "--ports" && i + 2 < argc)
+        {
+            options.ports = {argv[i + 1], argv[i + 2]};
+            i += 2;
+        }
+        else if (arg == "--output" && i + 1 < argc)
+        {
+            options.output = argv[++i];
+        }
+        else if (arg.rfind("--", 0) == 0)
+        {
+            printUsage(argv[0]);
+            return arg == "--help" ? 0 : 1;
+        }
+        else
+        {
+            options.recordings.push_back(arg);
+        }
+    }
+    if (options.recordings.empty())
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        std::vector<std::unique_ptr<RecordingFile>> files;
+        std::vector<const RecordingFile*> views;
+        size_t bytes = 0;
+        for (const auto& path : options.recordings)
+        {
+            files.push_back(std::make_unique<RecordingFile>(path));
+            views.push_back(files.back().get());
+            bytes += files.back()->bytes();
+        }
+        const std::vector<RecordBlock> blocks = splitRecordings(views, BLOCK_RECORDS);
+
+        BlockRunner runner(options.threads);
+        const Accumulator total = runner.run(
+            blocks.size(), Accumulator(options),
+            [&](size_t block, ScratchArena&) {
+                Accumulator partial(options);
+                scan(blocks[block], partial);
+                return partial;
+            },
+            [](Accumulator& into, Accumulator&& from) { merge(into, from); });
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        printSummary(total);
+        std::printf("%llu records (%llu invalid readings) from %zu file(s), %.1f MB in %.3f s on %zu thread(s), "
+                    "%.0f MB/s, %llu block(s) stolen\n",
+                    static_cast<unsigned long long>(total.records), static_cast<unsigned long long>(total.invalid),
+                    files.size(), bytes / 1e6, seconds, runner.threads(), bytes / 1e6 / std::max(seconds, 1e-9),
+                    static_cast<unsigned long long>(runner.stats().steals));
+
+        const std::string timestamp = calibrationTimestamp();
+        const std::string output = options.output.empty() ? calibrationFileName(timestamp) : options.output;
+        writeCalibrationFile(output, timestamp, options.ports, {&total.raw[0], &total.raw[1]},
+                             {&total.ranges[0], &total.ranges[1]});
+        std::cout << "Calibration data exported to: " << output << std::endl;
+        return 0;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
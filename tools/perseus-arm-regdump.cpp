@@ -0,0 +1,384 @@
+#include "perseus-arm-teleop.hpp"
+#include "realtime.hpp"
+#include "serial-ports.hpp"
+#include "servo-simulator.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Reads the register map of every servo on every port, one thread per port,
+// and diffs the EEPROM settings against a golden snapshot
+
+// Registers 0x00-0x46: the EEPROM settings and the RAM control and status block
+const uint8_t MAP_SIZE = 0x47;
+
+struct Register
+{
+    uint8_t address;
+    uint8_t size;
+    const char *name;
+    bool per_servo;   // Differs between healthy servos, compared only with --strict
+};
+
+// The EEPROM part of the map, the settings a firmware audit cares about
+const Register EEPROM_REGISTERS[] = {
+    {0x00, 1, "firmware major", false},
+    {0x01, 1, "firmware minor", false},
+    {0x03, 1, "servo major", false},
+    {0x04, 1, "servo minor", false},
+    {0x05, 1, "ID", true},
+    {0x06, 1, "baud rate", false},
+    {0x07, 1, "return delay", false},
+    {0x08, 1, "status return level", false},
+    {0x09, 2, "min angle limit", false},
+    {0x0B, 2, "max angle limit", false},
+    {0x0D, 1, "max temperature", false},
+    {0x0E, 1, "max voltage", false},
+    {0x0F, 1, "min voltage", false},
+    {0x10, 2, "max torque", false},
+    {0x12, 1, "phase", false},
+    {0x13, 1, "unloading condition", false},
+    {0x14, 1, "LED alarm condition", false},
+    {0x15, 1, "position P", false},
+    {0x16, 1, "position D", false},
+    {0x17, 1, "position I", false},
+    {0x18, 2, "min startup force", false},
+    {0x1A, 1, "CW dead zone", false},
+    {0x1B, 1, "CCW dead zone", false},
+    {0x1C, 2, "protection current", false},
+    {0x1E, 1, "angular resolution", false},
+    {0x1F, 2, "position offset", true},
+    {0x21, 1, "operating mode", false},
+    {0x22, 1, "protective torque", false},
+    {0x23, 1, "protection time", false},
+    {0x24, 1, "overload torque", false},
+    {0x25, 1, "speed P", false},
+    {0x26, 1, "overcurrent protection time", false},
+    {0x27, 1, "velocity I", false},
+};
+
+struct DumpOptions
+{
+    size_t simulated = 0;
+    std::vector<uint8_t> ids = {1, 2, 3, 4, 5, 6};
+    std::string out_path;
+    std::string golden_path;
+    bool strict = false;
+    std::vector<std::string> ports;
+};
+
+// One servo's registers, or why they could not be read
+struct ServoMap
+{
+    std::string port;
+    uint8_t id = 0;
+    std::vector<uint8_t> registers;   // MAP_SIZE bytes, empty if error is set
+    std::string error;
+};
+
+void printUsage(const char *argv0)
+{
+    std::cout << "Usage: " << argv0 << " [options] [PORT...]\n"
+              << "Reads registers 0x00-0x46 of every servo on every port (default: all found).\n"
+              << "Exits with 2 if a servo could not be read or differs from the golden profile.\n"
+              << "  --ids LIST       Servo IDs on each port, e.g. 1-6 or 1,3,5 (default 1-6)\n"
+              << "  --out FILE       Write the snapshot to FILE (default: stdout unless diffing)\n"
+              << "  --golden FILE    Diff the EEPROM settings against a snapshot of a known-good arm\n"
+              << "  --strict         Also diff per-servo settings (ID, position offset)\n"
+              << "  --sim N          Read N simulated arms instead of serial ports\n";
+}
+
+// Every servo on one port: one SYNC_READ for all of them, then a retried
+// single read for any that missed it
+std::vector<ServoMap> dumpPort(const std::string &port, const std::vector<uint8_t> &ids)
+{
+    std::vector<ServoMap> maps(ids.size());
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+        maps[i].port = port;
+        maps[i].id = ids[i];
+    }
+    try
+    {
+        ST3215ServoReader reader(port, 1000000);
+        const auto replies = reader.syncRead(ids, 0x00, MAP_SIZE);
+        for (size_t i = 0; i < ids.size(); ++i)
+        {
+            if (i < replies.size() && replies[i].error.empty() && replies[i].data.size() == MAP_SIZE)
+            {
+                maps[i].registers = replies[i].data;
+                continue;
+            }
+            try
+            {
+                maps[i].registers = reader.readRegisters(ids[i], 0x00, MAP_SIZE);
+            }
+            catch (const std::exception &e)
+            {
+                maps[i].error = e.what();
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+        for (auto &map : maps)
+        {
+            map.error = e.what();
+        }
+    }
+    return maps;
+}
+
+// "<port> <id> <hex registers>" per servo, or "<port> <id> error <message>"
+void writeSnapshot(std::ostream &out, const std::vector<ServoMap> &maps)
+{
+    out << "# perseus-arm-regdump registers 0x00-0x" << std::hex << static_cast<int>(MAP_SIZE - 1) << std::dec
+        << "\n";
+    for (const auto &map : maps)
+    {
+        out << map.port << " " << static_cast<int>(map.id) << " ";
+        if (!map.error.empty())
+        {
+            out << "error " << map.error << "\n";
+            continue;
+        }
+        char hex[3];
+        for (uint8_t byte : map.registers)
+        {
+            std::snprintf(hex, sizeof(hex), "%02x", byte);
+            out << hex;
+        }
+        out << "\n";
+    }
+}
+
+std::vector<ServoMap> readSnapshot(const std::string &path)
+{
+    std::ifstream in(path);
+    if (!in)
+    {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    std::vector<ServoMap> maps;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+        std::istringstream fields(line);
+        ServoMap map;
+        int id = 0;
+        std::string hex;
+        if (!(fields >> map.port >> id >> hex) || id < 0 || id > 253)
+        {
+            throw std::runtime_error("Malformed line in " + path + ": " + line);
+        }
+        map.id = static_cast<uint8_t>(id);
+        if (hex == "error")
+        {
+            continue;
+        }
+        if (hex.size() != 2u * MAP_SIZE || hex.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos)
+        {
+            throw std::runtime_error("Malformed registers in " + path + ": " + line);
+        }
+        for (size_t i = 0; i < hex.size(); i += 2)
+        {
+            map.registers.push_back(static_cast<uint8_t>(std::stoi(hex.substr(i, 2), nullptr, 16)));
+        }
+        maps.push_back(std::move(map));
+    }
+    return maps;
+}
+
+uint32_t registerValue(const std::vector<uint8_t> &registers, const Register &reg)
+{
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < reg.size; ++i)
+    {
+        value |= static_cast<uint32_t>(registers[reg.address + i]) << (8 * i);
+    }
+    return value;
+}
+
+// Golden servos are matched by ID, the first of each ID in the file, so one
+// known-good arm serves as the profile for every arm in the fleet
+size_t diffSnapshot(const std::vector<ServoMap> &maps, const std::vector<ServoMap> &golden, bool strict)
+{
+    std::map<uint8_t, const ServoMap *> reference;
+    for (const auto &map : golden)
+    {
+        reference.emplace(map.id, &map);
+    }
+
+    size_t differences = 0;
+    for (const auto &map : maps)
+    {
+        if (!map.error.empty())
+        {
+            std::printf("%s id %d: not read: %s\n", map.port.c_str(), map.id, map.error.c_str());
+            ++differences;
+            continue;
+        }
+        const auto found = reference.find(map.id);
+        if (found == reference.end())
+        {
+            std::printf("%s id %d: no golden servo with this ID\n", map.port.c_str(), map.id);
+            ++differences;
+            continue;
+        }
+        for (const Register &reg : EEPROM_REGISTERS)
+        {
+            if (reg.per_servo && !strict)
+            {
+                continue;
+            }
+            const uint32_t expected = registerValue(found->second->registers, reg);
+            const uint32_t actual = registerValue(map.registers, reg);
+            if (expected != actual)
+            {
+                std::printf("%s id %d: 0x%02x %s: golden %u, actual %u\n", map.port.c_str(), map.id, reg.address,
+                            reg.name, expected, actual);
+                ++differences;
+            }
+        }
+    }
+    return differences;
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        DumpOptions options;
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            if (arg == "--ids" && i + 1 < argc)
+            {
+                options.ids.clear();
+                for (int id : parseIndexList(argv[++i], 254))
+                {
+                    options.ids.push_back(static_cast<uint8_t>(id));
+                }
+            }
+            else if (arg == "--out" && i + 1 < argc)
+            {
+                options.out_path = argv[++i];
+            }
+            else if (arg == "--golden" && i + 1 < argc)
+            {
+                options.golden_path = argv[++i];
+            }
+            else if (arg == "--strict")
+            {
+                options.strict = true;
+            }
+            else if (arg == "--sim" && i + 1 < argc)
+            {
+                options.simulated = static_cast<size_t>(std::max(1, std::stoi(argv[++i])));
+            }
+            else if (arg == "--help")
+            {
+                printUsage(argv[0]);
+                return 0;
+            }
+            else if (arg.rfind("--", 0) == 0)
+            {
+                printUsage(argv[0]);
+                return 1;
+            }
+            else
+            {
+                options.ports.push_back(arg);
+            }
+        }
+
+        // Load the golden profile first so a bad path fails before any bus traffic
+        std::vector<ServoMap> golden;
+        if (!options.golden_path.empty())
+        {
+            golden = readSnapshot(options.golden_path);
+        }
+
+        std::vector<std::unique_ptr<ST3215Simulator>> simulators;
+        if (options.simulated > 0)
+        {
+            options.ports.clear();
+            for (size_t i = 0; i < options.simulated; ++i)
+            {
+                simulators.push_back(std::make_unique<ST3215Simulator>(options.ids));
+                options.ports.push_back(simulators.back()->portName());
+            }
+        }
+        else if (options.ports.empty())
+        {
+            options.ports = findSerialPorts();
+        }
+        if (options.ports.empty())
+        {
+            std::cerr << "No serial ports found" << std::endl;
+            return 1;
+        }
+
+        // Each port is its own bus, so they are all read at once
+        const auto started = std::chrono::steady_clock::now();
+        std::vector<std::future<std::vector<ServoMap>>> ports;
+        for (const auto &port : options.ports)
+        {
+            ports.push_back(std::async(std::launch::async, dumpPort, port, options.ids));
+        }
+        std::vector<ServoMap> maps;
+        size_t failed = 0;
+        for (auto &port : ports)
+        {
+            for (auto &map : port.get())
+            {
+                failed += !map.error.empty();
+                maps.push_back(std::move(map));
+            }
+        }
+        const double elapsed_ms =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+        std::fprintf(stderr, "Read %zu servos on %zu ports in %.0f ms, %zu failed\n", maps.size(),
+                     options.ports.size(), elapsed_ms, failed);
+
+        if (!options.out_path.empty())
+        {
+            std::ofstream out(options.out_path);
+            writeSnapshot(out, maps);
+            if (!out)
+            {
+                throw std::runtime_error("Failed to write " + options.out_path);
+            }
+        }
+        else if (options.golden_path.empty())
+        {
+            writeSnapshot(std::cout, maps);
+        }
+
+        if (!options.golden_path.empty())
+        {
+            const size_t differences = diffSnapshot(maps, golden, options.strict);
+            std::printf("%zu differences from %s\n", differences, options.golden_path.c_str());
+            return differences > 0 ? 2 : 0;
+        }
+        return failed > 0 ? 2 : 0;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}